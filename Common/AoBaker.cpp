@@ -0,0 +1,147 @@
+#include "AoBaker.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include "TaskScheduler.h"
+#include "GeometryGenerator.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	float RadicalInverse(UINT bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return static_cast<float>(bits) * 2.3283064365386963e-10f;
+	}
+
+	UINT Hash(UINT x)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352dU;
+		x ^= x >> 15;
+		x *= 0x846ca68bU;
+		x ^= x >> 16;
+		return x;
+	}
+
+	// 법선을 z축으로 하는 정규 직교 기저를 만든다.
+	void MakeBasis(const XMFLOAT3& n, XMFLOAT3& t, XMFLOAT3& b)
+	{
+		float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+		float a = -1.0f / (sign + n.z);
+		float c = n.x * n.y * a;
+		t = XMFLOAT3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+		b = XMFLOAT3(c, sign + n.y * n.y * a, -n.y);
+	}
+}
+
+void AoBaker::AddOccluder(const std::vector<XMFLOAT3>& positions,
+	const std::vector<std::uint32_t>& indices, FXMMATRIX world)
+{
+	auto base = static_cast<std::uint32_t>(mScenePositions.size());
+	for (auto& p : positions)
+	{
+		XMFLOAT3 posW;
+		XMStoreFloat3(&posW, XMVector3TransformCoord(XMLoadFloat3(&p), world));
+		mScenePositions.emplace_back(posW);
+	}
+
+	for (auto idx : indices)
+		mSceneIndices.emplace_back(base + idx);
+}
+
+void AoBaker::Build()
+{
+	mSceneBvh.Build(mScenePositions, mSceneIndices);
+}
+
+float AoBaker::Accessibility(FXMVECTOR posW, FXMVECTOR normalW, UINT seed, const Desc& desc) const
+{
+	XMFLOAT3 n, t, b;
+	XMStoreFloat3(&n, XMVector3Normalize(normalW));
+	MakeBasis(n, t, b);
+	XMVECTOR T = XMLoadFloat3(&t);
+	XMVECTOR B = XMLoadFloat3(&b);
+	XMVECTOR N = XMLoadFloat3(&n);
+
+	XMVECTOR origin = XMVectorMultiplyAdd(XMVectorReplicate(desc.Bias), N, posW);
+
+	// 정점마다 해머슬리 점 집합을 다르게 밀어서 정점 사이에 같은 줄무늬가 생기지 않게 한다.
+	UINT h = Hash(seed);
+	float shiftU = (h & 0xFFFF) / 65536.0f;
+	float shiftV = (h >> 16) / 65536.0f;
+
+	UINT unoccluded = 0;
+	for (auto i : Range(0, desc.SampleCount))
+	{
+		float u = (i + 0.5f) / desc.SampleCount + shiftU;
+		float v = RadicalInverse(i) + shiftV;
+		u -= static_cast<int>(u);
+		v -= static_cast<int>(v);
+
+		// 코사인 가중 반구 샘플이므로 가리지 않은 비율이 곧 접근도가 된다.
+		float r = sqrtf(u);
+		float phi = 2.0f * MathHelper::Pi * v;
+		float x = r * cosf(phi);
+		float y = r * sinf(phi);
+		float z = sqrtf(std::max<float>(0.0f, 1.0f - u));
+
+		XMVECTOR dir = x * T + y * B + z * N;
+		if (mSceneBvh.Occluded(origin, dir, desc.MaxDistance) == false)
+			unoccluded++;
+	}
+
+	return static_cast<float>(unoccluded) / desc.SampleCount;
+}
+
+bool AoBaker::SelfCheck(float* openPlaneAo, float* enclosedAo, float tolerance)
+{
+	Desc desc;
+	GeometryGenerator geoGen;
+	auto Measure = [&desc](const GeometryGenerator::MeshData& mesh, FXMVECTOR posW, FXMVECTOR normalW) {
+		std::vector<XMFLOAT3> positions;
+		for (auto& v : mesh.Vertices)
+			positions.emplace_back(v.Position);
+
+		AoBaker baker;
+		baker.AddOccluder(positions, mesh.Indices32, XMMatrixIdentity());
+		baker.Build();
+		return baker.Accessibility(posW, normalW, 0, desc);
+	};
+
+	// 평면 자신만 있으므로 위쪽 반구는 모두 비어 있다.
+	float plane = Measure(geoGen.CreateGrid(10.0f, 10.0f, 4, 4), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	// 상자 중심에서 벽까지는 MaxDistance보다 가까우므로 모든 광선이 가린다.
+	float half = desc.MaxDistance * 0.5f;
+	float box = Measure(geoGen.CreateBox(half, half, half, 0), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+
+	if (openPlaneAo != nullptr) *openPlaneAo = plane;
+	if (enclosedAo != nullptr) *enclosedAo = box;
+	return fabsf(plane - 1.0f) <= tolerance && box <= tolerance;
+}
+
+std::vector<float> AoBaker::Bake(const std::vector<XMFLOAT3>& positions,
+	const std::vector<XMFLOAT3>& normals, FXMMATRIX world, const Desc& desc) const
+{
+	assert(positions.size() == normals.size());
+	assert(desc.SampleCount > 0);
+
+	XMMATRIX normalWorld = MathHelper::InverseTranspose(world);
+
+	std::vector<float> access(positions.size(), 1.0f);
+	ParallelFor(0, static_cast<int>(positions.size()), [&](int i)
+	{
+		XMVECTOR posW = XMVector3TransformCoord(XMLoadFloat3(&positions[i]), world);
+		XMVECTOR normalW = XMVector3TransformNormal(XMLoadFloat3(&normals[i]), normalWorld);
+		access[i] = Accessibility(posW, normalW, static_cast<UINT>(i), desc);
+	});
+
+	return access;
+}
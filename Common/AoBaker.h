@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MeshBvh.h"
+
+// 정적인 메쉬의 정점마다 반구 광선을 쏴서 앰비언트 접근도(1 = 가림 없음)를 미리 구워 둔다.
+// 결과는 정점 하나당 float 하나인 별도 정점 스트림으로 쓰도록 만들었다.
+// 샘플 배치는 정점 번호로만 정해지므로 같은 입력이면 항상 같은 결과가 나온다.
+class AoBaker
+{
+public:
+	struct Desc
+	{
+		UINT SampleCount = 64;
+		float MaxDistance = 2.0f;	// 이보다 먼 가림은 무시한다.
+		float Bias = 0.002f;			// 자기 자신과 바로 부딪히지 않도록 법선 방향으로 띄우는 거리
+	};
+
+public:
+	AoBaker() = default;
+
+	// 가리는 물체로 쓸 메쉬를 월드 공간으로 옮겨 모은다. 모두 넣은 뒤 Build를 부른다.
+	void AddOccluder(const std::vector<DirectX::XMFLOAT3>& positions,
+		const std::vector<std::uint32_t>& indices, DirectX::FXMMATRIX world);
+	void Build();
+
+	// positions, normals는 로컬 공간이고 world로 옮긴 뒤 굽는다. 정점들은 여러 스레드에서 나눠 처리한다.
+	std::vector<float> Bake(const std::vector<DirectX::XMFLOAT3>& positions,
+		const std::vector<DirectX::XMFLOAT3>& normals, DirectX::FXMMATRIX world, const Desc& desc) const;
+
+	// 월드 공간 점 하나의 접근도
+	float Accessibility(DirectX::FXMVECTOR posW, DirectX::FXMVECTOR normalW, UINT seed, const Desc& desc) const;
+
+	const MeshBvh& Scene() const { return mSceneBvh; }
+
+	// 답이 정해진 두 장면으로 굽는 경로를 확인한다. 열린 평면 위의 점은 1, 닫힌 상자 안의 점은 0이어야 한다.
+	// 샘플 배치가 고정이라 항상 같은 값이 나오므로 허용 오차 tolerance 안이면 true.
+	static bool SelfCheck(float* openPlaneAo = nullptr, float* enclosedAo = nullptr, float tolerance = 0.01f);
+
+private:
+	std::vector<DirectX::XMFLOAT3> mScenePositions;
+	std::vector<std::uint32_t> mSceneIndices;
+	MeshBvh mSceneBvh;
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 앱에서 단축키로 한 번 돌리는 벤치마크가 같이 쓰는 시간 재기와 출력 창 보고
+namespace Benchmark
+{
+	// fn을 repeat번 돌리는 데 걸린 시간(ms)
+	template<typename Fn>
+	double MeasureMs(Fn&& fn, int repeat = 1)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < repeat; ++i)
+			fn();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// 한 번씩 따로 잰 시간들의 평균, 99번째 백분위, 최댓값. samples는 정렬된다.
+	struct Distribution
+	{
+		double Mean = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+	};
+
+	inline Distribution Summarize(std::vector<double>& samples)
+	{
+		Distribution result;
+		if (samples.empty())
+			return result;
+
+		std::sort(samples.begin(), samples.end());
+		result.Mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+		result.P99 = samples[samples.size() * 99 / 100];
+		result.Max = samples.back();
+		return result;
+	}
+
+	// 출력 창에 찍을 결과. 숫자는 std::to_wstring으로 붙이고 Print가 줄을 끝내 찍는다.
+	class Report
+	{
+	public:
+		explicit Report(const wchar_t* title) : mText(title) {}
+
+		Report& operator<<(const wchar_t* text) { mText += text; return *this; }
+		Report& operator<<(const std::wstring& text) { mText += text; return *this; }
+
+		template<typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+		Report& operator<<(T value) { mText += std::to_wstring(value); return *this; }
+
+		void Print() const { OutputDebugStringW((mText + L"\n").c_str()); }
+
+	private:
+		std::wstring mText;
+	};
+}
@@ -0,0 +1,84 @@
+#include "BoundsBvh.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr UINT MaxLeafItems = 2;
+	constexpr int MaxTraversalDepth = 64;
+}
+
+void BoundsBvh::Build(const std::vector<BoundingBox>& bounds)
+{
+	mBounds = bounds;
+
+	BvhBuilder::Build(mNodes, mItemIndices, ItemCount(), MaxLeafItems, MaxTraversalDepth,
+		[this](UINT item, XMVECTOR& vMin, XMVECTOR& vMax) {
+			auto& box = mBounds[item];
+			XMVECTOR center = XMLoadFloat3(&box.Center);
+			XMVECTOR extents = XMLoadFloat3(&box.Extents);
+			vMin = XMVectorMin(vMin, center - extents);
+			vMax = XMVectorMax(vMax, center + extents);
+		},
+		[this](UINT item) -> const XMFLOAT3& { return mBounds[item].Center; });
+}
+
+void BoundsBvh::CollectItems(UINT nodeIdx, std::vector<UINT>& items) const
+{
+	const Node& node = mNodes[nodeIdx];
+	if (node.Count == 0)
+	{
+		CollectItems(node.LeftFirst, items);
+		CollectItems(node.LeftFirst + 1, items);
+		return;
+	}
+
+	for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		items.emplace_back(mItemIndices[i]);
+}
+
+void BoundsBvh::Query(const BoundingFrustum& frustum, std::vector<UINT>& items) const
+{
+	if (mNodes.empty())
+		return;
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		UINT nodeIdx = stack[--stackSize];
+		const Node& node = mNodes[nodeIdx];
+
+		BoundingBox box;
+		BoundingBox::CreateFromPoints(box, XMLoadFloat3(&node.BoundsMin), XMLoadFloat3(&node.BoundsMax));
+		ContainmentType containment = frustum.Contains(box);
+		if (containment == DISJOINT)
+			continue;
+
+		if (containment == CONTAINS)
+		{
+			CollectItems(nodeIdx, items);
+			continue;
+		}
+
+		if (node.Count == 0)
+		{
+			assert(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = node.LeftFirst + 1;
+			stack[stackSize++] = node.LeftFirst;
+			continue;
+		}
+
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		{
+			if (frustum.Intersects(mBounds[mItemIndices[i]]))
+				items.emplace_back(mItemIndices[i]);
+		}
+	}
+}
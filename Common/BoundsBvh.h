@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include "BvhBuilder.h"
+
+// 물체 단위 경계 상자용 BVH. 물체가 많은 장면에서 절두체 질의를 전수 검사 없이 처리한다.
+// 넣은 순서가 곧 물체 번호이다.
+class BoundsBvh
+{
+public:
+	// 리프의 Count는 물체 수
+	using Node = BvhNode;
+
+public:
+	BoundsBvh() = default;
+
+	void Build(const std::vector<DirectX::BoundingBox>& bounds);
+	// 절두체와 겹치는 물체 번호를 모은다.
+	void Query(const DirectX::BoundingFrustum& frustum, std::vector<UINT>& items) const;
+
+	UINT ItemCount() const { return static_cast<UINT>(mBounds.size()); }
+	UINT NodeCount() const { return static_cast<UINT>(mNodes.size()); }
+
+private:
+	void CollectItems(UINT nodeIdx, std::vector<UINT>& items) const;
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<UINT> mItemIndices;
+	std::vector<DirectX::BoundingBox> mBounds;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "MathHelper.h"
+#include "Util.h"
+
+// MeshBvh, BoundsBvh가 같이 쓰는 노드. 부모가 자식보다 앞에 오도록 배열에 저장된다.
+struct BvhNode
+{
+	DirectX::XMFLOAT3 BoundsMin{};
+	UINT LeftFirst = 0;	// 내부 노드: 왼쪽 자식 인덱스(오른쪽은 +1), 리프: 첫 항목 위치
+	DirectX::XMFLOAT3 BoundsMax{};
+	UINT Count = 0;		// 리프의 항목 수. 0이면 내부 노드
+};
+
+// 항목을 번호로만 다루는 하향식 BVH 빌더. 항목의 모양은 두 콜백으로만 본다.
+//   addBounds(item, vMin, vMax): 항목의 경계로 vMin, vMax를 넓힌다.
+//   centroid(item): 나눌 때 기준으로 쓰는 점(const XMFLOAT3&)
+namespace BvhBuilder
+{
+	// 순회 스택에는 깊이마다 미뤄 둔 형제가 하나씩 쌓이므로 트리 깊이를 스택 크기 아래로 묶는다.
+	// 이 깊이부터는 중앙값으로만 나눠 남은 깊이가 log2(항목 수)를 넘지 않게 하고, 그래도 한도에 닿으면 리프로 둔다.
+	constexpr int MedianSplitDepth = 24;
+	constexpr int MaxTreeDepth(int maxTraversalDepth) { return maxTraversalDepth - 2; }
+
+	inline float GetAxis(const DirectX::XMFLOAT3& v, int axis)
+	{
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+
+	template<typename AddBounds>
+	void UpdateNodeBounds(BvhNode& node, const std::vector<UINT>& items, AddBounds&& addBounds)
+	{
+		using namespace DirectX;
+		XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+		XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+			addBounds(items[i], vMin, vMax);
+		XMStoreFloat3(&node.BoundsMin, vMin);
+		XMStoreFloat3(&node.BoundsMax, vMax);
+	}
+
+	// 항목 itemCount개로 nodes를 새로 만든다. items에는 리프 순서대로 놓인 항목 번호가 담긴다.
+	// 항목이 없으면 노드도 없다.
+	template<typename AddBounds, typename Centroid>
+	void Build(std::vector<BvhNode>& nodes, std::vector<UINT>& items, UINT itemCount,
+		UINT maxLeafItems, int maxTraversalDepth, AddBounds&& addBounds, Centroid&& centroid)
+	{
+		using namespace DirectX;
+		items.resize(itemCount);
+		for (auto i : Range(0, itemCount))
+			items[i] = i;
+
+		nodes.clear();
+		if (itemCount == 0)
+			return;
+
+		nodes.reserve(itemCount * 2);
+		nodes.emplace_back();
+		nodes[0].LeftFirst = 0;
+		nodes[0].Count = itemCount;
+		UpdateNodeBounds(nodes[0], items, addBounds);
+
+		const int maxTreeDepth = MaxTreeDepth(maxTraversalDepth);
+		std::vector<std::pair<UINT, int>> stack{ { 0, 0 } };
+		while (!stack.empty())
+		{
+			UINT curIdx = stack.back().first;
+			int depth = stack.back().second;
+			stack.pop_back();
+
+			UINT first = nodes[curIdx].LeftFirst;
+			UINT count = nodes[curIdx].Count;
+			if (count <= maxLeafItems || depth >= maxTreeDepth)
+				continue;
+
+			// 중심점 경계의 가장 긴 축을 반으로 나눈다. 한쪽이 비면 중앙값으로 나눈다.
+			XMVECTOR cMin = XMVectorReplicate(+MathHelper::Infinity);
+			XMVECTOR cMax = XMVectorReplicate(-MathHelper::Infinity);
+			for (auto i : Range(first, first + count))
+			{
+				XMVECTOR c = XMLoadFloat3(&centroid(items[i]));
+				cMin = XMVectorMin(cMin, c);
+				cMax = XMVectorMax(cMax, c);
+			}
+			XMFLOAT3 extent;
+			XMStoreFloat3(&extent, cMax - cMin);
+			int axis = 0;
+			if (extent.y > extent.x) axis = 1;
+			if (extent.z > GetAxis(extent, axis)) axis = 2;
+
+			XMFLOAT3 cMinf;
+			XMStoreFloat3(&cMinf, cMin);
+			float splitPos = GetAxis(cMinf, axis) + GetAxis(extent, axis) * 0.5f;
+
+			auto begin = items.begin() + first;
+			auto end = begin + count;
+			auto mid = std::partition(begin, end, [&](UINT item) {
+				return GetAxis(centroid(item), axis) < splitPos; });
+
+			UINT leftCount = static_cast<UINT>(mid - begin);
+			if (leftCount == 0 || leftCount == count || depth >= MedianSplitDepth)
+			{
+				leftCount = count / 2;
+				std::nth_element(begin, begin + leftCount, end, [&](UINT a, UINT b) {
+					return GetAxis(centroid(a), axis) < GetAxis(centroid(b), axis); });
+			}
+
+			UINT leftIdx = static_cast<UINT>(nodes.size());
+			nodes.emplace_back();
+			nodes.emplace_back();
+
+			nodes[leftIdx].LeftFirst = first;
+			nodes[leftIdx].Count = leftCount;
+			nodes[leftIdx + 1].LeftFirst = first + leftCount;
+			nodes[leftIdx + 1].Count = count - leftCount;
+
+			nodes[curIdx].LeftFirst = leftIdx;
+			nodes[curIdx].Count = 0;
+
+			UpdateNodeBounds(nodes[leftIdx], items, addBounds);
+			UpdateNodeBounds(nodes[leftIdx + 1], items, addBounds);
+
+			stack.push_back({ leftIdx, depth + 1 });
+			stack.push_back({ leftIdx + 1, depth + 1 });
+		}
+
+		nodes.shrink_to_fit();
+	}
+}
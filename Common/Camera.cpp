@@ -3,6 +3,7 @@
 //***************************************************************************************
 
 #include "Camera.h"
+#include "CollisionWorld.h"
 
 using namespace DirectX;
 
@@ -181,8 +182,9 @@ void Camera::Strafe(float d)
 	// mPosition += d*mRight
 	XMVECTOR s = XMVectorReplicate(d);
 	XMVECTOR r = XMLoadFloat3(&mRight);
-	XMVECTOR p = XMLoadFloat3(&mPosition);
-	XMStoreFloat3(&mPosition, XMVectorMultiplyAdd(s, r, p));
+	XMFLOAT3& target = IsCollisionEnabled() ? mPendingMove : mPosition;
+	XMVECTOR p = XMLoadFloat3(&target);
+	XMStoreFloat3(&target, XMVectorMultiplyAdd(s, r, p));
 
 	mViewDirty = true;
 }
@@ -192,8 +194,9 @@ void Camera::Walk(float d)
 	// mPosition += d*mLook
 	XMVECTOR s = XMVectorReplicate(d);
 	XMVECTOR l = XMLoadFloat3(&mLook);
-	XMVECTOR p = XMLoadFloat3(&mPosition);
-	XMStoreFloat3(&mPosition, XMVectorMultiplyAdd(s, l, p));
+	XMFLOAT3& target = IsCollisionEnabled() ? mPendingMove : mPosition;
+	XMVECTOR p = XMLoadFloat3(&target);
+	XMStoreFloat3(&target, XMVectorMultiplyAdd(s, l, p));
 
 	mViewDirty = true;
 }
@@ -247,11 +250,42 @@ void Camera::Move(eMove move, float speed)
 	}
 }
 
+void Camera::SetCollision(const CollisionWorld* world, float radius)
+{
+	mCollisionWorld = world;
+	mCollisionRadius = radius;
+	mViewDirty = true;
+}
+
+void Camera::EnableCollision(bool enable)
+{
+	if (enable == false)
+	{
+		// 아직 반영하지 않은 이동은 그대로 적용한다.
+		XMStoreFloat3(&mPosition, XMLoadFloat3(&mPosition) + XMLoadFloat3(&mPendingMove));
+		mPendingMove = { 0.0f, 0.0f, 0.0f };
+	}
+
+	mCollisionEnabled = enable;
+	mViewDirty = true;
+}
+
+bool Camera::IsCollisionEnabled()const
+{
+	return mCollisionEnabled && mCollisionWorld != nullptr;
+}
+
 void Camera::UpdateViewMatrix()
 {
 	if (mViewDirty == false)
 		return;
 
+	if (IsCollisionEnabled())
+	{
+		mPosition = mCollisionWorld->MoveSphere(mPosition, mPendingMove, mCollisionRadius);
+		mPendingMove = { 0.0f, 0.0f, 0.0f };
+	}
+
 	XMVECTOR R = XMLoadFloat3(&mRight);
 	XMVECTOR U = XMLoadFloat3(&mUp);
 	XMVECTOR L = XMLoadFloat3(&mLook);
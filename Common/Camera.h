@@ -13,6 +13,8 @@
 
 #include "d3dUtil.h"
 
+class CollisionWorld;
+
 class Camera
 {
 public:
@@ -81,6 +83,12 @@ public:
 
 	void Move(eMove move, float speed);
 
+	// Collision mode. While enabled, Walk/Strafe are gathered and resolved against
+	// the world as a sphere of the given radius in UpdateViewMatrix.
+	void SetCollision(const CollisionWorld* world, float radius);
+	void EnableCollision(bool enable);
+	bool IsCollisionEnabled()const;
+
 	// After modifying camera position/orientation, call to rebuild the view matrix.
 	void UpdateViewMatrix();
 
@@ -102,6 +110,11 @@ private:
 
 	bool mViewDirty = true;
 
+	const CollisionWorld* mCollisionWorld = nullptr;
+	float mCollisionRadius = 0.5f;
+	bool mCollisionEnabled = false;
+	DirectX::XMFLOAT3 mPendingMove = { 0.0f, 0.0f, 0.0f };
+
 	// Cache View/Proj matrices.
 	DirectX::XMFLOAT4X4 mView = MathHelper::Identity4x4();
 	DirectX::XMFLOAT4X4 mProj = MathHelper::Identity4x4();
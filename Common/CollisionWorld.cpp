@@ -0,0 +1,96 @@
+#include "CollisionWorld.h"
+#include "MathHelper.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr int MaxSlideIterations = 4;
+	constexpr int MaxPushIterations = 4;
+	constexpr float SkinWidth = 0.001f;	// 면에 딱 붙어 다음 질의에서 겹침으로 잡히지 않도록 남겨 두는 틈
+}
+
+void CollisionWorld::AddMesh(const std::vector<XMFLOAT3>& positions,
+	const std::vector<std::uint32_t>& indices, FXMMATRIX world)
+{
+	auto base = static_cast<std::uint32_t>(mPositions.size());
+	for (auto& p : positions)
+	{
+		XMFLOAT3 posW;
+		XMStoreFloat3(&posW, XMVector3TransformCoord(XMLoadFloat3(&p), world));
+		mPositions.emplace_back(posW);
+	}
+
+	for (auto idx : indices)
+		mIndices.emplace_back(base + idx);
+}
+
+void CollisionWorld::Build()
+{
+	mBvh.Build(mPositions, mIndices);
+}
+
+void CollisionWorld::Clear()
+{
+	mPositions.clear();
+	mIndices.clear();
+	mBvh.Build(mPositions, mIndices);
+}
+
+bool CollisionWorld::SweepSphere(FXMVECTOR center, FXMVECTOR dir, float radius, float maxDist, Hit& hit) const
+{
+	return mBvh.SweepSphere(center, dir, radius, maxDist, hit.T, hit.Normal, hit.Triangle);
+}
+
+bool CollisionWorld::ClosestPoint(FXMVECTOR point, float maxDist, XMFLOAT3& closest) const
+{
+	UINT triangle = 0;
+	return mBvh.ClosestPoint(point, maxDist, closest, triangle);
+}
+
+XMFLOAT3 CollisionWorld::MoveSphere(const XMFLOAT3& center, const XMFLOAT3& move, float radius) const
+{
+	XMVECTOR pos = XMLoadFloat3(&center);
+	XMVECTOR remain = XMLoadFloat3(&move);
+
+	for (int iter = 0; iter < MaxSlideIterations; ++iter)
+	{
+		float len = XMVectorGetX(XMVector3Length(remain));
+		if (len < 1e-6f)
+			break;
+
+		XMVECTOR dir = remain / len;
+		Hit hit;
+		if (SweepSphere(pos, dir, radius, len + SkinWidth, hit) == false)
+		{
+			pos += remain;
+			break;
+		}
+
+		// 닿기 직전까지 간 뒤 남은 이동에서 면 법선 성분을 빼고 다시 민다.
+		float travel = std::max<float>(hit.T - SkinWidth, 0.0f);
+		pos += dir * travel;
+		XMVECTOR n = XMLoadFloat3(&hit.Normal);
+		remain = dir * (len - travel);
+		remain -= n * std::min<float>(XMVectorGetX(XMVector3Dot(remain, n)), 0.0f);
+	}
+
+	// 시작부터 겹쳐 있었거나 모서리 사이에 끼인 경우를 밀어내서 정리한다.
+	for (int iter = 0; iter < MaxPushIterations; ++iter)
+	{
+		XMFLOAT3 closest;
+		if (ClosestPoint(pos, radius, closest) == false)
+			break;
+
+		XMVECTOR away = pos - XMLoadFloat3(&closest);
+		float dist = XMVectorGetX(XMVector3Length(away));
+		if (dist < 1e-6f)
+			break;
+		pos += away * ((radius + SkinWidth - dist) / dist);
+	}
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, pos);
+	return result;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "MeshBvh.h"
+
+// 움직이지 않는 장면 삼각형을 월드 공간 BVH 하나로 모아 두고 구 충돌 질의를 처리한다.
+// 카메라처럼 구 하나로 근사한 물체가 벽을 뚫지 않고 미끄러지게 할 때 쓴다.
+class CollisionWorld
+{
+public:
+	struct Hit
+	{
+		float T = 0.0f;
+		DirectX::XMFLOAT3 Normal{};
+		UINT Triangle = 0;
+	};
+
+public:
+	CollisionWorld() = default;
+
+	// 로컬 공간 메쉬를 world로 옮겨 모은다. 모두 넣은 뒤 Build를 부른다.
+	void AddMesh(const std::vector<DirectX::XMFLOAT3>& positions,
+		const std::vector<std::uint32_t>& indices, DirectX::FXMMATRIX world);
+	void Build();
+	void Clear();
+
+	// dir은 단위 벡터
+	bool SweepSphere(DirectX::FXMVECTOR center, DirectX::FXMVECTOR dir, float radius, float maxDist, Hit& hit) const;
+	bool ClosestPoint(DirectX::FXMVECTOR point, float maxDist, DirectX::XMFLOAT3& closest) const;
+
+	// center에서 move만큼 옮기되 닿으면 면을 따라 미끄러지고, 끝으로 겹친 곳에서 밀어낸 위치를 돌려준다.
+	DirectX::XMFLOAT3 MoveSphere(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& move, float radius) const;
+
+	bool Empty() const { return mBvh.TriangleCount() == 0; }
+	const MeshBvh& Bvh() const { return mBvh; }
+
+private:
+	std::vector<DirectX::XMFLOAT3> mPositions;
+	std::vector<std::uint32_t> mIndices;
+	MeshBvh mBvh;
+};
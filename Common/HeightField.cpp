@@ -0,0 +1,229 @@
+#include "HeightField.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// 경계에 딱 걸린 경우에도 진행 방향 쪽 칸을 고르도록 조금 앞의 위치로 칸을 정한다.
+	int CellIndex(float p, int cellSize, int cellCount)
+	{
+		int idx = static_cast<int>(std::floor(p / cellSize));
+		return std::min<int>(std::max<int>(idx, 0), cellCount - 1);
+	}
+
+	float CellExit(float o, float d, int idx, int cellSize)
+	{
+		if (d > 0.0f)
+			return ((idx + 1) * cellSize - o) / d;
+		if (d < 0.0f)
+			return (idx * cellSize - o) / d;
+		return MathHelper::Infinity;
+	}
+}
+
+void HeightField::Build(UINT rows, UINT cols, float width, float depth, const std::vector<float>& heights)
+{
+	assert(rows >= 2 && cols >= 2);
+	assert(heights.size() == rows * cols);
+
+	mRows = rows;
+	mCols = cols;
+	mDx = width / (cols - 1);
+	mDz = depth / (rows - 1);
+	mOriginX = -0.5f * width;
+	mOriginZ = 0.5f * depth;
+	mHeights = heights;
+
+	// 0단계는 칸 하나(정점 네 개)의 범위, 위 단계는 아래 2x2 칸을 합친다.
+	UINT levelCount = 1;
+	for (UINT size = std::max<UINT>(rows - 1, cols - 1); size > 1; size = (size + 1) / 2)
+		levelCount++;
+	mLevels.resize(levelCount);
+
+	for (auto l : Range(0, levelCount))
+	{
+		Level& level = mLevels[l];
+		level.Rows = l == 0 ? rows - 1 : (mLevels[l - 1].Rows + 1) / 2;
+		level.Cols = l == 0 ? cols - 1 : (mLevels[l - 1].Cols + 1) / 2;
+		level.MinH.resize(level.Rows * level.Cols);
+		level.MaxH.resize(level.Rows * level.Cols);
+		UpdateCellRows(l, 0, level.Rows);
+	}
+}
+
+void HeightField::UpdateRows(UINT row0, UINT row1, const float* heights)
+{
+	assert(row0 < row1 && row1 <= mRows);
+	std::copy(heights + row0 * mCols, heights + row1 * mCols, mHeights.begin() + row0 * mCols);
+
+	// 정점 행 i는 칸 행 i - 1과 i에 걸친다.
+	UINT cell0 = row0 > 0 ? row0 - 1 : 0;
+	UINT cell1 = std::min<UINT>(row1, mRows - 1);
+	UpdateCellRows(0, cell0, cell1);
+	for (auto l : Range(1, LevelCount()))
+	{
+		cell0 /= 2;
+		cell1 = (cell1 + 1) / 2;
+		UpdateCellRows(l, cell0, cell1);
+	}
+}
+
+void HeightField::UpdateCellRows(UINT levelIdx, UINT row0, UINT row1)
+{
+	Level& level = mLevels[levelIdx];
+	if (levelIdx == 0)
+	{
+		for (auto i : Range(row0, row1))
+		{
+			for (auto j : Range(0, level.Cols))
+			{
+				float h0 = Height(i, j), h1 = Height(i, j + 1);
+				float h2 = Height(i + 1, j), h3 = Height(i + 1, j + 1);
+				level.MinH[i * level.Cols + j] = std::min<float>(std::min<float>(h0, h1), std::min<float>(h2, h3));
+				level.MaxH[i * level.Cols + j] = std::max<float>(std::max<float>(h0, h1), std::max<float>(h2, h3));
+			}
+		}
+		return;
+	}
+
+	const Level& child = mLevels[levelIdx - 1];
+	for (auto i : Range(row0, row1))
+	{
+		UINT ci0 = i * 2, ci1 = std::min<UINT>(i * 2 + 2, child.Rows);
+		for (auto j : Range(0, level.Cols))
+		{
+			UINT cj0 = j * 2, cj1 = std::min<UINT>(j * 2 + 2, child.Cols);
+			float minH = +MathHelper::Infinity;
+			float maxH = -MathHelper::Infinity;
+			for (auto ci : Range(ci0, ci1))
+			{
+				for (auto cj : Range(cj0, cj1))
+				{
+					minH = std::min<float>(minH, child.MinH[ci * child.Cols + cj]);
+					maxH = std::max<float>(maxH, child.MaxH[ci * child.Cols + cj]);
+				}
+			}
+			level.MinH[i * level.Cols + j] = minH;
+			level.MaxH[i * level.Cols + j] = maxH;
+		}
+	}
+}
+
+bool HeightField::IntersectCell(FXMVECTOR rayOrigin, FXMVECTOR rayDir, UINT i, UINT j, float& t) const
+{
+	auto GetPos = [&](UINT r, UINT c) {
+		return XMVectorSet(mOriginX + c * mDx, Height(r, c), mOriginZ - r * mDz, 1.0f); };
+
+	XMVECTOR v0 = GetPos(i, j);
+	XMVECTOR v1 = GetPos(i, j + 1);
+	XMVECTOR v2 = GetPos(i + 1, j);
+	XMVECTOR v3 = GetPos(i + 1, j + 1);
+
+	// CreateGrid와 같은 대각선으로 나눈다.
+	float t0 = 0.0f, t1 = 0.0f;
+	bool hit0 = TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t0);
+	bool hit1 = TriangleTests::Intersects(rayOrigin, rayDir, v2, v1, v3, t1);
+	if (!hit0 && !hit1)
+		return false;
+
+	if (hit0 && hit1)
+		t = std::min<float>(t0, t1);
+	else
+		t = hit0 ? t0 : t1;
+	return true;
+}
+
+bool HeightField::Intersects(FXMVECTOR rayOrigin, FXMVECTOR rayDir, Hit& hit) const
+{
+	if (mLevels.empty())
+		return false;
+
+	// 격자 공간(u = 열, v = 행)으로 옮긴다. 축마다 선형이므로 t는 그대로 쓸 수 있다.
+	XMFLOAT3 o, d;
+	XMStoreFloat3(&o, rayOrigin);
+	XMStoreFloat3(&d, rayDir);
+	float ou = (o.x - mOriginX) / mDx;
+	float ov = (mOriginZ - o.z) / mDz;
+	float du = d.x / mDx;
+	float dv = -d.z / mDz;
+
+	const Level& top = mLevels.back();
+	float minH = *std::min_element(top.MinH.begin(), top.MinH.end());
+	float maxH = *std::max_element(top.MaxH.begin(), top.MaxH.end());
+
+	// 격자 전체 상자로 광선 구간을 자른다.
+	float tEnter = 0.0f;
+	float tExit = MathHelper::Infinity;
+	auto ClipSlab = [&](float origin, float dir, float lo, float hi) {
+		if (dir == 0.0f)
+			return origin >= lo && origin <= hi;
+		float t0 = (lo - origin) / dir;
+		float t1 = (hi - origin) / dir;
+		if (t0 > t1) std::swap(t0, t1);
+		tEnter = std::max<float>(tEnter, t0);
+		tExit = std::min<float>(tExit, t1);
+		return tEnter <= tExit;
+	};
+	if (!ClipSlab(ou, du, 0.0f, static_cast<float>(mCols - 1)) ||
+		!ClipSlab(ov, dv, 0.0f, static_cast<float>(mRows - 1)) ||
+		!ClipSlab(o.y, d.y, minH, maxH))
+		return false;
+
+	float maxStep = std::max<float>(fabsf(du), fabsf(dv));
+	int levelIdx = static_cast<int>(mLevels.size()) - 1;
+	float t = tEnter;
+	while (t <= tExit)
+	{
+		const Level& level = mLevels[levelIdx];
+		int cellSize = 1 << levelIdx;
+
+		// 칸 크기의 만분의 일만큼 앞에서 칸을 정해 경계에서 제자리걸음하지 않게 한다.
+		float tProbe = maxStep > 0.0f ? t + 1e-4f * cellSize / maxStep : t;
+		int ci = CellIndex(ov + tProbe * dv, cellSize, level.Rows);
+		int cj = CellIndex(ou + tProbe * du, cellSize, level.Cols);
+
+		float tCell = std::min<float>(std::min<float>(CellExit(ou, du, cj, cellSize), CellExit(ov, dv, ci, cellSize)), tExit);
+		tCell = std::max<float>(tCell, tProbe);
+
+		float y0 = o.y + t * d.y;
+		float y1 = o.y + tCell * d.y;
+		float lo = std::min<float>(y0, y1);
+		float hi = std::max<float>(y0, y1);
+
+		UINT cell = ci * level.Cols + cj;
+		bool overlaps = hi >= level.MinH[cell] && lo <= level.MaxH[cell];
+		if (overlaps && levelIdx > 0)
+		{
+			levelIdx--;
+			continue;
+		}
+
+		if (overlaps)
+		{
+			float tHit = 0.0f;
+			if (IntersectCell(rayOrigin, rayDir, ci, cj, tHit))
+			{
+				hit.T = tHit;
+				XMStoreFloat3(&hit.Pos, XMVectorMultiplyAdd(XMVectorReplicate(tHit), rayDir, rayOrigin));
+				float u = (hit.Pos.x - mOriginX) / mDx;
+				float v = (mOriginZ - hit.Pos.z) / mDz;
+				hit.Col = static_cast<UINT>(MathHelper::Clamp(static_cast<int>(u + 0.5f), 0, static_cast<int>(mCols) - 1));
+				hit.Row = static_cast<UINT>(MathHelper::Clamp(static_cast<int>(v + 0.5f), 0, static_cast<int>(mRows) - 1));
+				return true;
+			}
+		}
+
+		// 이 칸은 비었으니 건너가고, 다음 칸에서는 한 단계 큰 칸부터 다시 본다.
+		t = tCell;
+		if (t >= tExit)
+			break;
+		levelIdx = std::min<int>(levelIdx + 1, static_cast<int>(mLevels.size()) - 1);
+	}
+
+	return false;
+}
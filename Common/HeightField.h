@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+
+// 높이 격자에 대한 광선 교차. GeometryGenerator::CreateGrid, Waves와 같은 배치를 쓴다.
+// (x = -width/2 + j*dx, z = depth/2 - i*dz, 정점 번호 = i*cols + j)
+// 칸마다 최소/최대 높이를 밉맵으로 쌓아 두고, 광선이 지나가는 칸을 DDA로 밟아 가면서
+// 높이 범위에 걸리지 않는 큰 칸은 통째로 건너뛴다.
+class HeightField
+{
+public:
+	struct Hit
+	{
+		float T = 0.0f;
+		DirectX::XMFLOAT3 Pos{};
+		UINT Row = 0;		// 교점에서 가장 가까운 정점
+		UINT Col = 0;
+	};
+
+public:
+	HeightField() = default;
+
+	// heights는 rows*cols개. 크기가 같으면 다시 불러도 메모리를 새로 잡지 않는다.
+	// width, depth는 양 끝 정점 사이의 거리((cols - 1)*dx)이다. Waves::Width()(n*dx)와는 다르다.
+	void Build(UINT rows, UINT cols, float width, float depth, const std::vector<float>& heights);
+	// Build한 뒤 정점 행 [row0, row1)만 바뀌었을 때 그 행이 걸친 칸과 위 단계만 다시 맞춘다.
+	// heights는 Build와 같은 배치의 전체 배열이다.
+	void UpdateRows(UINT row0, UINT row1, const float* heights);
+
+	// 광선은 격자 로컬 공간 기준
+	bool Intersects(DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDir, Hit& hit) const;
+
+	UINT RowCount() const { return mRows; }
+	UINT ColumnCount() const { return mCols; }
+	UINT LevelCount() const { return static_cast<UINT>(mLevels.size()); }
+	float Height(UINT i, UINT j) const { return mHeights[i * mCols + j]; }
+
+private:
+	struct Level
+	{
+		UINT Rows = 0;	// 칸 수
+		UINT Cols = 0;
+		std::vector<float> MinH;
+		std::vector<float> MaxH;
+	};
+
+	void UpdateCellRows(UINT levelIdx, UINT row0, UINT row1);
+	bool IntersectCell(DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDir, UINT i, UINT j, float& t) const;
+
+private:
+	UINT mRows = 0;
+	UINT mCols = 0;
+	float mDx = 1.0f;
+	float mDz = 1.0f;
+	float mOriginX = 0.0f;
+	float mOriginZ = 0.0f;
+
+	std::vector<float> mHeights;
+	std::vector<Level> mLevels;
+};
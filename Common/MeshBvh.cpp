@@ -0,0 +1,509 @@
+#include "MeshBvh.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr UINT MaxLeafTriangles = 4;
+	constexpr int MaxTraversalDepth = 64;
+
+	// 슬랩 테스트. invDir은 0 성분이 있어도 inf가 되어 정상 동작한다.
+	bool IntersectsAabb(const MeshBvh::Node& node, FXMVECTOR origin, FXMVECTOR invDir, float tmax, float& tEnter)
+	{
+		XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.BoundsMin), origin), invDir);
+		XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.BoundsMax), origin), invDir);
+		XMFLOAT3 tNear, tFar;
+		XMStoreFloat3(&tNear, XMVectorMin(t0, t1));
+		XMStoreFloat3(&tFar, XMVectorMax(t0, t1));
+
+		float enter = std::max<float>(std::max<float>(tNear.x, tNear.y), std::max<float>(tNear.z, 0.0f));
+		float exit = std::min<float>(std::min<float>(tFar.x, tFar.y), std::min<float>(tFar.z, tmax));
+		tEnter = enter;
+		return enter <= exit;
+	}
+
+	// 노드 상자를 반지름만큼 키워서 광선으로 검사한다. 구를 미는 경우의 보수적인 판정이다.
+	bool IntersectsExpandedAabb(const MeshBvh::Node& node, FXMVECTOR origin, FXMVECTOR invDir, FXMVECTOR expand, float tmax)
+	{
+		XMVECTOR t0 = XMVectorMultiply(XMVectorSubtract(XMVectorSubtract(XMLoadFloat3(&node.BoundsMin), expand), origin), invDir);
+		XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMVectorAdd(XMLoadFloat3(&node.BoundsMax), expand), origin), invDir);
+		XMFLOAT3 tNear, tFar;
+		XMStoreFloat3(&tNear, XMVectorMin(t0, t1));
+		XMStoreFloat3(&tFar, XMVectorMax(t0, t1));
+
+		float enter = std::max<float>(std::max<float>(tNear.x, tNear.y), std::max<float>(tNear.z, 0.0f));
+		float exit = std::min<float>(std::min<float>(tFar.x, tFar.y), std::min<float>(tFar.z, tmax));
+		return enter <= exit;
+	}
+
+	float DistanceSqToAabb(const MeshBvh::Node& node, FXMVECTOR p)
+	{
+		XMVECTOR clamped = XMVectorClamp(p, XMLoadFloat3(&node.BoundsMin), XMLoadFloat3(&node.BoundsMax));
+		return XMVectorGetX(XMVector3LengthSq(p - clamped));
+	}
+
+	// Real-Time Collision Detection 5.1.5의 영역 판정 방식
+	XMVECTOR ClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		XMVECTOR ab = b - a;
+		XMVECTOR ac = c - a;
+		XMVECTOR ap = p - a;
+		float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+		float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+		if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+		XMVECTOR bp = p - b;
+		float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+		float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+		if (d3 >= 0.0f && d4 <= d3) return b;
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + ab * (d1 / (d1 - d3));
+
+		XMVECTOR cp = p - c;
+		float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+		float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+		if (d6 >= 0.0f && d5 <= d6) return c;
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + ac * (d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denom = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	// 광선과 구(center, radius)의 첫 교차. 광선 시작이 구 밖에 있을 때만 쓴다.
+	bool RaySphere(FXMVECTOR origin, FXMVECTOR dir, FXMVECTOR center, float radius, float& t)
+	{
+		XMVECTOR m = origin - center;
+		float b = XMVectorGetX(XMVector3Dot(m, dir));
+		float c = XMVectorGetX(XMVector3LengthSq(m)) - radius * radius;
+		if (c > 0.0f && b > 0.0f)
+			return false;
+		float disc = b * b - c;
+		if (disc < 0.0f)
+			return false;
+		t = std::max<float>(-b - sqrtf(disc), 0.0f);
+		return true;
+	}
+
+	// 구를 밀었을 때 삼각형과 처음 닿는 t. 면, 모서리(원기둥), 꼭짓점(구) 순으로 가장 이른 값을 고른다.
+	bool SweepSphereTriangle(FXMVECTOR center, FXMVECTOR dir, float radius, FXMVECTOR v0, GXMVECTOR v1, HXMVECTOR v2,
+		float tmax, float& t, XMVECTOR& contact)
+	{
+		XMVECTOR closest = ClosestPointOnTriangle(center, v0, v1, v2);
+		if (XMVectorGetX(XMVector3LengthSq(center - closest)) < radius * radius)
+		{
+			t = 0.0f;
+			contact = closest;
+			return true;
+		}
+
+		bool hit = false;
+		float best = tmax;
+
+		XMVECTOR n = XMVector3Cross(v1 - v0, v2 - v0);
+		if (XMVectorGetX(XMVector3LengthSq(n)) < 1e-12f)
+			return false;
+		n = XMVector3Normalize(n);
+		float dist = XMVectorGetX(XMVector3Dot(center - v0, n));
+		if (dist < 0.0f)
+		{
+			n = -n;
+			dist = -dist;
+		}
+
+		float dn = XMVectorGetX(XMVector3Dot(dir, n));
+		if (dist >= radius && dn < 0.0f)
+		{
+			float tFace = (dist - radius) / -dn;
+			if (tFace <= best)
+			{
+				XMVECTOR p = center + dir * tFace - n * radius;
+				XMVECTOR onTri = ClosestPointOnTriangle(p, v0, v1, v2);
+				if (XMVectorGetX(XMVector3LengthSq(p - onTri)) < 1e-8f)
+				{
+					best = tFace;
+					contact = p;
+					hit = true;
+				}
+			}
+		}
+
+		const XMVECTOR verts[3] = { v0, v1, v2 };
+		for (auto i : Range(0, 3))
+		{
+			float tVert = 0.0f;
+			if (RaySphere(center, dir, verts[i], radius, tVert) && tVert <= best)
+			{
+				best = tVert;
+				contact = verts[i];
+				hit = true;
+			}
+
+			XMVECTOR a = verts[i];
+			XMVECTOR e = verts[(i + 1) % 3] - a;
+			XMVECTOR m = center - a;
+			float ee = XMVectorGetX(XMVector3Dot(e, e));
+			float ed = XMVectorGetX(XMVector3Dot(e, dir));
+			float em = XMVectorGetX(XMVector3Dot(e, m));
+			float qa = ee - ed * ed;
+			if (qa < 1e-8f * ee)
+				continue;	//모서리와 평행하면 꼭짓점에서 먼저 닿는다.
+
+			float qb = ee * XMVectorGetX(XMVector3Dot(m, dir)) - ed * em;
+			float qc = ee * (XMVectorGetX(XMVector3LengthSq(m)) - radius * radius) - em * em;
+			float disc = qb * qb - qa * qc;
+			if (disc < 0.0f)
+				continue;
+
+			float tEdge = (-qb - sqrtf(disc)) / qa;
+			if (tEdge < 0.0f || tEdge > best)
+				continue;
+			float s = (em + tEdge * ed) / ee;
+			if (s < 0.0f || s > 1.0f)
+				continue;
+
+			best = tEdge;
+			contact = a + e * s;
+			hit = true;
+		}
+
+		if (hit)
+			t = best;
+		return hit;
+	}
+}
+
+void MeshBvh::Build(const std::vector<XMFLOAT3>& positions, const std::vector<std::uint32_t>& indices)
+{
+	assert(indices.size() % 3 == 0);
+
+	mPositions = positions;
+	mIndices = indices;
+
+	UINT triCount = TriangleCount();
+	mCentroids.resize(triCount);
+	for (auto i : Range(0, triCount))
+	{
+		XMVECTOR v0, v1, v2;
+		GetTriangle(i, v0, v1, v2);
+		XMStoreFloat3(&mCentroids[i], (v0 + v1 + v2) * (1.0f / 3.0f));
+	}
+
+	BvhBuilder::Build(mNodes, mTriIndices, triCount, MaxLeafTriangles, MaxTraversalDepth,
+		[this](UINT tri, XMVECTOR& vMin, XMVECTOR& vMax) { AddTriangleBounds(tri, vMin, vMax); },
+		[this](UINT tri) -> const XMFLOAT3& { return mCentroids[tri]; });
+}
+
+void MeshBvh::GetTriangle(UINT triangle, XMVECTOR& v0, XMVECTOR& v1, XMVECTOR& v2) const
+{
+	v0 = XMLoadFloat3(&mPositions[mIndices[triangle * 3 + 0]]);
+	v1 = XMLoadFloat3(&mPositions[mIndices[triangle * 3 + 1]]);
+	v2 = XMLoadFloat3(&mPositions[mIndices[triangle * 3 + 2]]);
+}
+
+BoundingBox MeshBvh::GetBounds() const
+{
+	BoundingBox bounds;
+	if (mNodes.empty())
+		return bounds;
+
+	BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&mNodes[0].BoundsMin), XMLoadFloat3(&mNodes[0].BoundsMax));
+	return bounds;
+}
+
+void MeshBvh::AddTriangleBounds(UINT triangle, XMVECTOR& vMin, XMVECTOR& vMax) const
+{
+	XMVECTOR v0, v1, v2;
+	GetTriangle(triangle, v0, v1, v2);
+	vMin = XMVectorMin(vMin, XMVectorMin(v0, XMVectorMin(v1, v2)));
+	vMax = XMVectorMax(vMax, XMVectorMax(v0, XMVectorMax(v1, v2)));
+}
+
+bool MeshBvh::Intersects(FXMVECTOR rayOrigin, FXMVECTOR rayDir, float& tmin, UINT& triangle) const
+{
+	if (mNodes.empty())
+		return false;
+
+	XMVECTOR invDir = XMVectorReciprocal(rayDir);
+	float closest = MathHelper::Infinity;
+	bool hit = false;
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+
+		float tEnter = 0.0f;
+		if (!IntersectsAabb(node, rayOrigin, invDir, closest, tEnter))
+			continue;
+
+		if (node.Count > 0)
+		{
+			for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+			{
+				XMVECTOR v0, v1, v2;
+				GetTriangle(mTriIndices[i], v0, v1, v2);
+
+				float t = 0.0f;
+				if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t) == false)
+					continue;
+				if (t >= closest)
+					continue;
+
+				closest = t;
+				triangle = mTriIndices[i];
+				hit = true;
+			}
+			continue;
+		}
+
+		// 가까운 자식을 먼저 꺼내도록 먼 자식을 먼저 넣는다.
+		UINT nearIdx = node.LeftFirst;
+		UINT farIdx = node.LeftFirst + 1;
+		float tLeft = 0.0f, tRight = 0.0f;
+		bool hitLeft = IntersectsAabb(mNodes[nearIdx], rayOrigin, invDir, closest, tLeft);
+		bool hitRight = IntersectsAabb(mNodes[farIdx], rayOrigin, invDir, closest, tRight);
+		if (hitLeft && hitRight && tRight < tLeft)
+			std::swap(nearIdx, farIdx);
+
+		assert(stackSize + 2 <= MaxTraversalDepth);
+		if (hitLeft && hitRight)
+		{
+			stack[stackSize++] = farIdx;
+			stack[stackSize++] = nearIdx;
+		}
+		else if (hitLeft)
+			stack[stackSize++] = node.LeftFirst;
+		else if (hitRight)
+			stack[stackSize++] = node.LeftFirst + 1;
+	}
+
+	if (hit)
+		tmin = closest;
+	return hit;
+}
+
+bool MeshBvh::Occluded(FXMVECTOR rayOrigin, FXMVECTOR rayDir, float maxDist) const
+{
+	if (mNodes.empty())
+		return false;
+
+	XMVECTOR invDir = XMVectorReciprocal(rayDir);
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+
+		float tEnter = 0.0f;
+		if (!IntersectsAabb(node, rayOrigin, invDir, maxDist, tEnter))
+			continue;
+
+		if (node.Count == 0)
+		{
+			assert(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = node.LeftFirst + 1;
+			stack[stackSize++] = node.LeftFirst;
+			continue;
+		}
+
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		{
+			XMVECTOR v0, v1, v2;
+			GetTriangle(mTriIndices[i], v0, v1, v2);
+
+			float t = 0.0f;
+			if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t) && t < maxDist)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void MeshBvh::CollectTriangles(UINT nodeIdx, std::vector<UINT>& triangles) const
+{
+	const Node& node = mNodes[nodeIdx];
+	if (node.Count == 0)
+	{
+		CollectTriangles(node.LeftFirst, triangles);
+		CollectTriangles(node.LeftFirst + 1, triangles);
+		return;
+	}
+
+	for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		triangles.emplace_back(mTriIndices[i]);
+}
+
+void MeshBvh::Query(const BoundingFrustum& frustum, std::vector<UINT>& triangles) const
+{
+	if (mNodes.empty())
+		return;
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		UINT nodeIdx = stack[--stackSize];
+		const Node& node = mNodes[nodeIdx];
+
+		BoundingBox box;
+		BoundingBox::CreateFromPoints(box, XMLoadFloat3(&node.BoundsMin), XMLoadFloat3(&node.BoundsMax));
+		ContainmentType containment = frustum.Contains(box);
+		if (containment == DISJOINT)
+			continue;
+
+		//노드가 통째로 들어가 있으면 더 검사할 필요 없이 아래 삼각형을 전부 넣는다.
+		if (containment == CONTAINS)
+		{
+			CollectTriangles(nodeIdx, triangles);
+			continue;
+		}
+
+		if (node.Count == 0)
+		{
+			assert(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = node.LeftFirst + 1;
+			stack[stackSize++] = node.LeftFirst;
+			continue;
+		}
+
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		{
+			XMVECTOR v0, v1, v2;
+			GetTriangle(mTriIndices[i], v0, v1, v2);
+			if (frustum.Intersects(v0, v1, v2))
+				triangles.emplace_back(mTriIndices[i]);
+		}
+	}
+}
+
+bool MeshBvh::SweepSphere(FXMVECTOR center, FXMVECTOR dir, float radius, float maxDist,
+	float& t, XMFLOAT3& normal, UINT& triangle) const
+{
+	if (mNodes.empty())
+		return false;
+
+	XMVECTOR invDir = XMVectorReciprocal(dir);
+	XMVECTOR expand = XMVectorReplicate(radius);
+	float closest = maxDist;
+	XMVECTOR contact = XMVectorZero();
+	bool hit = false;
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+		if (!IntersectsExpandedAabb(node, center, invDir, expand, closest))
+			continue;
+
+		if (node.Count == 0)
+		{
+			assert(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = node.LeftFirst + 1;
+			stack[stackSize++] = node.LeftFirst;
+			continue;
+		}
+
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		{
+			XMVECTOR v0, v1, v2;
+			GetTriangle(mTriIndices[i], v0, v1, v2);
+
+			float tTri = 0.0f;
+			XMVECTOR p;
+			if (SweepSphereTriangle(center, dir, radius, v0, v1, v2, closest, tTri, p) == false)
+				continue;
+
+			closest = tTri;
+			contact = p;
+			triangle = mTriIndices[i];
+			hit = true;
+		}
+	}
+
+	if (hit == false)
+		return false;
+
+	t = closest;
+	XMVECTOR n = XMVectorMultiplyAdd(XMVectorReplicate(closest), dir, center) - contact;
+	if (XMVectorGetX(XMVector3LengthSq(n)) < 1e-12f)
+		n = -dir;
+	XMStoreFloat3(&normal, XMVector3Normalize(n));
+	return true;
+}
+
+bool MeshBvh::ClosestPoint(FXMVECTOR point, float maxDist, XMFLOAT3& closest, UINT& triangle) const
+{
+	if (mNodes.empty())
+		return false;
+
+	float bestSq = maxDist * maxDist;
+	bool found = false;
+
+	UINT stack[MaxTraversalDepth];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const Node& node = mNodes[stack[--stackSize]];
+		if (DistanceSqToAabb(node, point) > bestSq)
+			continue;
+
+		if (node.Count == 0)
+		{
+			// 가까운 자식을 나중에 넣어 먼저 본다. 그래야 bestSq가 빨리 줄어든다.
+			UINT nearIdx = node.LeftFirst;
+			UINT farIdx = node.LeftFirst + 1;
+			if (DistanceSqToAabb(mNodes[farIdx], point) < DistanceSqToAabb(mNodes[nearIdx], point))
+				std::swap(nearIdx, farIdx);
+
+			assert(stackSize + 2 <= MaxTraversalDepth);
+			stack[stackSize++] = farIdx;
+			stack[stackSize++] = nearIdx;
+			continue;
+		}
+
+		for (auto i : Range(node.LeftFirst, node.LeftFirst + node.Count))
+		{
+			XMVECTOR v0, v1, v2;
+			GetTriangle(mTriIndices[i], v0, v1, v2);
+
+			XMVECTOR p = ClosestPointOnTriangle(point, v0, v1, v2);
+			float distSq = XMVectorGetX(XMVector3LengthSq(point - p));
+			if (distSq > bestSq)
+				continue;
+
+			bestSq = distSq;
+			XMStoreFloat3(&closest, p);
+			triangle = mTriIndices[i];
+			found = true;
+		}
+	}
+
+	return found;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include <cstdint>
+#include "BvhBuilder.h"
+
+// 삼각형 메쉬용 BVH
+class MeshBvh
+{
+public:
+	// 리프의 Count는 삼각형 수
+	using Node = BvhNode;
+
+public:
+	MeshBvh() = default;
+
+	void Build(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<std::uint32_t>& indices);
+
+	// 가장 가까운 교차 삼각형을 찾는다. ray는 메쉬 로컬 공간 기준.
+	bool Intersects(DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDir,
+		float& tmin, UINT& triangle) const;
+	// maxDist 안에 아무 삼각형이라도 걸리면 바로 true를 돌려준다. 그림자나 AO처럼 가림 여부만 필요할 때 쓴다.
+	bool Occluded(DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDir, float maxDist) const;
+	// 절두체(메쉬 로컬 공간)에 걸치거나 들어간 삼각형 번호를 모두 모은다.
+	void Query(const DirectX::BoundingFrustum& frustum, std::vector<UINT>& triangles) const;
+	// 반지름 radius인 구를 dir(단위 벡터) 방향으로 maxDist까지 밀었을 때 처음 닿는 곳.
+	// 시작부터 겹쳐 있으면 t = 0. normal은 닿은 점에서 구 중심을 향한다.
+	bool SweepSphere(DirectX::FXMVECTOR center, DirectX::FXMVECTOR dir, float radius, float maxDist,
+		float& t, DirectX::XMFLOAT3& normal, UINT& triangle) const;
+	// point에서 maxDist 안에 있는 가장 가까운 삼각형 위의 점
+	bool ClosestPoint(DirectX::FXMVECTOR point, float maxDist, DirectX::XMFLOAT3& closest, UINT& triangle) const;
+
+	UINT TriangleCount() const { return static_cast<UINT>(mIndices.size() / 3); }
+	UINT NodeCount() const { return static_cast<UINT>(mNodes.size()); }
+	const std::vector<Node>& Nodes() const { return mNodes; }
+	const std::vector<DirectX::XMFLOAT3>& Positions() const { return mPositions; }
+	void GetTriangle(UINT triangle, DirectX::XMVECTOR& v0, DirectX::XMVECTOR& v1, DirectX::XMVECTOR& v2) const;
+	DirectX::BoundingBox GetBounds() const;
+
+	// 리프 안의 삼각형 번호(원본 인덱스 버퍼 기준)
+	UINT LeafTriangle(UINT slot) const { return mTriIndices[slot]; }
+
+private:
+	void AddTriangleBounds(UINT triangle, DirectX::XMVECTOR& vMin, DirectX::XMVECTOR& vMax) const;
+	void CollectTriangles(UINT nodeIdx, std::vector<UINT>& triangles) const;
+
+private:
+	std::vector<Node> mNodes;
+	std::vector<UINT> mTriIndices;
+	std::vector<DirectX::XMFLOAT3> mCentroids;
+	std::vector<DirectX::XMFLOAT3> mPositions;
+	std::vector<std::uint32_t> mIndices;
+};
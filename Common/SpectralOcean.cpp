@@ -0,0 +1,438 @@
+#include "SpectralOcean.h"
+#include "TaskScheduler.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include "WaveVertexWriter.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr float Gravity = 9.81f;
+	// FFT 한 작업이 맡는 열 수. 띠 하나(N행 x 64열 x 실수부, 허수부)가 L2에 들어간다.
+	constexpr int StripCols = 64;
+	constexpr int TransposeRows = 16;
+
+	XMVECTOR Load(const float* p) { return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p)); }
+	void Store(float* p, FXMVECTOR v) { XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(p), v); }
+
+	float Phillips(float kx, float kz, const XMFLOAT2& windDir, float windSpeed, float amplitude)
+	{
+		float k2 = kx*kx + kz*kz;
+		if (k2 < 1e-12f)
+			return 0.0f;
+
+		float windWaveLength = windSpeed*windSpeed / Gravity;
+		float kDotW = (kx*windDir.x + kz*windDir.y) / sqrtf(k2);
+		// 바람 길이의 천분의 일보다 짧은 물결은 줄인다.
+		float damping = windWaveLength * 0.001f;
+		return amplitude * expf(-1.0f / (k2*windWaveLength*windWaveLength)) / (k2*k2) *
+			kDotW*kDotW * expf(-k2*damping*damping);
+	}
+
+	// 파수 공간 JONSWAP 밀도. S(ω)에 방향 분포 (2/π)cos²θ와 dω/dk / k를 곱한다.
+	float Jonswap(float kx, float kz, const XMFLOAT2& windDir, float windSpeed, float fetch, float gamma)
+	{
+		float k = sqrtf(kx*kx + kz*kz);
+		if (k < 1e-6f)
+			return 0.0f;
+
+		float cosTheta = (kx*windDir.x + kz*windDir.y) / k;
+		if (cosTheta <= 0.0f)
+			return 0.0f;
+
+		float omega = sqrtf(Gravity*k);
+		float alpha = 0.076f * powf(windSpeed*windSpeed / (fetch*Gravity), 0.22f);
+		float omegaPeak = 22.0f * powf(Gravity*Gravity / (windSpeed*fetch), 1.0f / 3.0f);
+		float sigma = omega <= omegaPeak ? 0.07f : 0.09f;
+		float r = expf(-(omega - omegaPeak)*(omega - omegaPeak) / (2.0f*sigma*sigma*omegaPeak*omegaPeak));
+		float s = alpha*Gravity*Gravity / powf(omega, 5.0f) *
+			expf(-1.25f*powf(omegaPeak / omega, 4.0f)) * powf(gamma, r);
+
+		float spreading = 2.0f / MathHelper::Pi * cosTheta*cosTheta;
+		float dOmegaDk = Gravity / (2.0f*omega);
+		return s * spreading * dOmegaDk / k;
+	}
+}
+
+SpectralOcean::SpectralOcean(const Desc& desc)
+{
+	mN = desc.Size;
+	assert(mN >= 4 && (mN & (mN - 1)) == 0);
+	while ((1 << mLogN) < mN)
+		mLogN++;
+
+	mDx = desc.PatchSize / mN;
+	mHalfSize = (mN - 1)*mDx*0.5f;
+	mChoppiness = desc.Choppiness;
+
+	const int count = mN*mN;
+	for (auto f : Range(0, FieldCount))
+	{
+		mFieldRe[f].assign(count, 0.0f);
+		mFieldIm[f].assign(count, 0.0f);
+		mScratchRe[f].assign(count, 0.0f);
+		mScratchIm[f].assign(count, 0.0f);
+	}
+	mHeights.assign(count, 0.0f);
+	mDispX.assign(count, 0.0f);
+	mDispZ.assign(count, 0.0f);
+	mSlopeX.assign(count, 0.0f);
+	mNormalX.assign(count, 0.0f);
+	mNormalZ.assign(count, 0.0f);
+
+	mBitReverse.resize(mN);
+	for (auto i : Range(0, mN))
+	{
+		int r = 0;
+		for (int b = 0; b < mLogN; ++b)
+			r |= ((i >> b) & 1) << (mLogN - 1 - b);
+		mBitReverse[i] = r;
+	}
+
+	mTwiddleRe.resize(mN / 2);
+	mTwiddleIm.resize(mN / 2);
+	for (auto k : Range(0, mN / 2))
+	{
+		double angle = 2.0 * 3.14159265358979323846 * k / mN;
+		mTwiddleRe[k] = static_cast<float>(cos(angle));
+		mTwiddleIm[k] = static_cast<float>(sin(angle));
+	}
+
+	BuildSpectrum(desc);
+	Evaluate(0.0f);
+}
+
+void SpectralOcean::BuildSpectrum(const Desc& desc)
+{
+	const int n = mN;
+	const int count = n*n;
+	mH0Re.assign(count, 0.0f);
+	mH0Im.assign(count, 0.0f);
+	mH0ConjRe.assign(count, 0.0f);
+	mH0ConjIm.assign(count, 0.0f);
+	mOmega.assign(count, 0.0f);
+	mKx.assign(count, 0.0f);
+	mKz.assign(count, 0.0f);
+	mKxOverK.assign(count, 0.0f);
+	mKzOverK.assign(count, 0.0f);
+
+	XMFLOAT2 windDir;
+	XMStoreFloat2(&windDir, XMVector2Normalize(XMLoadFloat2(&desc.WindDir)));
+
+	std::mt19937 rng(desc.Seed);
+	std::normal_distribution<float> gaussian(0.0f, 1.0f);
+
+	const float dk = 2.0f * MathHelper::Pi / desc.PatchSize;
+	auto WaveVector = [&](int a, int b, float& kx, float& kz) {
+		// z는 행이 늘수록 줄어드므로 kz 부호를 뒤집어야 물리 방향과 맞는다.
+		kx = dk * (a - n / 2);
+		kz = -dk * (b - n / 2);
+	};
+
+	for (auto a : Range(0, n))
+	{
+		for (auto b : Range(0, n))
+		{
+			int idx = a*n + b;
+			float kx, kz;
+			WaveVector(a, b, kx, kz);
+			float k = sqrtf(kx*kx + kz*kz);
+
+			// 순서대로 뽑아야 같은 Seed에서 같은 바다가 나온다.
+			float xr = gaussian(rng);
+			float xi = gaussian(rng);
+
+			// N/2 주파수는 -k 짝이 없어서 결과가 실수가 되지 않으므로 비운다.
+			if (a == 0 || b == 0)
+				continue;
+
+			float amplitude = 0.0f;
+			if (desc.Type == Spectrum::Phillips)
+				amplitude = sqrtf(Phillips(kx, kz, windDir, desc.WindSpeed, desc.Amplitude) * 0.5f);
+			else
+				amplitude = sqrtf(Jonswap(kx, kz, windDir, desc.WindSpeed, desc.Fetch, desc.PeakEnhancement) * dk*dk);
+
+			mH0Re[idx] = xr*amplitude;
+			mH0Im[idx] = xi*amplitude;
+			mOmega[idx] = sqrtf(Gravity*k);
+			mKx[idx] = kx;
+			mKz[idx] = kz;
+			mKxOverK[idx] = k > 0.0f ? kx / k : 0.0f;
+			mKzOverK[idx] = k > 0.0f ? kz / k : 0.0f;
+		}
+	}
+
+	for (auto a : Range(0, n))
+	{
+		for (auto b : Range(0, n))
+		{
+			int mirror = ((n - a) % n)*n + (n - b) % n;
+			mH0ConjRe[a*n + b] = mH0Re[mirror];
+			mH0ConjIm[a*n + b] = -mH0Im[mirror];
+		}
+	}
+}
+
+// h(k, t) = h0(k)e^{iωt} + conj(h0(-k))e^{-iωt}에서 세 묶음 스펙트럼을 채운다.
+void SpectralOcean::UpdateSpectrumRow(float time, int a)
+{
+	const int base = a*mN;
+	const float* h0r = &mH0Re[base];
+	const float* h0i = &mH0Im[base];
+	const float* hcr = &mH0ConjRe[base];
+	const float* hci = &mH0ConjIm[base];
+	const float* omega = &mOmega[base];
+	const float* kx = &mKx[base];
+	const float* kz = &mKz[base];
+	const float* kxk = &mKxOverK[base];
+	const float* kzk = &mKzOverK[base];
+	float* f0r = &mFieldRe[0][base];
+	float* f0i = &mFieldIm[0][base];
+	float* f1r = &mFieldRe[1][base];
+	float* f1i = &mFieldIm[1][base];
+	float* f2r = &mFieldRe[2][base];
+	float* f2i = &mFieldIm[2][base];
+
+	const XMVECTOR t = XMVectorReplicate(time);
+	const XMVECTOR one = XMVectorReplicate(1.0f);
+	for (int b = 0; b < mN; b += 4)
+	{
+		XMVECTOR s, c;
+		XMVectorSinCos(&s, &c, Load(omega + b) * t);
+
+		XMVECTOR ar = Load(h0r + b), ai = Load(h0i + b);
+		XMVECTOR br = Load(hcr + b), bi = Load(hci + b);
+		XMVECTOR hr = (ar + br) * c + (bi - ai) * s;
+		XMVECTOR hi = (ar - br) * s + (ai + bi) * c;
+
+		// 높이 h + i 변위x(-i kx/k h)
+		XMVECTOR ux = Load(kxk + b);
+		Store(f0r + b, hr * (one + ux));
+		Store(f0i + b, hi * (one + ux));
+
+		// 변위z(-i kz/k h) + i 기울기x(i kx h)
+		XMVECTOR uz = Load(kzk + b);
+		XMVECTOR vx = Load(kx + b);
+		Store(f1r + b, uz * hi - vx * hr);
+		Store(f1i + b, -(uz * hr) - vx * hi);
+
+		// 기울기z(i kz h)
+		XMVECTOR vz = Load(kz + b);
+		Store(f2r + b, -(vz * hi));
+		Store(f2i + b, vz * hr);
+	}
+}
+
+// 열 [c0, c1)마다 첫 번째 번호 방향으로 역 DFT를 한다. 열이 메모리에서 이웃이라 여러 열의 나비 연산을 한 번에 한다.
+void SpectralOcean::FftColumns(int field, int c0, int c1)
+{
+	const int n = mN;
+	float* re = mFieldRe[field].data();
+	float* im = mFieldIm[field].data();
+
+	for (int r = 0; r < n; ++r)
+	{
+		int rr = mBitReverse[r];
+		if (rr <= r)
+			continue;
+		std::swap_ranges(re + r*n + c0, re + r*n + c1, re + rr*n + c0);
+		std::swap_ranges(im + r*n + c0, im + r*n + c1, im + rr*n + c0);
+	}
+
+	for (int half = 1; half < n; half *= 2)
+	{
+		const int twiddleStep = n / (2 * half);
+		for (int block = 0; block < n; block += 2 * half)
+		{
+			for (int k = 0; k < half; ++k)
+			{
+				const float wr = mTwiddleRe[k*twiddleStep];
+				const float wi = mTwiddleIm[k*twiddleStep];
+				float* pr = re + (block + k)*n;
+				float* pi = im + (block + k)*n;
+				float* qr = pr + half*n;
+				float* qi = pi + half*n;
+
+				int c = c0;
+#if defined(__AVX2__)
+				const __m256 wr8 = _mm256_set1_ps(wr);
+				const __m256 wi8 = _mm256_set1_ps(wi);
+				for (; c + 8 <= c1; c += 8)
+				{
+					__m256 xr = _mm256_loadu_ps(qr + c), xi = _mm256_loadu_ps(qi + c);
+					__m256 tr = _mm256_sub_ps(_mm256_mul_ps(wr8, xr), _mm256_mul_ps(wi8, xi));
+					__m256 ti = _mm256_add_ps(_mm256_mul_ps(wr8, xi), _mm256_mul_ps(wi8, xr));
+					__m256 yr = _mm256_loadu_ps(pr + c), yi = _mm256_loadu_ps(pi + c);
+					_mm256_storeu_ps(qr + c, _mm256_sub_ps(yr, tr));
+					_mm256_storeu_ps(qi + c, _mm256_sub_ps(yi, ti));
+					_mm256_storeu_ps(pr + c, _mm256_add_ps(yr, tr));
+					_mm256_storeu_ps(pi + c, _mm256_add_ps(yi, ti));
+				}
+#endif
+				const XMVECTOR wr4 = XMVectorReplicate(wr);
+				const XMVECTOR wi4 = XMVectorReplicate(wi);
+				for (; c < c1; c += 4)
+				{
+					XMVECTOR xr = Load(qr + c), xi = Load(qi + c);
+					XMVECTOR tr = wr4 * xr - wi4 * xi;
+					XMVECTOR ti = wr4 * xi + wi4 * xr;
+					XMVECTOR yr = Load(pr + c), yi = Load(pi + c);
+					Store(qr + c, yr - tr);
+					Store(qi + c, yi - ti);
+					Store(pr + c, yr + tr);
+					Store(pi + c, yi + ti);
+				}
+			}
+		}
+	}
+}
+
+// 행 [r0, r1)을 임시 버퍼의 열로 옮긴다. 4x4 묶음씩 XMMatrixTranspose로 돌린다.
+void SpectralOcean::Transpose(int field, int r0, int r1)
+{
+	const int n = mN;
+	const float* srcs[] = { mFieldRe[field].data(), mFieldIm[field].data() };
+	float* dsts[] = { mScratchRe[field].data(), mScratchIm[field].data() };
+	for (auto part : Range(0, 2))
+	{
+		const float* src = srcs[part];
+		float* dst = dsts[part];
+		for (int r = r0; r < r1; r += 4)
+		{
+			for (int c = 0; c < n; c += 4)
+			{
+				XMMATRIX m(Load(src + r*n + c), Load(src + (r + 1)*n + c),
+					Load(src + (r + 2)*n + c), Load(src + (r + 3)*n + c));
+				m = XMMatrixTranspose(m);
+				for (auto k : Range(0, 4))
+					Store(dst + (c + k)*n + r, m.r[k]);
+			}
+		}
+	}
+}
+
+// 중심을 맞춘 주파수 번호 때문에 붙는 (-1)^(i+j)를 곱해 결과를 꺼내고 법선을 구한다.
+void SpectralOcean::ResolveRow(int i)
+{
+	const int n = mN;
+	const int base = i*n;
+	const float* f0r = &mFieldRe[0][base];
+	const float* f0i = &mFieldIm[0][base];
+	const float* f1r = &mFieldRe[1][base];
+	const float* f1i = &mFieldIm[1][base];
+	const float* f2r = &mFieldRe[2][base];
+
+	// 행이 짝수면 (+, -, +, -), 홀수면 (-, +, -, +)
+	const XMVECTOR sign = (i & 1) ? XMVectorSet(-1.0f, 1.0f, -1.0f, 1.0f) : XMVectorSet(1.0f, -1.0f, 1.0f, -1.0f);
+	const XMVECTOR lambda = XMVectorReplicate(mChoppiness);
+	for (int j = 0; j < n; j += 4)
+	{
+		XMVECTOR sx = sign * Load(f1i + j);
+		XMVECTOR sz = sign * Load(f2r + j);
+		Store(&mHeights[base + j], sign * Load(f0r + j));
+		Store(&mDispX[base + j], lambda * sign * Load(f0i + j));
+		Store(&mDispZ[base + j], lambda * sign * Load(f1r + j));
+		Store(&mSlopeX[base + j], sx);
+
+		// 법선 (-sx, 1, -sz)를 정규화해서 x, z만 저장한다.
+		XMVECTOR invLen = XMVectorReciprocalSqrt(sx * sx + sz * sz + XMVectorReplicate(1.0f));
+		Store(&mNormalX[base + j], -(sx * invLen));
+		Store(&mNormalZ[base + j], -(sz * invLen));
+	}
+}
+
+void SpectralOcean::Update(float dt)
+{
+	mTime += dt;
+	Evaluate(mTime);
+}
+
+void SpectralOcean::Evaluate(float time)
+{
+	mTime = time;
+
+	const int n = mN;
+	const int strips = (n + StripCols - 1) / StripCols;
+	const int transposeBlocks = (n + TransposeRows - 1) / TransposeRows;
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+
+	ParallelFor(scheduler, 0, n, [&](int a) { UpdateSpectrumRow(time, a); });
+
+	auto FftPass = [&]() {
+		ParallelFor(scheduler, 0, FieldCount * strips, [&](int task) {
+			int field = task / strips;
+			int c0 = (task % strips) * StripCols;
+			FftColumns(field, c0, std::min<int>(c0 + StripCols, n));
+		}, 1);
+	};
+	auto TransposePass = [&]() {
+		ParallelFor(scheduler, 0, FieldCount * transposeBlocks, [&](int task) {
+			int field = task / transposeBlocks;
+			int r0 = (task % transposeBlocks) * TransposeRows;
+			Transpose(field, r0, std::min<int>(r0 + TransposeRows, n));
+		}, 1);
+		for (auto f : Range(0, FieldCount))
+		{
+			std::swap(mFieldRe[f], mScratchRe[f]);
+			std::swap(mFieldIm[f], mScratchIm[f]);
+		}
+	};
+
+	// kx 방향 -> 전치 -> kz 방향. 스펙트럼을 [kx][kz]로 뒀으므로 결과는 [i][j]이다.
+	FftPass();
+	TransposePass();
+	FftPass();
+
+	ParallelFor(scheduler, 0, n, [&](int i) { ResolveRow(i); });
+}
+
+XMFLOAT3 SpectralOcean::Position(int i)const
+{
+	int row = i / mN;
+	int col = i - row*mN;
+	return XMFLOAT3(-mHalfSize + col*mDx + mDispX[i], mHeights[i], mHalfSize - row*mDx + mDispZ[i]);
+}
+
+XMFLOAT3 SpectralOcean::Normal(int i)const
+{
+	float x = mNormalX[i];
+	float z = mNormalZ[i];
+	return XMFLOAT3(x, sqrtf(std::max<float>(1.0f - x*x - z*z, 0.0f)), z);
+}
+
+void SpectralOcean::ExportVertices(void* dst, const WaveVertexFormat& format)const
+{
+	WaveVertexSource source;
+	source.Rows = mN;
+	source.Cols = mN;
+	source.X0 = -mHalfSize;
+	source.Z0 = mHalfSize;
+	source.SpatialStep = mDx;
+	source.Width = Width();
+	source.Depth = Depth();
+	source.Heights = mHeights.data();
+	source.NormalX = mNormalX.data();
+	source.NormalZ = mNormalZ.data();
+	source.DispX = mDispX.data();
+	source.DispZ = mDispZ.data();
+
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+	ParallelFor(scheduler, 0, (mN + StripCols - 1) / StripCols, [&](int band) {
+		WriteWaveVertexRows(source, format, band*StripCols, std::min<int>((band + 1)*StripCols, mN), dst);
+	}, 1);
+}
+
+XMFLOAT3 SpectralOcean::TangentX(int i)const
+{
+	XMFLOAT3 tangent(1.0f, mSlopeX[i], 0.0f);
+	XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&tangent)));
+	return tangent;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+class TaskScheduler;
+struct WaveVertexFormat;
+
+// Tessendorf 방식의 스펙트럼 바다. 처음에 Phillips나 JONSWAP 스펙트럼으로 h0(k)를 한 번 만들고,
+// 매 프레임 h(k, t)에서 높이, 수평 변위(choppy), 기울기를 역 FFT로 구한다.
+// 주기 경계라 한 변 점 수는 2의 거듭제곱이고, 정점 배치와 접근 함수는 Waves와 같다.
+// (x = -w/2 + j*dx, z = d/2 - i*dx, 정점 번호 = i*n + j)
+class SpectralOcean
+{
+public:
+	enum class Spectrum
+	{
+		Phillips,
+		Jonswap,
+	};
+
+	struct Desc
+	{
+		int Size = 128;				// 한 변 점 수. 2의 거듭제곱
+		float PatchSize = 128.0f;	// 한 변 길이(m)
+		float WindSpeed = 10.0f;	// m/s
+		DirectX::XMFLOAT2 WindDir = { 1.0f, 0.5f };
+		Spectrum Type = Spectrum::Phillips;
+		float Amplitude = 2e-6f;	// Phillips 상수 A
+		float Fetch = 50000.0f;		// JONSWAP 취송 거리(m)
+		float PeakEnhancement = 3.3f;	// JONSWAP 감마
+		float Choppiness = 1.0f;	// 수평 변위 배율. 0이면 높이만 움직인다.
+		std::uint32_t Seed = 1;
+	};
+
+public:
+	explicit SpectralOcean(const Desc& desc);
+	SpectralOcean(const SpectralOcean& rhs) = delete;
+	SpectralOcean& operator=(const SpectralOcean& rhs) = delete;
+
+	int RowCount()const { return mN; }
+	int ColumnCount()const { return mN; }
+	int VertexCount()const { return mN*mN; }
+	int TriangleCount()const { return (mN - 1)*(mN - 1) * 2; }
+	float Width()const { return mN*mDx; }
+	float Depth()const { return mN*mDx; }
+	float SpatialStep()const { return mDx; }
+	float Time()const { return mTime; }
+
+	DirectX::XMFLOAT3 Position(int i)const;
+	DirectX::XMFLOAT3 Normal(int i)const;
+	DirectX::XMFLOAT3 TangentX(int i)const;
+	float Height(int i)const { return mHeights[i]; }
+	const float* Heights()const { return mHeights.data(); }
+	// 매핑된 정점 버퍼 dst에 format 배치로 모든 정점을 바로 쓴다. 매 갱신마다 모든 점이 움직인다.
+	void ExportVertices(void* dst, const WaveVertexFormat& format)const;
+
+	// 시간을 dt만큼 진행하고 그 시각의 바다를 구한다.
+	void Update(float dt);
+	void Evaluate(float time);
+
+	void SetChoppiness(float choppiness) { mChoppiness = choppiness; }
+	// 갱신에 쓸 스레드 풀. nullptr이면 TaskScheduler::Default()를 쓴다.
+	void SetScheduler(TaskScheduler* scheduler) { mScheduler = scheduler; }
+
+private:
+	// 역 FFT 세 번으로 실수 다섯 개를 얻는다. 에르미트 스펙트럼 둘을 A + iB로 묶으면 결과가 a + ib로 나온다.
+	// 0: 높이 + i 변위x, 1: 변위z + i 기울기x, 2: 기울기z
+	static constexpr int FieldCount = 3;
+
+	void BuildSpectrum(const Desc& desc);
+	void UpdateSpectrumRow(float time, int a);
+	void FftColumns(int field, int c0, int c1);
+	void Transpose(int field, int r0, int r1);
+	void ResolveRow(int i);
+
+private:
+	int mN = 0;
+	int mLogN = 0;
+	float mDx = 1.0f;
+	float mHalfSize = 0.0f;
+	float mChoppiness = 1.0f;
+	float mTime = 0.0f;
+
+	// 스펙트럼은 [kx 번호][kz 번호]로 둔다. 열 방향 FFT, 전치, 열 방향 FFT를 거치면 [행 i][열 j]로 나온다.
+	std::vector<float> mH0Re;		// h0(k)
+	std::vector<float> mH0Im;
+	std::vector<float> mH0ConjRe;	// conj(h0(-k))
+	std::vector<float> mH0ConjIm;
+	std::vector<float> mOmega;		// 깊은 물 분산 관계 sqrt(g|k|)
+	std::vector<float> mKx;
+	std::vector<float> mKz;
+	std::vector<float> mKxOverK;
+	std::vector<float> mKzOverK;
+
+	std::vector<float> mFieldRe[FieldCount];
+	std::vector<float> mFieldIm[FieldCount];
+	std::vector<float> mScratchRe[FieldCount];
+	std::vector<float> mScratchIm[FieldCount];
+	std::vector<int> mBitReverse;
+	std::vector<float> mTwiddleRe;	// e^{+2πik/N}, k < N/2
+	std::vector<float> mTwiddleIm;
+
+	std::vector<float> mHeights;
+	std::vector<float> mDispX;
+	std::vector<float> mDispZ;
+	std::vector<float> mSlopeX;
+	std::vector<float> mNormalX;
+	std::vector<float> mNormalZ;
+
+	TaskScheduler* mScheduler = nullptr;
+};
@@ -0,0 +1,201 @@
+#include "TaskScheduler.h"
+#include <cassert>
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+	// 지금 스레드가 어느 스케줄러의 몇 번 작업자인지. 작업자가 아니면 -1
+	thread_local const TaskScheduler* tScheduler = nullptr;
+	thread_local int tWorkerIndex = -1;
+
+	void PinCurrentThread(int core)
+	{
+		unsigned int coreCount = std::max<unsigned int>(std::thread::hardware_concurrency(), 1u);
+		core = static_cast<int>(core % coreCount);
+#if defined(_WIN32)
+		SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << (core % 64));
+#else
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(core, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+	}
+}
+
+TaskScheduler::TaskScheduler(const Desc& desc)
+{
+	int threadCount = desc.ThreadCount;
+	if (threadCount <= 0)
+		threadCount = std::max<int>(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+	const int workerCount = threadCount - 1;
+	for (int i = 0; i < workerCount + 1; ++i)
+		mQueues.emplace_back(std::make_unique<WorkQueue>());
+
+	mWorkers.reserve(workerCount);
+	for (int i = 0; i < workerCount; ++i)
+	{
+		bool pin = desc.PinThreads;
+		mWorkers.emplace_back([this, i, pin] {
+			if (pin)
+				PinCurrentThread(i + 1);
+			WorkerMain(i);
+		});
+	}
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStop = true;
+	}
+	mSleepCv.notify_all();
+
+	for (auto& worker : mWorkers)
+		worker.join();
+}
+
+TaskScheduler& TaskScheduler::Default()
+{
+	static TaskScheduler scheduler(Desc{});
+	return scheduler;
+}
+
+void TaskScheduler::Push(std::function<void()>&& task)
+{
+	int index = (tScheduler == this) ? tWorkerIndex : static_cast<int>(mWorkers.size());
+	{
+		WorkQueue& queue = *mQueues[index];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.emplace_back(std::move(task));
+	}
+	mQueuedCount.fetch_add(1, std::memory_order_release);
+
+	//잠든 작업자가 조건을 확인하는 사이에 깨우는 신호가 지나가지 않도록 잠금을 한 번 거친다.
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+	}
+	mSleepCv.notify_one();
+}
+
+bool TaskScheduler::PopLocal(int index, std::function<void()>& task)
+{
+	WorkQueue& queue = *mQueues[index];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	return true;
+}
+
+bool TaskScheduler::PopShared(std::function<void()>& task)
+{
+	WorkQueue& queue = *mQueues.back();
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	task = std::move(queue.Tasks.front());
+	queue.Tasks.pop_front();
+	return true;
+}
+
+bool TaskScheduler::Steal(int thief, std::function<void()>& task)
+{
+	const int workerCount = static_cast<int>(mWorkers.size());
+	for (int k = 1; k <= workerCount; ++k)
+	{
+		int victim = (thief + k) % (workerCount + 1);
+		if (victim == workerCount)
+			continue;
+
+		WorkQueue& queue = *mQueues[victim];
+		std::unique_lock<std::mutex> lock(queue.Mutex, std::try_to_lock);
+		if (!lock.owns_lock() || queue.Tasks.empty())
+			continue;
+
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		return true;
+	}
+	return false;
+}
+
+bool TaskScheduler::RunOne()
+{
+	if (mQueuedCount.load(std::memory_order_acquire) == 0)
+		return false;
+
+	const int self = (tScheduler == this) ? tWorkerIndex : static_cast<int>(mWorkers.size());
+	std::function<void()> task;
+	bool found = (self < static_cast<int>(mWorkers.size()) && PopLocal(self, task)) ||
+		PopShared(task) || Steal(self, task);
+	if (!found)
+		return false;
+
+	mQueuedCount.fetch_sub(1, std::memory_order_relaxed);
+	task();
+	return true;
+}
+
+void TaskScheduler::WorkerMain(int index)
+{
+	tScheduler = this;
+	tWorkerIndex = index;
+
+	while (true)
+	{
+		if (RunOne())
+			continue;
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepCv.wait(lock, [this] { return mStop || mQueuedCount.load(std::memory_order_acquire) > 0; });
+		if (mStop)
+			break;
+	}
+
+	tScheduler = nullptr;
+	tWorkerIndex = -1;
+}
+
+TaskGroup::~TaskGroup()
+{
+	while (mPending.load(std::memory_order_acquire) > 0)
+	{
+		if (!mScheduler.RunOne())
+			std::this_thread::yield();
+	}
+}
+
+void TaskGroup::Wait()
+{
+	while (mPending.load(std::memory_order_acquire) > 0)
+	{
+		if (!mScheduler.RunOne())
+			std::this_thread::yield();
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock(mExceptionMutex);
+		std::swap(exception, mException);
+	}
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+void TaskGroup::SetException(std::exception_ptr exception)
+{
+	std::lock_guard<std::mutex> lock(mExceptionMutex);
+	if (!mException)
+		mException = exception;
+}
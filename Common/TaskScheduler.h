@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 작업 훔치기(work stealing) 방식의 스레드 풀. 표준 라이브러리만 써서 윈도우 밖에서도 빌드된다.
+// 작업자마다 덱을 하나씩 두고, 자기 덱은 뒤에서(LIFO) 꺼내고 남의 덱은 앞에서(FIFO) 훔친다.
+// 작업자가 아닌 스레드가 넣은 작업은 공용 큐로 들어간다.
+// 기다리는 스레드도 놀지 않고 남은 작업을 같이 처리하므로 중첩해서 불러도 막히지 않는다.
+class TaskScheduler
+{
+public:
+	struct Desc
+	{
+		int ThreadCount = 0;		// 부르는 스레드를 포함한 수. 0이면 하드웨어 스레드 수
+		// 작업자 i(0부터)를 코어 i + 1에 묶는다. 0번 코어는 부르는 스레드 몫으로 비워 두기만 하고
+		// 부르는 스레드는 묶지 않는다. 렌더 스레드처럼 오래 사는 스레드를 몰래 묶지 않으려는 것이므로
+		// 부르는 스레드까지 묶으려면 부르는 쪽에서 직접 묶는다.
+		bool PinThreads = false;
+	};
+
+public:
+	explicit TaskScheduler(const Desc& desc);
+	TaskScheduler(const TaskScheduler& rhs) = delete;
+	TaskScheduler& operator=(const TaskScheduler& rhs) = delete;
+	~TaskScheduler();
+
+	// 처음 부를 때 하드웨어 스레드 수로 만든다.
+	static TaskScheduler& Default();
+
+	int ThreadCount() const { return static_cast<int>(mWorkers.size()) + 1; }
+	// 덩어리 크기를 정하지 않았을 때 스레드마다 네 덩어리쯤 돌아가게 나눈다.
+	int DefaultGrain(int count) const { return std::max<int>(1, count / (ThreadCount() * 4)); }
+
+	void Push(std::function<void()>&& task);
+	// 할 일이 있으면 하나 처리하고 true를 돌려준다.
+	bool RunOne();
+
+private:
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<std::function<void()>> Tasks;
+	};
+
+	void WorkerMain(int index);
+	bool PopLocal(int index, std::function<void()>& task);
+	bool PopShared(std::function<void()>& task);
+	bool Steal(int thief, std::function<void()>& task);
+
+private:
+	std::vector<std::thread> mWorkers;
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;	// 작업자 수 + 공용 큐 하나(마지막)
+	std::atomic<int> mQueuedCount{ 0 };
+	std::atomic<bool> mStop{ false };
+
+	std::mutex mSleepMutex;
+	std::condition_variable mSleepCv;
+};
+
+// 같이 기다릴 작업 묶음. Wait는 남은 작업을 직접 돕고, 작업에서 난 첫 예외를 다시 던진다.
+class TaskGroup
+{
+public:
+	explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::Default()) : mScheduler(scheduler) {}
+	TaskGroup(const TaskGroup& rhs) = delete;
+	TaskGroup& operator=(const TaskGroup& rhs) = delete;
+	~TaskGroup();
+
+	template<typename Fn>
+	void Run(Fn&& fn)
+	{
+		mPending.fetch_add(1, std::memory_order_relaxed);
+		mScheduler.Push([this, fn = std::forward<Fn>(fn)]() mutable {
+			try { fn(); }
+			catch (...) { SetException(std::current_exception()); }
+			mPending.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	void Wait();
+
+private:
+	void SetException(std::exception_ptr exception);
+
+private:
+	TaskScheduler& mScheduler;
+	std::atomic<int> mPending{ 0 };
+	std::mutex mExceptionMutex;
+	std::exception_ptr mException;
+};
+
+// [begin, end)를 grain개씩 나눠 fn(i)를 부른다. 첫 덩어리는 부르는 스레드가 맡는다.
+template<typename Fn>
+void ParallelFor(TaskScheduler& scheduler, int begin, int end, Fn&& fn, int grain = 0)
+{
+	const int count = end - begin;
+	if (count <= 0)
+		return;
+	if (grain <= 0)
+		grain = scheduler.DefaultGrain(count);
+
+	if (count <= grain || scheduler.ThreadCount() == 1)
+	{
+		for (int i = begin; i < end; ++i)
+			fn(i);
+		return;
+	}
+
+	TaskGroup group(scheduler);
+	for (int first = begin + grain; first < end; first += grain)
+	{
+		int last = std::min<int>(first + grain, end);
+		group.Run([&fn, first, last] {
+			for (int i = first; i < last; ++i)
+				fn(i);
+		});
+	}
+
+	for (int i = begin; i < begin + grain; ++i)
+		fn(i);
+	group.Wait();
+}
+
+template<typename Fn>
+void ParallelFor(int begin, int end, Fn&& fn, int grain = 0)
+{
+	ParallelFor(TaskScheduler::Default(), begin, end, std::forward<Fn>(fn), grain);
+}
+
+// 덩어리마다 map(i)를 reduce로 모은 뒤 덩어리 순서대로 합친다. 스레드 수와 상관없이 합치는 순서가 같다.
+template<typename T, typename Map, typename Reduce>
+T ParallelReduce(TaskScheduler& scheduler, int begin, int end, T identity, Map&& map, Reduce&& reduce, int grain = 0)
+{
+	const int count = end - begin;
+	if (count <= 0)
+		return identity;
+	if (grain <= 0)
+		grain = scheduler.DefaultGrain(count);
+
+	const int chunkCount = (count + grain - 1) / grain;
+	std::vector<T> partials(chunkCount, identity);
+	ParallelFor(scheduler, 0, chunkCount, [&](int chunk) {
+		int first = begin + chunk * grain;
+		int last = std::min<int>(first + grain, end);
+		T acc = identity;
+		for (int i = first; i < last; ++i)
+			acc = reduce(acc, map(i));
+		partials[chunk] = acc;
+	}, 1);
+
+	T result = identity;
+	for (auto& partial : partials)
+		result = reduce(result, partial);
+	return result;
+}
+
+template<typename T, typename Map, typename Reduce>
+T ParallelReduce(int begin, int end, T identity, Map&& map, Reduce&& reduce, int grain = 0)
+{
+	return ParallelReduce(TaskScheduler::Default(), begin, end, identity,
+		std::forward<Map>(map), std::forward<Reduce>(reduce), grain);
+}
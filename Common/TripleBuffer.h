@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+// 쓰는 스레드 하나와 읽는 스레드 하나가 잠금 없이 값을 주고받는 삼중 버퍼.
+// 쓰는 쪽은 뒤 버퍼를 채우고 Publish로 가운데와 바꾸고, 읽는 쪽은 새 값이 있을 때만 앞 버퍼와 가운데를 바꾼다.
+// 어느 쪽도 상대를 기다리지 않으며, 읽는 쪽은 항상 가장 최근에 끝난 값을 본다.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer& rhs) = delete;
+	TripleBuffer& operator=(const TripleBuffer& rhs) = delete;
+
+	// 쓰는 스레드 전용
+	T& WriteBuffer() { return mSlots[mBack]; }
+	void Publish()
+	{
+		int prev = mMiddle.exchange(mBack | FreshBit, std::memory_order_acq_rel);
+		mBack = prev & IndexMask;
+	}
+
+	// 읽는 스레드 전용. 새로 나온 값으로 바꿨으면 true
+	bool Acquire()
+	{
+		if ((mMiddle.load(std::memory_order_relaxed) & FreshBit) == 0)
+			return false;
+
+		int prev = mMiddle.exchange(mFront, std::memory_order_acq_rel);
+		mFront = prev & IndexMask;
+		return true;
+	}
+	const T& ReadBuffer() const { return mSlots[mFront]; }
+
+	// 두 스레드가 돌기 전에 세 칸을 같은 값으로 맞출 때 쓴다.
+	template<typename Fn>
+	void ForEachSlot(Fn&& fn)
+	{
+		for (auto& slot : mSlots)
+			fn(slot);
+	}
+
+private:
+	static constexpr int IndexMask = 0x3;
+	static constexpr int FreshBit = 0x4;
+
+	T mSlots[3]{};
+	int mFront = 0;
+	std::atomic<int> mMiddle{ 1 };
+	int mBack = 2;
+};
@@ -56,6 +56,12 @@ public:
     {
         memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
     }
+
+    // 여러 원소를 한 번에 채울 때 매핑된 메모리에 바로 쓴다. 읽으면 느리므로 쓰기만 한다.
+    BYTE* MappedData()const
+    {
+        return mMappedData;
+    }
     
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
@@ -0,0 +1,141 @@
+#include "WaveChunks.h"
+#include "TaskScheduler.h"
+#include "MathHelper.h"
+#include "Util.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace DirectX;
+
+WaveChunks::WaveChunks(int rows, int cols, float dx, int chunkQuads)
+	: mRows(rows), mCols(cols), mDx(dx)
+{
+	assert(rows >= 2 && cols >= 2);
+	assert(chunkQuads >= 1 && (chunkQuads + 1) * (chunkQuads + 1) <= 0x10000);
+
+	float halfWidth = (cols - 1) * dx * 0.5f;
+	float halfDepth = (rows - 1) * dx * 0.5f;
+	for (int row0 = 0; row0 < rows - 1; row0 += chunkQuads)
+	{
+		for (int col0 = 0; col0 < cols - 1; col0 += chunkQuads)
+		{
+			Chunk chunk;
+			chunk.Row0 = row0;
+			chunk.Col0 = col0;
+			chunk.Rows = std::min<int>(chunkQuads, rows - 1 - row0) + 1;
+			chunk.Cols = std::min<int>(chunkQuads, cols - 1 - col0) + 1;
+			chunk.BaseVertex = mVertexCount;
+			chunk.IndexSet = FindOrAddIndexSet(chunk.Rows, chunk.Cols);
+
+			float x0 = -halfWidth + col0 * dx;
+			float x1 = -halfWidth + (col0 + chunk.Cols - 1) * dx;
+			float z0 = halfDepth - (row0 + chunk.Rows - 1) * dx;
+			float z1 = halfDepth - row0 * dx;
+			chunk.Bounds.Center = XMFLOAT3(0.5f * (x0 + x1), 0.0f, 0.5f * (z0 + z1));
+			chunk.Bounds.Extents = XMFLOAT3(0.5f * (x1 - x0), 0.0f, 0.5f * (z1 - z0));
+
+			mVertexCount += chunk.Rows * chunk.Cols;
+			mChunks.emplace_back(chunk);
+		}
+	}
+}
+
+UINT WaveChunks::FindOrAddIndexSet(int rows, int cols)
+{
+	for (auto i : Range(0, static_cast<int>(mIndexSetShapes.size())))
+	{
+		if (mIndexSetShapes[i].x == rows && mIndexSetShapes[i].y == cols)
+			return i;
+	}
+
+	IndexRange range;
+	range.StartIndex = static_cast<UINT>(mIndices.size());
+	range.IndexCount = (rows - 1) * (cols - 1) * 6;
+	for (int i = 0; i < rows - 1; ++i)
+	{
+		for (int j = 0; j < cols - 1; ++j)
+		{
+			//Waves 앱들과 같은 대각선으로 나눈다.
+			mIndices.emplace_back(static_cast<std::uint16_t>(i * cols + j));
+			mIndices.emplace_back(static_cast<std::uint16_t>(i * cols + j + 1));
+			mIndices.emplace_back(static_cast<std::uint16_t>((i + 1) * cols + j));
+
+			mIndices.emplace_back(static_cast<std::uint16_t>((i + 1) * cols + j));
+			mIndices.emplace_back(static_cast<std::uint16_t>(i * cols + j + 1));
+			mIndices.emplace_back(static_cast<std::uint16_t>((i + 1) * cols + j + 1));
+		}
+	}
+
+	mIndexSets.emplace_back(range);
+	mIndexSetShapes.emplace_back(XMINT2(rows, cols));
+	return static_cast<UINT>(mIndexSets.size() - 1);
+}
+
+void WaveChunks::UpdateBounds(const float* heights, const std::uint64_t* rowRevisions)
+{
+	//같은 줄의 조각은 행이 같으므로 줄마다 한 번만 행 Revision을 훑는다.
+	mDirtyChunks.clear();
+	int bandRow0 = -1;
+	std::uint64_t bandRevision = 0;
+	for (auto i : Range(0, static_cast<int>(mChunks.size())))
+	{
+		Chunk& chunk = mChunks[i];
+		if (chunk.Row0 != bandRow0)
+		{
+			bandRow0 = chunk.Row0;
+			bandRevision = *std::max_element(rowRevisions + chunk.Row0, rowRevisions + chunk.Row0 + chunk.Rows);
+		}
+		if (bandRevision <= chunk.Revision)
+			continue;
+
+		chunk.Revision = bandRevision;
+		mDirtyChunks.emplace_back(i);
+	}
+
+	ParallelFor(0, static_cast<int>(mDirtyChunks.size()), [&](int k) {
+		RefitBounds(mChunks[mDirtyChunks[k]], heights);
+	});
+}
+
+void WaveChunks::RefitBounds(Chunk& chunk, const float* heights)
+{
+	XMVECTOR vMin = XMVectorReplicate(+MathHelper::Infinity);
+	XMVECTOR vMax = XMVectorReplicate(-MathHelper::Infinity);
+	float minH = +MathHelper::Infinity;
+	float maxH = -MathHelper::Infinity;
+	for (int r = 0; r < chunk.Rows; ++r)
+	{
+		const float* row = heights + (chunk.Row0 + r) * mCols + chunk.Col0;
+		int j = 0;
+		for (; j + 4 <= chunk.Cols; j += 4)
+		{
+			XMVECTOR h = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + j));
+			vMin = XMVectorMin(vMin, h);
+			vMax = XMVectorMax(vMax, h);
+		}
+		for (; j < chunk.Cols; ++j)
+		{
+			minH = std::min<float>(minH, row[j]);
+			maxH = std::max<float>(maxH, row[j]);
+		}
+	}
+
+	XMFLOAT4 lo, hi;
+	XMStoreFloat4(&lo, vMin);
+	XMStoreFloat4(&hi, vMax);
+	minH = std::min<float>(minH, std::min<float>(std::min<float>(lo.x, lo.y), std::min<float>(lo.z, lo.w)));
+	maxH = std::max<float>(maxH, std::max<float>(std::max<float>(hi.x, hi.y), std::max<float>(hi.z, hi.w)));
+
+	chunk.Bounds.Center.y = 0.5f * (minH + maxH);
+	chunk.Bounds.Extents.y = 0.5f * (maxH - minH);
+}
+
+void WaveChunks::Cull(const BoundingFrustum& frustum, std::vector<UINT>& visible) const
+{
+	visible.clear();
+	for (auto i : Range(0, static_cast<int>(mChunks.size())))
+	{
+		if (frustum.Intersects(mChunks[i].Bounds))
+			visible.emplace_back(i);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+// 16비트 인덱스로 그릴 수 없는 큰 Waves 격자를 고정 크기 조각으로 나눠 그린다.
+// 조각마다 정점을 이어서 두고, 이웃 조각과 맞닿는 행과 열은 양쪽에 같은 값으로 넣어 틈이 생기지 않게 한다.
+// 인덱스는 조각 모양마다 한 벌만 만들고(격자 끝 조각만 작을 수 있다) 모든 조각이 BaseVertexLocation으로 나눠 쓴다.
+// 정점 배치는 Waves::Position과 같다. (x = -w/2 + j*dx, z = d/2 - i*dx)
+class WaveChunks
+{
+public:
+	struct IndexRange
+	{
+		UINT StartIndex = 0;
+		UINT IndexCount = 0;
+	};
+
+	struct Chunk
+	{
+		int Row0 = 0;		// 첫 정점의 격자 번호
+		int Col0 = 0;
+		int Rows = 0;		// 맞닿는 행, 열을 포함한 정점 수
+		int Cols = 0;
+		UINT BaseVertex = 0;
+		UINT IndexSet = 0;
+		DirectX::BoundingBox Bounds;
+		// 경계를 마지막으로 맞췄을 때 조각 행들의 가장 큰 Revision. 0이면 아직 맞추지 않았다.
+		std::uint64_t Revision = 0;
+	};
+
+public:
+	// chunkQuads는 조각 한 변의 칸 수. 정점 (chunkQuads + 1)^2개가 16비트 인덱스에 들어가야 한다.
+	WaveChunks(int rows, int cols, float dx, int chunkQuads = 64);
+	WaveChunks(const WaveChunks& rhs) = delete;
+	WaveChunks& operator=(const WaveChunks& rhs) = delete;
+
+	UINT ChunkCount() const { return static_cast<UINT>(mChunks.size()); }
+	UINT VertexCount() const { return mVertexCount; }
+	const Chunk& GetChunk(UINT chunk) const { return mChunks[chunk]; }
+	const IndexRange& GetIndexRange(UINT chunk) const { return mIndexSets[mChunks[chunk].IndexSet]; }
+	// 모든 조각 모양의 인덱스를 이어 붙인 것. 인덱스 버퍼 하나로 올린다.
+	const std::vector<std::uint16_t>& Indices() const { return mIndices; }
+
+	// heights는 격자 전체(rows*cols), rowRevisions는 행마다 마지막으로 바뀐 Revision(Waves::RowRevisions).
+	// 지난번 뒤로 행이 바뀐 조각만 y 범위를 다시 잡고 Revision을 올린다. 정점도 Revision이 바뀐 조각만 다시 쓰면 된다.
+	void UpdateBounds(const float* heights, const std::uint64_t* rowRevisions);
+	// 절두체는 격자 로컬 공간 기준
+	void Cull(const DirectX::BoundingFrustum& frustum, std::vector<UINT>& visible) const;
+
+private:
+	UINT FindOrAddIndexSet(int rows, int cols);
+	void RefitBounds(Chunk& chunk, const float* heights);
+
+private:
+	int mRows = 0;
+	int mCols = 0;
+	float mDx = 1.0f;
+	UINT mVertexCount = 0;
+
+	std::vector<Chunk> mChunks;
+	std::vector<IndexRange> mIndexSets;
+	std::vector<DirectX::XMINT2> mIndexSetShapes;	// (정점 행 수, 열 수)
+	std::vector<std::uint16_t> mIndices;
+	std::vector<UINT> mDirtyChunks;
+};
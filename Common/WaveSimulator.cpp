@@ -0,0 +1,129 @@
+#include "WaveSimulator.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+
+namespace
+{
+	// 한 번 깨어났을 때 밀린 단계를 따라잡는 최대 횟수. 넘으면 밀린 시간은 버린다.
+	constexpr int MaxCatchUpSteps = 4;
+	// 인스턴스가 없을 때도 가끔 깨어나 종료 요청을 확인한다.
+	constexpr auto IdleWait = std::chrono::milliseconds(50);
+}
+
+const WavesSnapshot& WaveSimulator::Instance::Latest()
+{
+	mSnapshots.Acquire();
+	return mSnapshots.ReadBuffer();
+}
+
+void WaveSimulator::Instance::Disturb(int i, int j, float magnitude)
+{
+	std::lock_guard<std::mutex> lock(mDisturbMutex);
+	mPendingDisturbs.emplace_back(Disturbance{ i, j, magnitude });
+}
+
+WaveSimulator::WaveSimulator(TaskScheduler* scheduler)
+	: mScheduler(scheduler)
+{
+	//렌더 쪽 기본 풀과 코어를 나눠 쓰므로 하드웨어 스레드의 절반만 쓴다. 시뮬레이션 스레드가 그중 하나다.
+	if (mScheduler == nullptr)
+	{
+		TaskScheduler::Desc desc;
+		desc.ThreadCount = std::max<int>(static_cast<int>(std::thread::hardware_concurrency()) / 2, 1);
+		mOwnScheduler = std::make_unique<TaskScheduler>(desc);
+		mScheduler = mOwnScheduler.get();
+	}
+
+	mThread = std::thread([this] { ThreadMain(); });
+}
+
+WaveSimulator::~WaveSimulator()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWakeCv.notify_all();
+	mThread.join();
+}
+
+WaveSimulator::Instance* WaveSimulator::Add(int m, int n, float dx, float dt, float speed, float damping)
+{
+	auto instance = std::make_unique<Instance>();
+	instance->mWaves = std::make_unique<Waves>(m, n, dx, dt, speed, damping);
+	instance->mWaves->SetScheduler(mScheduler);
+	instance->mRows = m;
+	instance->mCols = n;
+	instance->mPeriod = std::chrono::duration_cast<Instance::Clock::duration>(std::chrono::duration<float>(dt));
+	instance->mNextStep = Instance::Clock::now() + instance->mPeriod;
+
+	//시뮬레이션 스레드가 처음 끝내기 전에도 읽을 수 있도록 세 칸 모두 초기 상태로 채운다.
+	auto& waves = *instance->mWaves;
+	instance->mSnapshots.ForEachSlot([&](WavesSnapshot& snapshot) { waves.CopySnapshot(snapshot); });
+
+	Instance* result = instance.get();
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mInstances.emplace_back(std::move(instance));
+	}
+	mWakeCv.notify_all();
+	return result;
+}
+
+// 시간이 된 만큼 단계를 진행하고 결과를 내보낸다. 진행했으면 true
+bool WaveSimulator::Tick(Instance& instance, Instance::Clock::time_point now)
+{
+	{
+		std::lock_guard<std::mutex> lock(instance.mDisturbMutex);
+		std::swap(instance.mPendingDisturbs, instance.mApplyingDisturbs);
+	}
+	for (auto& d : instance.mApplyingDisturbs)
+		instance.mWaves->Disturb(d.I, d.J, d.Magnitude);
+	instance.mApplyingDisturbs.clear();
+
+	int steps = 0;
+	while (instance.mNextStep <= now && steps < MaxCatchUpSteps)
+	{
+		instance.mWaves->Step();
+		instance.mNextStep += instance.mPeriod;
+		steps++;
+	}
+	if (instance.mNextStep <= now)
+		instance.mNextStep = now + instance.mPeriod;
+
+	if (steps == 0)
+		return false;
+
+	instance.mWaves->CopySnapshot(instance.mSnapshots.WriteBuffer());
+	instance.mSnapshots.Publish();
+	return true;
+}
+
+void WaveSimulator::ThreadMain()
+{
+	std::vector<Instance*> instances;
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mStop)
+				break;
+			instances.clear();
+			for (auto& instance : mInstances)
+				instances.emplace_back(instance.get());
+		}
+
+		auto now = Instance::Clock::now();
+		ParallelFor(*mScheduler, 0, static_cast<int>(instances.size()), [&](int i) {
+			Tick(*instances[i], now);
+		}, 1);
+		mTickCount.fetch_add(1, std::memory_order_relaxed);
+
+		auto wakeTime = now + IdleWait;
+		for (auto instance : instances)
+			wakeTime = std::min<Instance::Clock::time_point>(wakeTime, instance->mNextStep);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWakeCv.wait_until(lock, wakeTime, [&] { return mStop || mInstances.size() != instances.size(); });
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Waves.h"
+#include "TripleBuffer.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class TaskScheduler;
+
+// Waves 여러 개를 전용 스레드에서 각자의 TimeStep 간격으로 돌린다.
+// 렌더 스레드는 Latest로 가장 최근에 끝난 단계를 삼중 버퍼에서 가져가므로
+// 프레임이 느려도 시뮬레이션이 밀리지 않고, 시뮬레이션이 느려도 프레임이 기다리지 않는다.
+class WaveSimulator
+{
+public:
+	class Instance
+	{
+	public:
+		// 렌더 스레드 전용. 다음 Latest를 부를 때까지 유효하다.
+		const WavesSnapshot& Latest();
+		// 다음 단계 전에 시뮬레이션 스레드에서 적용한다.
+		void Disturb(int i, int j, float magnitude);
+
+		int RowCount()const { return mRows; }
+		int ColumnCount()const { return mCols; }
+		int VertexCount()const { return mRows*mCols; }
+		int TriangleCount()const { return (mRows - 1)*(mCols - 1)*2; }
+
+	private:
+		friend class WaveSimulator;
+		using Clock = std::chrono::steady_clock;
+
+		struct Disturbance
+		{
+			int I = 0;
+			int J = 0;
+			float Magnitude = 0.0f;
+		};
+
+		std::unique_ptr<Waves> mWaves;
+		TripleBuffer<WavesSnapshot> mSnapshots;
+		int mRows = 0;
+		int mCols = 0;
+
+		std::mutex mDisturbMutex;
+		std::vector<Disturbance> mPendingDisturbs;
+		std::vector<Disturbance> mApplyingDisturbs;
+
+		Clock::duration mPeriod{};
+		Clock::time_point mNextStep{};
+	};
+
+public:
+	// 여러 인스턴스는 scheduler에서 나란히 돌린다. nullptr이면 전용 스레드 풀을 따로 만든다.
+	// TaskScheduler::Default()를 나눠 쓰면 렌더 스레드가 기다리면서 시뮬레이션 작업을 집어 들어
+	// 프레임이 시뮬레이션 한 단계만큼 늘어질 수 있다.
+	explicit WaveSimulator(TaskScheduler* scheduler = nullptr);
+	WaveSimulator(const WaveSimulator& rhs) = delete;
+	WaveSimulator& operator=(const WaveSimulator& rhs) = delete;
+	~WaveSimulator();
+
+	// 인자는 Waves 생성자와 같다. 돌려준 포인터는 WaveSimulator가 살아 있는 동안 유효하다.
+	Instance* Add(int m, int n, float dx, float dt, float speed, float damping);
+
+	std::uint64_t TickCount()const { return mTickCount.load(std::memory_order_relaxed); }
+
+private:
+	void ThreadMain();
+	bool Tick(Instance& instance, Instance::Clock::time_point now);
+
+private:
+	std::unique_ptr<TaskScheduler> mOwnScheduler;
+	TaskScheduler* mScheduler = nullptr;
+	std::vector<std::unique_ptr<Instance>> mInstances;
+
+	std::mutex mMutex;
+	std::condition_variable mWakeCv;
+	bool mStop = false;
+	std::atomic<std::uint64_t> mTickCount{ 0 };
+
+	std::thread mThread;
+};
@@ -0,0 +1,159 @@
+#include "WaveVertexWriter.h"
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// 한 번에 모으는 정점 수. 가장 큰 정점(MaxStride)으로도 L1에 넉넉히 들어간다.
+	constexpr int BlockVertices = 32;
+	constexpr int MaxStride = 64;
+
+	// 법선의 y는 항상 양수라서 윗반구만 8면체에 펼치면 된다. (x, z) / (|x| + y + |z|)
+	// 복원은 n = normalize(e.x, 1 - |e.x| - |e.y|, e.y)
+	void EncodeOctNormal(float x, float y, float z, std::int8_t* out)
+	{
+		float invL1 = 1.0f / (fabsf(x) + y + fabsf(z));
+		out[0] = static_cast<std::int8_t>(lrintf(std::min<float>(std::max<float>(x*invL1, -1.0f), 1.0f) * 127.0f));
+		out[1] = static_cast<std::int8_t>(lrintf(std::min<float>(std::max<float>(z*invL1, -1.0f), 1.0f) * 127.0f));
+	}
+
+	// 캐시를 거치지 않고 16바이트씩 이어 쓴다. 업로드 힙은 write-combining이라 읽어 오지 않고
+	// 줄 단위로 모아서 내보내는 편이 빠르다. 앞뒤 정렬이 안 맞는 부분만 보통 복사로 쓴다.
+	void StreamCopy(std::uint8_t* dst, const std::uint8_t* src, size_t bytes)
+	{
+#if defined(_XM_SSE_INTRINSICS_)
+		size_t head = std::min<size_t>((16 - (reinterpret_cast<std::uintptr_t>(dst) & 15)) & 15, bytes);
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		bytes -= head;
+		for (; bytes >= 16; bytes -= 16, dst += 16, src += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(dst), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+#endif
+		memcpy(dst, src, bytes);
+	}
+
+	// 격자 [r0, r1) x [c0, c1)의 정점 (i, j)를 dst의 (i - dstRow0)*dstPitch + (j - dstCol0)번 자리에 쓴다.
+	void WriteRect(const WaveVertexSource& source, const WaveVertexFormat& format,
+		int r0, int r1, int c0, int c1, void* dst, int dstRow0, int dstCol0, int dstPitch)
+	{
+		const int stride = static_cast<int>(format.Stride);
+		assert(stride > 0 && stride <= MaxStride);
+
+		alignas(16) std::uint8_t staging[BlockVertices * MaxStride];
+		if (format.Prototype != nullptr)
+		{
+			for (int k = 0; k < BlockVertices; ++k)
+				memcpy(staging + k*stride, format.Prototype, stride);
+		}
+		else
+			memset(staging, 0, sizeof(staging));
+
+		const int n = source.Cols;
+		const float dx = source.SpatialStep;
+		const float invWidth = 1.0f / source.Width;
+		const float invDepth = 1.0f / source.Depth;
+		const XMVECTOR one = XMVectorReplicate(1.0f);
+		alignas(16) float normalY[BlockVertices];
+		const bool needNormalY = format.NormalOffset >= 0 || format.OctNormalOffset >= 0;
+
+		std::uint8_t* base = static_cast<std::uint8_t*>(dst);
+		for (int i = r0; i < r1; ++i)
+		{
+			const float z0 = source.Z0 - i*dx;
+			for (int c = c0; c < c1; c += BlockVertices)
+			{
+				const int count = std::min<int>(BlockVertices, c1 - c);
+				const int first = i*n + c;
+
+				if (needNormalY)
+				{
+					const float* nx = source.NormalX + first;
+					const float* nz = source.NormalZ + first;
+					int k = 0;
+					for (; k + 4 <= count; k += 4)
+					{
+						XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(nx + k));
+						XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(nz + k));
+						XMVECTOR y2 = XMVectorMax(one - x * x - z * z, XMVectorZero());
+						XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(normalY + k), XMVectorSqrt(y2));
+					}
+					for (; k < count; ++k)
+						normalY[k] = sqrtf(std::max<float>(1.0f - nx[k]*nx[k] - nz[k]*nz[k], 0.0f));
+				}
+
+				for (int k = 0; k < count; ++k)
+				{
+					const int idx = first + k;
+					std::uint8_t* v = staging + k*stride;
+
+					float x = source.X0 + (c + k)*dx;
+					float z = z0;
+					if (source.DispX != nullptr)
+					{
+						x += source.DispX[idx];
+						z += source.DispZ[idx];
+					}
+
+					if (format.PositionOffset >= 0)
+					{
+						const float pos[3] = { x, source.Heights[idx], z };
+						memcpy(v + format.PositionOffset, pos, sizeof(pos));
+					}
+					if (format.NormalOffset >= 0)
+					{
+						const float normal[3] = { source.NormalX[idx], normalY[k], source.NormalZ[idx] };
+						memcpy(v + format.NormalOffset, normal, sizeof(normal));
+					}
+					if (format.TexCOffset >= 0)
+					{
+						const float texC[2] = { 0.5f + x*invWidth, 0.5f - z*invDepth };
+						memcpy(v + format.TexCOffset, texC, sizeof(texC));
+					}
+					if (format.PositionXZOffset >= 0)
+					{
+						const float xz[2] = { x, z };
+						memcpy(v + format.PositionXZOffset, xz, sizeof(xz));
+					}
+					if (format.HalfHeightOffset >= 0)
+					{
+						const PackedVector::HALF height = PackedVector::XMConvertFloatToHalf(source.Heights[idx]);
+						memcpy(v + format.HalfHeightOffset, &height, sizeof(height));
+					}
+					if (format.OctNormalOffset >= 0)
+					{
+						std::int8_t oct[2];
+						EncodeOctNormal(source.NormalX[idx], normalY[k], source.NormalZ[idx], oct);
+						memcpy(v + format.OctNormalOffset, oct, sizeof(oct));
+					}
+				}
+
+				const size_t dstIndex = static_cast<size_t>(i - dstRow0)*dstPitch + (c - dstCol0);
+				StreamCopy(base + dstIndex*stride, staging, static_cast<size_t>(count)*stride);
+			}
+		}
+
+#if defined(_XM_SSE_INTRINSICS_)
+		// 스트리밍 저장이 GPU에 넘기기 전에 모두 보이도록 한다.
+		_mm_sfence();
+#endif
+	}
+}
+
+void WriteWaveVertexRows(const WaveVertexSource& source, const WaveVertexFormat& format,
+	int r0, int r1, void* dst)
+{
+	WriteRect(source, format, r0, r1, 0, source.Cols, dst, 0, 0, source.Cols);
+}
+
+void WriteWaveVertexRect(const WaveVertexSource& source, const WaveVertexFormat& format,
+	int r0, int r1, int c0, int c1, void* dst)
+{
+	WriteRect(source, format, r0, r1, c0, c1, dst, r0, c0, c1 - c0);
+}
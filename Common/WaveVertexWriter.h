@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// 앱의 정점 구조에서 각 성분이 놓인 자리. 오프셋이 -1인 성분은 쓰지 않는다.
+// 예) format.Stride = sizeof(Vertex); format.NormalOffset = offsetof(Vertex, Normal);
+struct WaveVertexFormat
+{
+	std::uint32_t Stride = 0;
+	int PositionOffset = 0;		// XMFLOAT3
+	int NormalOffset = -1;		// XMFLOAT3
+	int TexCOffset = -1;		// XMFLOAT2. 위치에서 [-w/2, w/2] -> [0, 1]로 구한다.
+	int PositionXZOffset = -1;	// XMFLOAT2 (x, z). 높이를 따로 보낼 때 한 번만 만드는 고정 격자용
+	int HalfHeightOffset = -1;	// uint16. 높이를 half float로 줄인다.
+	int OctNormalOffset = -1;	// int8 x 2. 윗반구 8면체로 접은 법선(snorm)
+	// 모든 정점에 먼저 깔아 둘 정점 하나. 색처럼 바뀌지 않는 성분을 채울 때 쓴다.
+	const void* Prototype = nullptr;
+};
+
+// 격자 정점을 만드는 데 필요한 SoA 배열과 배치. (x = X0 + j*dx + DispX, z = Z0 - i*dx + DispZ)
+// 법선은 y가 항상 양수라서 x, z만 받고 y는 복원한다.
+struct WaveVertexSource
+{
+	int Rows = 0;
+	int Cols = 0;
+	float X0 = 0.0f;
+	float Z0 = 0.0f;
+	float SpatialStep = 1.0f;
+	float Width = 1.0f;			// TexC 계산에 쓰는 폭과 깊이
+	float Depth = 1.0f;
+
+	const float* Heights = nullptr;
+	const float* NormalX = nullptr;
+	const float* NormalZ = nullptr;
+	const float* DispX = nullptr;	// 수평 변위. 없으면 nullptr
+	const float* DispZ = nullptr;
+};
+
+// 행 [r0, r1)의 정점을 format 배치로 dst(정점 0번 자리)에 쓴다.
+// 작은 블록에 정점을 모은 뒤 캐시를 거치지 않는 스트리밍 저장으로 내보내므로
+// 매핑된 업로드 버퍼(write-combining)에 바로 쓰는 것이 좋다. 끝에서 sfence까지 한다.
+void WriteWaveVertexRows(const WaveVertexSource& source, const WaveVertexFormat& format,
+	int r0, int r1, void* dst);
+// 격자 [r0, r1) x [c0, c1)의 정점을 dst에 빈틈없이 이어 쓴다. 격자를 조각으로 나눠 그릴 때 조각 하나씩 쓴다.
+void WriteWaveVertexRect(const WaveVertexSource& source, const WaveVertexFormat& format,
+	int r0, int r1, int c0, int c1, void* dst);
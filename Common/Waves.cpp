@@ -0,0 +1,676 @@
+﻿//***************************************************************************************
+// Waves.cpp by Frank Luna (C) 2011 All Rights Reserved.
+//***************************************************************************************
+
+#include "Waves.h"
+#include "TaskScheduler.h"
+#include "WaveVertexWriter.h"
+#include <algorithm>
+#include <vector>
+#include <cassert>
+#include <cmath>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// 타일 하나의 크기. 타일 안에서는 높이를 한 행 갱신한 직후에 바로 위 행의 법선을 구한다.
+	constexpr int TileRows = 16;
+	constexpr int TileCols = 64;
+
+	enum : std::uint8_t
+	{
+		WakeUp = 1 << 0,
+		WakeDown = 1 << 1,
+		WakeLeft = 1 << 2,
+		WakeRight = 1 << 3,
+	};
+
+	// rsqrt 근사값에 뉴턴 반복을 한 번 더해 float 정밀도에 가깝게 맞춘다.
+	XMVECTOR ReciprocalSqrt(FXMVECTOR x)
+	{
+		XMVECTOR y = XMVectorReciprocalSqrtEst(x);
+		XMVECTOR halfX = x * 0.5f;
+		return y * (XMVectorReplicate(1.5f) - halfX * y * y);
+	}
+
+#if defined(__AVX2__)
+	__m256 ReciprocalSqrt(__m256 x)
+	{
+		__m256 y = _mm256_rsqrt_ps(x);
+		__m256 halfX = _mm256_mul_ps(x, _mm256_set1_ps(0.5f));
+		return _mm256_mul_ps(y, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(halfX, _mm256_mul_ps(y, y))));
+	}
+#endif
+
+	// 타일 행 높이만큼씩 나눠서, 그 안에서 sinceRevision 뒤로 바뀐 행 묶음만 쓴다.
+	void ExportRows(const WaveVertexSource& source, const std::uint64_t* rowRevision,
+		std::uint64_t sinceRevision, const WaveVertexFormat& format, void* dst, TaskScheduler& scheduler)
+	{
+		const int bands = (source.Rows + TileRows - 1) / TileRows;
+		ParallelFor(scheduler, 0, bands, [&](int band) {
+			int r1 = std::min<int>((band + 1)*TileRows, source.Rows);
+			int i = band*TileRows;
+			while (i < r1)
+			{
+				if (rowRevision[i] <= sinceRevision)
+				{
+					++i;
+					continue;
+				}
+				int first = i;
+				while (i < r1 && rowRevision[i] > sinceRevision)
+					++i;
+				WriteWaveVertexRows(source, format, first, i, dst);
+			}
+		});
+	}
+}
+
+Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
+{
+	mNumRows = m;
+	mNumCols = n;
+
+	mVertexCount = m*n;
+	mTriangleCount = (m - 1)*(n - 1) * 2;
+
+	mTimeStep = dt;
+	mSpatialStep = dx;
+
+	float d = damping*dt + 2.0f;
+	float e = (speed*speed)*(dt*dt) / (dx*dx);
+	mK1 = (damping*dt - 2.0f) / d;
+	mK2 = (4.0f - 8.0f*e) / d;
+	mK3 = (2.0f*e) / d;
+
+	mHalfWidth = (n - 1)*dx*0.5f;
+	mHalfDepth = (m - 1)*dx*0.5f;
+
+	mPrevHeights.assign(m*n, 0.0f);
+	mCurrHeights.assign(m*n, 0.0f);
+	mNormalX.assign(m*n, 0.0f);
+	mNormalZ.assign(m*n, 0.0f);
+	mRowRevision.assign(m, mRevision);
+
+	// 처음에는 모두 0이므로 전부 잠든 상태로 시작한다.
+	mTileRows = (std::max<int>(m - 2, 0) + TileRows - 1) / TileRows;
+	mTileCols = (std::max<int>(n - 2, 0) + TileCols - 1) / TileCols;
+	mTileActive.assign(mTileRows*mTileCols, 0);
+	mTileActivity.resize(mTileRows*mTileCols);
+	mActiveTiles.reserve(mTileRows*mTileCols);
+	mActiveRuns.reserve(mTileRows*mTileCols);
+	mSleepingTiles.reserve(mTileRows*mTileCols);
+	mAwakeRuns.reserve(mTileRows*mTileCols);
+	mWokenTiles.reserve(mTileRows*mTileCols);
+}
+
+Waves::~Waves()
+{
+}
+
+int Waves::RowCount()const
+{
+	return mNumRows;
+}
+
+int Waves::ColumnCount()const
+{
+	return mNumCols;
+}
+
+int Waves::VertexCount()const
+{
+	return mVertexCount;
+}
+
+int Waves::TriangleCount()const
+{
+	return mTriangleCount;
+}
+
+float Waves::Width()const
+{
+	return mNumCols*mSpatialStep;
+}
+
+float Waves::Depth()const
+{
+	return mNumRows*mSpatialStep;
+}
+
+float Waves::SpatialStep()const
+{
+	return mSpatialStep;
+}
+
+float Waves::TimeStep()const
+{
+	return mTimeStep;
+}
+
+int Waves::ActiveTileCount()const
+{
+	return static_cast<int>(std::count(mTileActive.begin(), mTileActive.end(), std::uint8_t(1)));
+}
+
+XMFLOAT3 Waves::Position(int i)const
+{
+	int row = i / mNumCols;
+	int col = i - row*mNumCols;
+	return XMFLOAT3(-mHalfWidth + col*mSpatialStep, mCurrHeights[i], mHalfDepth - row*mSpatialStep);
+}
+
+XMFLOAT3 Waves::Normal(int i)const
+{
+	float x = mNormalX[i];
+	float z = mNormalZ[i];
+	return XMFLOAT3(x, sqrtf(std::max<float>(1.0f - x*x - z*z, 0.0f)), z);
+}
+
+void Waves::CopySnapshot(WavesSnapshot& snapshot)const
+{
+	//이 격자에서 만든 사본이면 사본의 Revision 뒤로 바뀐 행만 옮긴다.
+	bool full = snapshot.Rows != mNumRows || snapshot.Cols != mNumCols ||
+		snapshot.SpatialStep != mSpatialStep || snapshot.Revision == 0 || snapshot.Revision > mRevision;
+	if (full)
+	{
+		snapshot.Rows = mNumRows;
+		snapshot.Cols = mNumCols;
+		snapshot.SpatialStep = mSpatialStep;
+		snapshot.Heights.resize(mVertexCount);
+		snapshot.NormalX.resize(mVertexCount);
+		snapshot.NormalZ.resize(mVertexCount);
+		snapshot.RowRevision.resize(mNumRows);
+	}
+
+	for (int i = 0; i < mNumRows; ++i)
+	{
+		if (!full && mRowRevision[i] <= snapshot.Revision)
+			continue;
+
+		int first = i*mNumCols;
+		std::copy_n(&mCurrHeights[first], mNumCols, &snapshot.Heights[first]);
+		std::copy_n(&mNormalX[first], mNumCols, &snapshot.NormalX[first]);
+		std::copy_n(&mNormalZ[first], mNumCols, &snapshot.NormalZ[first]);
+		snapshot.RowRevision[i] = mRowRevision[i];
+	}
+
+	snapshot.StepIndex = mStepIndex;
+	snapshot.Revision = mRevision;
+}
+
+std::uint64_t Waves::ExportVertices(void* dst, const WaveVertexFormat& format, std::uint64_t sinceRevision)const
+{
+	if (sinceRevision >= mRevision)
+		return mRevision;
+
+	WaveVertexSource source;
+	MakeVertexSource(source);
+
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+	ExportRows(source, mRowRevision.data(), sinceRevision, format, dst, scheduler);
+	return mRevision;
+}
+
+void Waves::ExportVertexRect(void* dst, const WaveVertexFormat& format, int r0, int r1, int c0, int c1)const
+{
+	WaveVertexSource source;
+	MakeVertexSource(source);
+	WriteWaveVertexRect(source, format, r0, r1, c0, c1, dst);
+}
+
+void Waves::MakeVertexSource(WaveVertexSource& source)const
+{
+	source.Rows = mNumRows;
+	source.Cols = mNumCols;
+	source.X0 = -mHalfWidth;
+	source.Z0 = mHalfDepth;
+	source.SpatialStep = mSpatialStep;
+	source.Width = Width();
+	source.Depth = Depth();
+	source.Heights = mCurrHeights.data();
+	source.NormalX = mNormalX.data();
+	source.NormalZ = mNormalZ.data();
+}
+
+std::uint64_t WavesSnapshot::ExportVertices(void* dst, const WaveVertexFormat& format, std::uint64_t sinceRevision)const
+{
+	if (sinceRevision >= Revision)
+		return Revision;
+
+	WaveVertexSource source;
+	source.Rows = Rows;
+	source.Cols = Cols;
+	source.X0 = -0.5f*(Cols - 1)*SpatialStep;
+	source.Z0 = 0.5f*(Rows - 1)*SpatialStep;
+	source.SpatialStep = SpatialStep;
+	source.Width = Cols*SpatialStep;
+	source.Depth = Rows*SpatialStep;
+	source.Heights = Heights.data();
+	source.NormalX = NormalX.data();
+	source.NormalZ = NormalZ.data();
+
+	ExportRows(source, RowRevision.data(), sinceRevision, format, dst, TaskScheduler::Default());
+	return Revision;
+}
+
+XMFLOAT3 WavesSnapshot::Position(int i)const
+{
+	int row = i / Cols;
+	int col = i - row*Cols;
+	return XMFLOAT3((col - 0.5f*(Cols - 1))*SpatialStep, Heights[i], (0.5f*(Rows - 1) - row)*SpatialStep);
+}
+
+XMFLOAT3 WavesSnapshot::Normal(int i)const
+{
+	float x = NormalX[i];
+	float z = NormalZ[i];
+	return XMFLOAT3(x, sqrtf(std::max<float>(1.0f - x*x - z*z, 0.0f)), z);
+}
+
+XMFLOAT3 Waves::TangentX(int i)const
+{
+	int row = i / mNumCols;
+	int col = i - row*mNumCols;
+	if (row == 0 || row == mNumRows - 1 || col == 0 || col == mNumCols - 1)
+		return XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+	XMFLOAT3 tangent(2.0f*mSpatialStep, mCurrHeights[i + 1] - mCurrHeights[i - 1], 0.0f);
+	XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&tangent)));
+	return tangent;
+}
+
+// 내부 점 한 행의 [c0, c1) 열을 갱신한다. 새 값은 다시 읽지 않을 이전 해 버퍼에 덮어쓴다.
+// 타일을 잠재울지 정하도록 새 높이와 직전 높이의 |최댓값|을 돌려준다.
+float Waves::StepRow(int i, int c0, int c1)
+{
+	const int n = mNumCols;
+	const int end = c1;
+	float* prev = &mPrevHeights[i*n];
+	const float* curr = &mCurrHeights[i*n];
+	const float* up = curr - n;
+	const float* down = curr + n;
+
+	int j = c0;
+	float maxAbs = 0.0f;
+#if defined(__AVX2__)
+	const __m256 k1x8 = _mm256_set1_ps(mK1);
+	const __m256 k2x8 = _mm256_set1_ps(mK2);
+	const __m256 k3x8 = _mm256_set1_ps(mK3);
+	const __m256 absMask8 = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	__m256 max8 = _mm256_setzero_ps();
+	for (; j + 8 <= end; j += 8)
+	{
+		__m256 c = _mm256_loadu_ps(curr + j);
+		__m256 sum = _mm256_add_ps(
+			_mm256_add_ps(_mm256_loadu_ps(up + j), _mm256_loadu_ps(down + j)),
+			_mm256_add_ps(_mm256_loadu_ps(curr + j + 1), _mm256_loadu_ps(curr + j - 1)));
+		__m256 h = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(k1x8, _mm256_loadu_ps(prev + j)), _mm256_mul_ps(k2x8, c)),
+			_mm256_mul_ps(k3x8, sum));
+		_mm256_storeu_ps(prev + j, h);
+		max8 = _mm256_max_ps(max8, _mm256_max_ps(_mm256_and_ps(h, absMask8), _mm256_and_ps(c, absMask8)));
+	}
+	__m128 half = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+	half = _mm_max_ps(half, _mm_movehl_ps(half, half));
+	half = _mm_max_ss(half, _mm_shuffle_ps(half, half, 1));
+	maxAbs = _mm_cvtss_f32(half);
+#endif
+
+	const XMVECTOR k1 = XMVectorReplicate(mK1);
+	const XMVECTOR k2 = XMVectorReplicate(mK2);
+	const XMVECTOR k3 = XMVectorReplicate(mK3);
+	auto Load = [](const float* p) { return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p)); };
+	XMVECTOR max4 = XMVectorZero();
+	for (; j + 4 <= end; j += 4)
+	{
+		XMVECTOR c = Load(curr + j);
+		XMVECTOR sum = (Load(up + j) + Load(down + j)) + (Load(curr + j + 1) + Load(curr + j - 1));
+		XMVECTOR h = XMVectorMultiplyAdd(k3, sum, XMVectorMultiplyAdd(k2, c, k1 * Load(prev + j)));
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(prev + j), h);
+		max4 = XMVectorMax(max4, XMVectorMax(XMVectorAbs(h), XMVectorAbs(c)));
+	}
+	XMFLOAT4 lanes;
+	XMStoreFloat4(&lanes, max4);
+	maxAbs = std::max<float>(maxAbs, std::max<float>(std::max<float>(lanes.x, lanes.y), std::max<float>(lanes.z, lanes.w)));
+
+	for (; j < end; ++j)
+	{
+		prev[j] = mK1*prev[j] + mK2*curr[j] + mK3*(up[j] + down[j] + curr[j + 1] + curr[j - 1]);
+		maxAbs = std::max<float>(maxAbs, std::max<float>(fabsf(prev[j]), fabsf(curr[j])));
+	}
+	return maxAbs;
+}
+
+// 유한 차분 법선 (l - r, 2dx, b - t)을 정규화해서 x, z 성분만 저장한다.
+// heights는 이번 단계에서 새로 구한 높이 버퍼이다.
+void Waves::UpdateNormalRow(const float* heights, int i, int c0, int c1)
+{
+	const int n = mNumCols;
+	const int end = c1;
+	const int base = i*n;
+	const float* curr = heights + base;
+	const float* up = curr - n;
+	const float* down = curr + n;
+	float* nx = &mNormalX[base];
+	float* nz = &mNormalZ[base];
+	const float twoDx = 2.0f*mSpatialStep;
+
+	int j = c0;
+#if defined(__AVX2__)
+	const __m256 twoDx8 = _mm256_set1_ps(twoDx);
+	for (; j + 8 <= end; j += 8)
+	{
+		__m256 x = _mm256_sub_ps(_mm256_loadu_ps(curr + j - 1), _mm256_loadu_ps(curr + j + 1));
+		__m256 z = _mm256_sub_ps(_mm256_loadu_ps(down + j), _mm256_loadu_ps(up + j));
+		__m256 lenSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(z, z)), _mm256_mul_ps(twoDx8, twoDx8));
+		__m256 invLen = ReciprocalSqrt(lenSq);
+		_mm256_storeu_ps(nx + j, _mm256_mul_ps(x, invLen));
+		_mm256_storeu_ps(nz + j, _mm256_mul_ps(z, invLen));
+	}
+#endif
+
+	const XMVECTOR twoDx4 = XMVectorReplicate(twoDx);
+	auto Load = [](const float* p) { return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(p)); };
+	auto Store = [](float* p, FXMVECTOR v) { XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(p), v); };
+	for (; j + 4 <= end; j += 4)
+	{
+		XMVECTOR x = Load(curr + j - 1) - Load(curr + j + 1);
+		XMVECTOR z = Load(down + j) - Load(up + j);
+		XMVECTOR lenSq = XMVectorMultiplyAdd(x, x, XMVectorMultiplyAdd(z, z, twoDx4 * twoDx4));
+		XMVECTOR invLen = ReciprocalSqrt(lenSq);
+		Store(nx + j, x * invLen);
+		Store(nz + j, z * invLen);
+	}
+
+	for (; j < end; ++j)
+	{
+		float x = curr[j - 1] - curr[j + 1];
+		float z = down[j] - up[j];
+		float invLen = 1.0f / sqrtf(x*x + twoDx*twoDx + z*z);
+		nx[j] = x*invLen;
+		nz[j] = z*invLen;
+	}
+}
+
+void Waves::GetTileBounds(int tile, int& r0, int& r1, int& c0, int& c1)const
+{
+	int ti = tile / mTileCols;
+	int tj = tile - ti*mTileCols;
+	r0 = 1 + ti*TileRows;
+	r1 = std::min<int>(r0 + TileRows, mNumRows - 1);
+	c0 = 1 + tj*TileCols;
+	c1 = std::min<int>(c0 + TileCols, mNumCols - 1);
+}
+
+// 내부 점 [i0, i1] x [j0, j1]에 걸친 타일을 깨운다.
+void Waves::WakeTiles(int i0, int i1, int j0, int j1)
+{
+	int ti0 = std::max<int>(i0 - 1, 0) / TileRows;
+	int ti1 = std::min<int>(i1 - 1, mNumRows - 3) / TileRows;
+	int tj0 = std::max<int>(j0 - 1, 0) / TileCols;
+	int tj1 = std::min<int>(j1 - 1, mNumCols - 3) / TileCols;
+	for (int ti = ti0; ti <= ti1; ++ti)
+		for (int tj = tj0; tj <= tj1; ++tj)
+			mTileActive[ti*mTileCols + tj] = 1;
+}
+
+// 잠든 타일은 두 버퍼와 법선이 모두 0이라 그대로 깨워도 된다.
+void Waves::WakeAll()
+{
+	std::fill(mTileActive.begin(), mTileActive.end(), static_cast<std::uint8_t>(1));
+}
+
+// 같은 타일 행에서 이어진 깨어 있는 타일들을 한 번에 갱신한다. 행마다 타일 구간을 차례로 갱신하고
+// 상하좌우 새 높이가 이미 나온 바로 위 행의 법선을 같이 구한다. 모두 깨어 있으면 행 전체를 한 번에 훑는다.
+// 묶음 테두리는 이웃의 결과가 필요하므로 UpdateEdgeNormals에서 따로 처리한다.
+// 갱신하면서 잰 |높이|로 타일마다 계속 깨워 둘지, 테두리 너머 이웃을 깨울지 정한다.
+void Waves::StepRun(const TileRun& run)
+{
+	const int n = mNumCols;
+	const float* next = mPrevHeights.data();
+	for (int tile = run.FirstTile; tile < run.LastTile; ++tile)
+		mTileActivity[tile] = TileActivity();
+
+	for (int i = run.R0; i < run.R1; ++i)
+	{
+		for (int tile = run.FirstTile; tile < run.LastTile; ++tile)
+		{
+			int r0, r1, c0, c1;
+			GetTileBounds(tile, r0, r1, c0, c1);
+			float rowMax = StepRow(i, c0, c1);
+
+			TileActivity& activity = mTileActivity[tile];
+			activity.MaxAbs = std::max<float>(activity.MaxAbs, rowMax);
+			if (i == r0) activity.TopAbs = rowMax;
+			if (i == r1 - 1) activity.BottomAbs = rowMax;
+			activity.LeftAbs = std::max<float>(activity.LeftAbs, fabsf(next[i*n + c0]));
+			activity.RightAbs = std::max<float>(activity.RightAbs, fabsf(next[i*n + c1 - 1]));
+		}
+		if (i - 1 > run.R0)
+			UpdateNormalRow(next, i - 1, run.C0 + 1, run.C1 - 1);
+	}
+
+	for (int tile = run.FirstTile; tile < run.LastTile; ++tile)
+	{
+		int r0, r1, c0, c1;
+		GetTileBounds(tile, r0, r1, c0, c1);
+
+		TileActivity& activity = mTileActivity[tile];
+		activity.Awake = activity.MaxAbs > mSleepThreshold;
+		if (r0 > 1 && activity.TopAbs > mSleepThreshold) activity.WakeNeighbors |= WakeUp;
+		if (r1 < mNumRows - 1 && activity.BottomAbs > mSleepThreshold) activity.WakeNeighbors |= WakeDown;
+		if (c0 > 1 && activity.LeftAbs > mSleepThreshold) activity.WakeNeighbors |= WakeLeft;
+		if (c1 < mNumCols - 1 && activity.RightAbs > mSleepThreshold) activity.WakeNeighbors |= WakeRight;
+	}
+}
+
+// 구간 [r0, r1) x [c0, c1)의 테두리 법선을 현재 높이로 구한다.
+void Waves::UpdateEdgeNormals(int r0, int r1, int c0, int c1)
+{
+	const float* curr = mCurrHeights.data();
+	UpdateNormalRow(curr, r0, c0, c1);
+	if (r1 - 1 > r0)
+		UpdateNormalRow(curr, r1 - 1, c0, c1);
+	for (int i = r0 + 1; i < r1 - 1; ++i)
+	{
+		UpdateNormalRow(curr, i, c0, c0 + 1);
+		if (c1 - 1 > c0)
+			UpdateNormalRow(curr, i, c1 - 1, c1);
+	}
+}
+
+// 문턱값 아래로 남은 높이를 0으로 지워서, 잠든 동안 두 버퍼를 바꿔도 값이 변하지 않게 한다.
+void Waves::SleepTile(int tile)
+{
+	int r0, r1, c0, c1;
+	GetTileBounds(tile, r0, r1, c0, c1);
+
+	for (int i = r0; i < r1; ++i)
+	{
+		auto first = i*mNumCols + c0;
+		auto last = i*mNumCols + c1;
+		std::fill(mPrevHeights.begin() + first, mPrevHeights.begin() + last, 0.0f);
+		std::fill(mCurrHeights.begin() + first, mCurrHeights.begin() + last, 0.0f);
+		std::fill(mNormalX.begin() + first, mNormalX.begin() + last, 0.0f);
+		std::fill(mNormalZ.begin() + first, mNormalZ.begin() + last, 0.0f);
+	}
+}
+
+void Waves::MarkRows(int r0, int r1)
+{
+	std::fill(mRowRevision.begin() + r0, mRowRevision.begin() + r1, mRevision);
+}
+
+void Waves::MarkTileRows(int tile)
+{
+	int r0, r1, c0, c1;
+	GetTileBounds(tile, r0, r1, c0, c1);
+	MarkRows(r0, r1);
+}
+
+void Waves::Update(float dt)
+{
+	// Accumulate time.
+	mAccumTime += dt;
+
+	// Only update the simulation at the specified time step.
+	if( mAccumTime >= mTimeStep )
+	{
+		Step();
+		mAccumTime = 0.0f; // reset time
+	}
+}
+
+void Waves::Step()
+{
+	// Only update interior points; we use zero boundary conditions.
+	// 깨어 있는 타일만 돈다. 잠든 타일은 두 버퍼 모두 0이라 바꾸지 않아도 된다.
+	mActiveTiles.clear();
+	mActiveRuns.clear();
+	for (int ti = 0; ti < mTileRows; ++ti)
+	{
+		for (int tj = 0; tj < mTileCols; ++tj)
+		{
+			int tile = ti*mTileCols + tj;
+			if (mTileActive[tile] == 0)
+				continue;
+
+			mActiveTiles.emplace_back(tile);
+			if (tj > 0 && mTileActive[tile - 1])
+			{
+				TileRun& run = mActiveRuns.back();
+				run.LastTile = tile + 1;
+				run.C1 = std::min<int>(run.C1 + TileCols, mNumCols - 1);
+				continue;
+			}
+
+			TileRun run;
+			GetTileBounds(tile, run.R0, run.R1, run.C0, run.C1);
+			run.FirstTile = tile;
+			run.LastTile = tile + 1;
+			mActiveRuns.emplace_back(run);
+		}
+	}
+
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+	ParallelFor(scheduler, 0, static_cast<int>(mActiveRuns.size()), [&](int k) {
+		StepRun(mActiveRuns[k]);
+	}, 1);
+
+	// We just overwrote the previous buffer with the new data, so
+	// this data needs to become the current solution and the old
+	// current solution becomes the new previous solution.
+	std::swap(mPrevHeights, mCurrHeights);
+	mStepIndex++;
+
+	// 이웃이 테두리 법선을 구하면서 읽기 전에 잠들 타일을 먼저 지운다.
+	mSleepingTiles.clear();
+	for (int tile : mActiveTiles)
+	{
+		if (!mTileActivity[tile].Awake)
+			mSleepingTiles.emplace_back(tile);
+	}
+	ParallelFor(scheduler, 0, static_cast<int>(mSleepingTiles.size()), [&](int k) {
+		SleepTile(mSleepingTiles[k]);
+	});
+
+	// 테두리 법선은 아직 깨어 있는 타일끼리 묶어서 구한다. 방금 잠든 타일의 높이와 법선은 0인 채로 둔다.
+	mAwakeRuns.clear();
+	for (const TileRun& run : mActiveRuns)
+	{
+		for (int tile = run.FirstTile; tile < run.LastTile; ++tile)
+		{
+			if (!mTileActivity[tile].Awake)
+				continue;
+
+			int r0, r1, c0, c1;
+			GetTileBounds(tile, r0, r1, c0, c1);
+			if (tile > run.FirstTile && mTileActivity[tile - 1].Awake)
+			{
+				TileRun& awake = mAwakeRuns.back();
+				awake.LastTile = tile + 1;
+				awake.C1 = c1;
+				continue;
+			}
+
+			TileRun awake;
+			awake.R0 = r0;
+			awake.R1 = r1;
+			awake.C0 = c0;
+			awake.C1 = c1;
+			awake.FirstTile = tile;
+			awake.LastTile = tile + 1;
+			mAwakeRuns.emplace_back(awake);
+		}
+	}
+	ParallelFor(scheduler, 0, static_cast<int>(mAwakeRuns.size()), [&](int k) {
+		const TileRun& run = mAwakeRuns[k];
+		UpdateEdgeNormals(run.R0, run.R1, run.C0, run.C1);
+	});
+
+	// 새로 깨어난 타일은 테두리 너머 높이가 이미 바뀌었으므로 테두리 법선을 바로 맞춘다.
+	// 이번에 잠든 타일은 잠시 2로 표시해서, 이웃이 다시 깨우면 같이 법선을 맞추게 한다.
+	mWokenTiles.clear();
+	auto Wake = [this](int tile) {
+		if (mTileActive[tile] != 1)
+		{
+			mTileActive[tile] = 1;
+			mWokenTiles.emplace_back(tile);
+		}
+	};
+	for (int tile : mActiveTiles)
+		mTileActive[tile] = mTileActivity[tile].Awake ? 1 : 2;
+	for (int tile : mActiveTiles)
+	{
+		std::uint8_t wake = mTileActivity[tile].WakeNeighbors;
+		if (wake & WakeUp) Wake(tile - mTileCols);
+		if (wake & WakeDown) Wake(tile + mTileCols);
+		if (wake & WakeLeft) Wake(tile - 1);
+		if (wake & WakeRight) Wake(tile + 1);
+	}
+	for (int tile : mActiveTiles)
+	{
+		if (mTileActive[tile] == 2)
+			mTileActive[tile] = 0;
+	}
+	ParallelFor(scheduler, 0, static_cast<int>(mWokenTiles.size()), [&](int k) {
+		int r0, r1, c0, c1;
+		GetTileBounds(mWokenTiles[k], r0, r1, c0, c1);
+		UpdateEdgeNormals(r0, r1, c0, c1);
+	});
+
+	// 높이나 법선을 고친 행: 갱신한 묶음, 지운 타일, 테두리 법선을 맞춘 타일
+	mRevision++;
+	for (const TileRun& run : mActiveRuns)
+		MarkRows(run.R0, run.R1);
+	for (int tile : mSleepingTiles)
+		MarkTileRows(tile);
+	for (int tile : mWokenTiles)
+		MarkTileRows(tile);
+}
+
+void Waves::Disturb(int i, int j, float magnitude)
+{
+	// Don't disturb boundaries.
+	assert(i > 1 && i < mNumRows-2);
+	assert(j > 1 && j < mNumCols-2);
+
+	float halfMag = 0.5f*magnitude;
+
+	// Disturb the ijth vertex height and its neighbors.
+	mCurrHeights[i*mNumCols+j]     += magnitude;
+	mCurrHeights[i*mNumCols+j+1]   += halfMag;
+	mCurrHeights[i*mNumCols+j-1]   += halfMag;
+	mCurrHeights[(i+1)*mNumCols+j] += halfMag;
+	mCurrHeights[(i-1)*mNumCols+j] += halfMag;
+	mRevision++;
+	MarkRows(i - 1, i + 2);
+
+	// 바뀐 점과, 다음 단계에서 그 점을 읽는 바로 옆 점이 걸친 타일을 깨운다.
+	WakeTiles(i - 2, i + 2, j - 2, j + 2);
+}
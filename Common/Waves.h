@@ -0,0 +1,179 @@
+﻿//***************************************************************************************
+// Waves.h by Frank Luna (C) 2011 All Rights Reserved.
+//
+// Performs the calculations for the wave simulation.  After the simulation has been
+// updated, the client must copy the current solution into vertex buffers for rendering.
+// This class only does the calculations, it does not do any drawing.
+//***************************************************************************************
+
+#ifndef WAVES_H
+#define WAVES_H
+
+#include <vector>
+#include <cstdint>
+#include <DirectXMath.h>
+
+class TaskScheduler;
+struct WaveVertexFormat;
+struct WaveVertexSource;
+
+// 한 단계가 끝난 시점의 높이와 법선 사본. 시뮬레이션 스레드에서 만들어 렌더 스레드로 넘긴다.
+struct WavesSnapshot
+{
+	int Rows = 0;
+	int Cols = 0;
+	float SpatialStep = 0.0f;
+	std::uint64_t StepIndex = 0;
+	std::uint64_t Revision = 0;
+
+	std::vector<float> Heights;
+	std::vector<float> NormalX;
+	std::vector<float> NormalZ;
+	std::vector<std::uint64_t> RowRevision;
+
+	int VertexCount()const { return Rows*Cols; }
+	DirectX::XMFLOAT3 Position(int i)const;
+	DirectX::XMFLOAT3 Normal(int i)const;
+	// Waves::ExportVertices와 같다.
+	std::uint64_t ExportVertices(void* dst, const WaveVertexFormat& format, std::uint64_t sinceRevision = 0)const;
+};
+
+// 높이만 시간에 따라 바뀌므로 높이와 법선을 성분별 float 배열(SoA)로 두고
+// 행 단위로 SIMD 갱신한다. x, z는 격자 번호로 정해지므로 Position에서 그때 만든다.
+// 법선은 y가 항상 양수라서 x, z만 저장하고 y는 Normal에서 복원한다.
+// 내부 점은 타일로 나눠서, 높이가 문턱값 아래로 잦아든 타일은 잠재우고 0으로 맞춘다.
+// 잠든 타일은 Disturb나 깨어 있는 이웃의 경계가 흔들릴 때 다시 깨어나므로
+// 한 단계의 비용은 격자 크기가 아니라 흔들리는 넓이를 따라간다.
+class Waves
+{
+public:
+	Waves(int m, int n, float dx, float dt, float speed, float damping);
+	Waves(const Waves& rhs) = delete;
+	Waves& operator=(const Waves& rhs) = delete;
+	~Waves();
+
+	int RowCount()const;
+	int ColumnCount()const;
+	int VertexCount()const;
+	int TriangleCount()const;
+	float Width()const;
+	float Depth()const;
+	float SpatialStep()const;
+	float TimeStep()const;
+
+	// Returns the solution at the ith grid point.
+	DirectX::XMFLOAT3 Position(int i)const;
+	float Height(int i)const { return mCurrHeights[i]; }
+	const float* Heights()const { return mCurrHeights.data(); }
+
+	// Returns the solution normal at the ith grid point.
+	DirectX::XMFLOAT3 Normal(int i)const;
+
+	// Returns the unit tangent vector at the ith grid point in the local x-axis direction.
+	DirectX::XMFLOAT3 TangentX(int i)const;
+
+	// dt를 모아서 TimeStep이 넘으면 한 단계 진행한다.
+	void Update(float dt);
+	// 시간과 상관없이 바로 한 단계 진행한다. 일정한 간격으로 직접 돌리는 쪽에서 쓴다.
+	void Step();
+	void Disturb(int i, int j, float magnitude);
+
+	// snapshot이 이 격자에서 만든 사본이면 그 사본의 Revision 뒤로 바뀐 행만 옮긴다.
+	void CopySnapshot(WavesSnapshot& snapshot)const;
+
+	// 정점이 바뀔 때마다(Step, Disturb) 늘어나는 번호. 1부터 시작한다.
+	std::uint64_t Revision()const { return mRevision; }
+	// 행마다 마지막으로 바뀐 Revision(RowCount개). 격자의 일부만 다시 쓰거나 다시 잴 때 쓴다.
+	const std::uint64_t* RowRevisions()const { return mRowRevision.data(); }
+	// 매핑된 정점 버퍼 dst에 format 배치로 정점을 바로 쓴다. sinceRevision 뒤로 바뀐 행만 쓰고(0이면 모두)
+	// 지금 Revision을 돌려준다. 프레임 자원마다 돌려받은 값을 들고 있다가 다음에 넘기면 된다.
+	std::uint64_t ExportVertices(void* dst, const WaveVertexFormat& format, std::uint64_t sinceRevision = 0)const;
+	// 격자 [r0, r1) x [c0, c1)의 정점을 dst에 빈틈없이 이어 쓴다. 부른 스레드에서 바로 쓴다.
+	void ExportVertexRect(void* dst, const WaveVertexFormat& format, int r0, int r1, int c0, int c1)const;
+
+	// 갱신에 쓸 스레드 풀. nullptr이면 TaskScheduler::Default()를 쓴다.
+	void SetScheduler(TaskScheduler* scheduler) { mScheduler = scheduler; }
+
+	// 타일 안의 |높이|가 두 단계 연속 이 값 이하이면 잠재운다. 0이면 완전히 멎은 타일만 잠든다.
+	// 음수면 잠재우지 않고, 깨어 있는 타일은 이웃을 늘 깨운다.
+	void SetSleepThreshold(float threshold) { mSleepThreshold = threshold; }
+	// 모든 타일을 깨운다. 음수 문턱값과 같이 쓰면 매 단계 격자 전체를 도는 조밀한 갱신이 된다.
+	void WakeAll();
+	int TileCount()const { return static_cast<int>(mTileActive.size()); }
+	int ActiveTileCount()const;
+
+private:
+	struct TileActivity
+	{
+		float MaxAbs = 0.0f;	// 새 높이와 직전 높이의 |최댓값|
+		float TopAbs = 0.0f;	// 테두리 행, 열의 |최댓값|
+		float BottomAbs = 0.0f;
+		float LeftAbs = 0.0f;
+		float RightAbs = 0.0f;
+		bool Awake = false;
+		std::uint8_t WakeNeighbors = 0;	// 경계가 흔들려서 깨워야 할 이웃. WakeUp, WakeDown, WakeLeft, WakeRight
+	};
+
+	// 같은 타일 행에서 이어진 깨어 있는 타일 [FirstTile, LastTile)과 그 점 범위
+	struct TileRun
+	{
+		int R0 = 0, R1 = 0;
+		int C0 = 0, C1 = 0;
+		int FirstTile = 0;
+		int LastTile = 0;
+	};
+
+	void MakeVertexSource(WaveVertexSource& source)const;
+	void GetTileBounds(int tile, int& r0, int& r1, int& c0, int& c1)const;
+	void WakeTiles(int i0, int i1, int j0, int j1);
+	float StepRow(int i, int c0, int c1);
+	void UpdateNormalRow(const float* heights, int i, int c0, int c1);
+	void StepRun(const TileRun& run);
+	void UpdateEdgeNormals(int r0, int r1, int c0, int c1);
+	void SleepTile(int tile);
+	void MarkRows(int r0, int r1);
+	void MarkTileRows(int tile);
+
+private:
+	int mNumRows = 0;
+	int mNumCols = 0;
+
+	int mVertexCount = 0;
+	int mTriangleCount = 0;
+
+	// Simulation constants we can precompute.
+	float mK1 = 0.0f;
+	float mK2 = 0.0f;
+	float mK3 = 0.0f;
+
+	float mTimeStep = 0.0f;
+	float mSpatialStep = 0.0f;
+	float mAccumTime = 0.0f;
+	std::uint64_t mStepIndex = 0;
+	float mHalfWidth = 0.0f;
+	float mHalfDepth = 0.0f;
+
+	std::vector<float> mPrevHeights;
+	std::vector<float> mCurrHeights;
+	std::vector<float> mNormalX;
+	std::vector<float> mNormalZ;
+
+	// 행마다 마지막으로 바뀐 Revision
+	std::uint64_t mRevision = 1;
+	std::vector<std::uint64_t> mRowRevision;
+
+	int mTileRows = 0;
+	int mTileCols = 0;
+	float mSleepThreshold = 1e-4f;
+	std::vector<std::uint8_t> mTileActive;
+	std::vector<TileActivity> mTileActivity;
+	std::vector<int> mActiveTiles;
+	std::vector<TileRun> mActiveRuns;
+	std::vector<int> mSleepingTiles;
+	std::vector<TileRun> mAwakeRuns;
+	std::vector<int> mWokenTiles;
+
+	TaskScheduler* mScheduler = nullptr;
+};
+
+#endif // WAVES_H
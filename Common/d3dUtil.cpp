@@ -202,3 +202,42 @@ std::vector<D3D12_STATIC_SAMPLER_DESC> d3dUtil::GetStaticSamplers()
 }
 
 
+
+UINT MeshGeometry::ExtractSubmesh(const SubmeshGeometry& submesh, std::vector<DirectX::XMFLOAT3>& positions,
+    std::vector<std::uint32_t>& indices, std::vector<DirectX::XMFLOAT3>* normals, UINT normalOffset)const
+{
+    auto vertexData = reinterpret_cast<const BYTE*>(VertexBufferCPU->GetBufferPointer());
+    auto indexData = IndexBufferCPU->GetBufferPointer();
+    auto GetIndex = [&](UINT i) -> std::uint32_t {
+        if (IndexFormat == DXGI_FORMAT_R16_UINT)
+            return reinterpret_cast<const std::uint16_t*>(indexData)[i];
+        return reinterpret_cast<const std::uint32_t*>(indexData)[i];
+    };
+
+    std::uint32_t minIdx = UINT_MAX;
+    std::uint32_t maxIdx = 0;
+    indices.resize(submesh.IndexCount);
+    for (auto i : Range(0, submesh.IndexCount))
+    {
+        indices[i] = GetIndex(submesh.StartIndexLocation + i);
+        minIdx = std::min<std::uint32_t>(minIdx, indices[i]);
+        maxIdx = std::max<std::uint32_t>(maxIdx, indices[i]);
+    }
+    for (auto& idx : indices)
+        idx -= minIdx;
+
+    UINT firstVertex = submesh.BaseVertexLocation + minIdx;
+    UINT vertexCount = submesh.IndexCount > 0 ? maxIdx - minIdx + 1 : 0;
+    positions.resize(vertexCount);
+    if (normals != nullptr)
+        normals->resize(vertexCount);
+    for (auto i : Range(0, vertexCount))
+    {
+        const BYTE* vertex = vertexData + static_cast<size_t>(firstVertex + i) * VertexByteStride;
+        memcpy(&positions[i], vertex, sizeof(DirectX::XMFLOAT3));
+        if (normals != nullptr)
+            memcpy(&(*normals)[i], vertex + normalOffset, sizeof(DirectX::XMFLOAT3));
+    }
+
+    return firstVertex;
+}
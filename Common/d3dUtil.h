@@ -235,6 +235,13 @@ struct MeshGeometry
 		VertexBufferUploader = nullptr;
 		IndexBufferUploader = nullptr;
 	}
+
+	// CPU 사본에서 서브메쉬가 쓰는 정점 범위만 잘라 위치를 꺼낸다. normals를 넘기면 법선도 꺼낸다.
+	// 정점은 위치로 시작하고 법선은 normalOffset 바이트에 있어야 한다.
+	// indices는 잘라낸 첫 정점 기준으로 바꾸고, 그 첫 정점의 정점 버퍼 번호를 돌려준다.
+	UINT ExtractSubmesh(const SubmeshGeometry& submesh, std::vector<DirectX::XMFLOAT3>& positions,
+		std::vector<std::uint32_t>& indices, std::vector<DirectX::XMFLOAT3>* normals = nullptr,
+		UINT normalOffset = sizeof(DirectX::XMFLOAT3))const;
 };
 
 struct Light
@@ -3,8 +3,10 @@
 #include "../Common/MathHelper.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
+#include "../Common/HeightField.h"
 #include "FrameResource.h"
-#include "Waves.h"
+#include "../Common/WaveSimulator.h"
+#include "../Common/WaveVertexWriter.h"
 #include "../Common/Util.h"
 
 using Microsoft::WRL::ComPtr;
@@ -71,6 +73,7 @@ private:
 	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
 	
 	float GetHillsHeight(float x, float z) const;
+	void PickSurface(int sx, int sy);
 	
 private:
 	std::vector<std::unique_ptr<FrameResource>> mFrameResources;
@@ -90,7 +93,13 @@ private:
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 	std::vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
 
-	std::unique_ptr<Waves> mWaves;
+	//물은 전용 스레드에서 고정 간격으로 돌고, 여기서는 마지막으로 끝난 단계를 가져다 그린다.
+	WaveSimulator mWaveSimulator;
+	WaveSimulator::Instance* mWaves = nullptr;
+
+	HeightField mLandField;
+	HeightField mWaterField;
+	std::uint64_t mWaterFieldRevision = 0;	// mWaterField에 담은 물 높이의 Revision. 0이면 아직 만들지 않았다.
 
 	PassConstants mMainPassCB;
 
@@ -128,7 +137,7 @@ bool LandAndWavesApp::Initialize()
 
 	ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
 
-	mWaves = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	mWaves = mWaveSimulator.Add(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
 
 	BuildRootSignature();
 	BuildShadersAndInputLayout();
@@ -201,11 +210,13 @@ void LandAndWavesApp::BuildLandGeometry()
 
 	size_t vertexSize = grid.Vertices.size();
 	std::vector<Vertex> vertices(vertexSize);
+	std::vector<float> heights(vertexSize);
 	for (size_t i : Range(0, (int)vertexSize))
 	{
 		auto& p = grid.Vertices[i].Position;
 		vertices[i].Pos = p;
 		vertices[i].Pos.y = GetHillsHeight(p.x, p.z);
+		heights[i] = vertices[i].Pos.y;
 
 		auto& currHeight = vertices[i].Pos.y;
 		auto& currColor = vertices[i].Color;
@@ -249,6 +260,8 @@ void LandAndWavesApp::BuildLandGeometry()
 	geo->DrawArgs["grid"] = submesh;
 
 	mGeometries["landGeo"] = std::move(geo);
+
+	mLandField.Build(50, 50, 160.0f, 160.0f, heights);
 }
 
 void LandAndWavesApp::BuildWavesGeometryBuffers()
@@ -473,18 +486,21 @@ void LandAndWavesApp::UpdateWaves(const GameTimer& gt)
 		mWaves->Disturb(i, j, r);
 	}
 
-	mWaves->Update(gt.DeltaTime());
+	const WavesSnapshot& waves = mWaves->Latest();
 
-	auto currWavesVB = mCurrFrameResource->WavesVB.get();
-	for (int i : Range(0, mWaves->VertexCount()))
-	{
-		Vertex v;
+	//색은 모든 정점이 같으므로 원형 정점으로 깔고, 바뀐 행의 위치만 바로 쓴다.
+	Vertex prototype;
+	prototype.Pos = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	prototype.Color = XMFLOAT4(DirectX::Colors::Blue);
 
-		v.Pos = mWaves->Position(i);
-		v.Color = XMFLOAT4(DirectX::Colors::Blue);
+	WaveVertexFormat format;
+	format.Stride = sizeof(Vertex);
+	format.PositionOffset = offsetof(Vertex, Pos);
+	format.Prototype = &prototype;
 
-		currWavesVB->CopyData(i, v);
-	}
+	auto currWavesVB = mCurrFrameResource->WavesVB.get();
+	mCurrFrameResource->WavesRevision = waves.ExportVertices(
+		currWavesVB->MappedData(), format, mCurrFrameResource->WavesRevision);
 
 	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
 }
@@ -589,6 +605,12 @@ void LandAndWavesApp::Draw(const GameTimer& gt)
 
 void LandAndWavesApp::OnMouseDown(WPARAM btnState, int x, int y)
 {
+	if ((btnState & MK_MBUTTON) != 0)
+	{
+		PickSurface(x, y);
+		return;
+	}
+
 	mLastMousePos.x = x;
 	mLastMousePos.y = y;
 
@@ -623,6 +645,55 @@ void LandAndWavesApp::OnMouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.y = y;
 }
 
+void LandAndWavesApp::PickSurface(int sx, int sy)
+{
+	float vx = (2.0f * sx / mClientWidth - 1.0f) / mProj(0, 0);
+	float vy = (-2.0f * sy / mClientHeight + 1.0f) / mProj(1, 1);
+
+	XMMATRIX V = XMLoadFloat4x4(&mView);
+	XMMATRIX invView = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(V)), V);
+
+	//땅과 물 모두 월드 행렬이 단위 행렬이다.
+	XMVECTOR rayOrigin = XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), invView);
+	XMVECTOR rayDir = XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), invView));
+
+	//물 최소/최대 맵은 처음 누를 때 한 번 만들고, 그 뒤로는 지난번 뒤에 바뀐 행만 다시 맞춘다.
+	const WavesSnapshot& waves = mWaves->Latest();
+	if (mWaterFieldRevision == 0)
+	{
+		float dx = waves.SpatialStep;
+		mWaterField.Build(waves.Rows, waves.Cols, (waves.Cols - 1) * dx, (waves.Rows - 1) * dx, waves.Heights);
+	}
+	else if (waves.Revision != mWaterFieldRevision)
+	{
+		for (int r0 = 0; r0 < waves.Rows; )
+		{
+			if (waves.RowRevision[r0] <= mWaterFieldRevision)
+			{
+				r0++;
+				continue;
+			}
+			int r1 = r0 + 1;
+			while (r1 < waves.Rows && waves.RowRevision[r1] > mWaterFieldRevision)
+				r1++;
+			mWaterField.UpdateRows(r0, r1, waves.Heights.data());
+			r0 = r1;
+		}
+	}
+	mWaterFieldRevision = waves.Revision;
+
+	HeightField::Hit waterHit, landHit;
+	if (mWaterField.Intersects(rayOrigin, rayDir, waterHit) == false)
+		return;
+	if (mLandField.Intersects(rayOrigin, rayDir, landHit) && landHit.T < waterHit.T)
+		return;
+
+	//Disturb는 가장자리 두 줄을 건드리지 않는다.
+	int i = MathHelper::Clamp(static_cast<int>(waterHit.Row), 2, mWaves->RowCount() - 3);
+	int j = MathHelper::Clamp(static_cast<int>(waterHit.Col), 2, mWaves->ColumnCount() - 3);
+	mWaves->Disturb(i, j, 1.0f);
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
 {
 #if defined(DEBUG) | defined(_DEBUG)
@@ -4,8 +4,13 @@
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
 #include "FrameResource.h"
-#include "Waves.h"
+#include "../Common/Waves.h"
+#include "../Common/SpectralOcean.h"
+#include "../Common/WaveVertexWriter.h"
 #include "../Common/Util.h"
+#include "../Common/TaskScheduler.h"
+#include "../Common/Benchmark.h"
+#include <string>
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -62,6 +67,8 @@ private:
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
 	void UpdateWaves(const GameTimer& gt);
+	void RunWavesBenchmark();
+	void RunOceanBenchmark();
 
 	void BuildRootSignature();
 	void BuildShadersAndInputLayout();
@@ -97,6 +104,9 @@ private:
 	UINT mCbvSrvDescriptorSize = 0;
 
 	std::unique_ptr<Waves> mWaves;
+	//O로 Waves와 바꿔 그린다. 격자 크기와 간격은 Waves와 같다.
+	std::unique_ptr<SpectralOcean> mOcean;
+	bool mUseOcean = false;
 
 	//PassConstants mMainPassCB;
 
@@ -111,6 +121,10 @@ private:
 	float mSunTheta = 1.25f * XM_PI;
 	float mSunPhi = XM_PIDIV4;
 
+	bool mBenchmarkKeyDown = false;
+	bool mOceanKeyDown = false;
+	bool mOceanBenchmarkKeyDown = false;
+
 	POINT mLastMousePos;
 };
 
@@ -136,6 +150,11 @@ bool LitWavesApp::Initialize()
 		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 	mWaves = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
 
+	SpectralOcean::Desc oceanDesc;
+	oceanDesc.Size = mWaves->RowCount();
+	oceanDesc.PatchSize = mWaves->RowCount() * mWaves->SpatialStep();
+	mOcean = std::make_unique<SpectralOcean>(oceanDesc);
+
 	BuildRootSignature();
 	BuildShadersAndInputLayout();
 	BuildLandGeometry();
@@ -430,6 +449,22 @@ void LitWavesApp::OnKeyboardInput(const GameTimer& gt)
 		mSunPhi += 1.0f * dt;
 
 	mSunPhi = MathHelper::Clamp(mSunPhi, 0.1f, XM_PIDIV2);
+
+	//B를 누를 때 한 번만 돌린다.
+	bool benchmarkKey = (GetAsyncKeyState('B') & 0x8000) != 0;
+	if (benchmarkKey && !mBenchmarkKeyDown)
+		RunWavesBenchmark();
+	mBenchmarkKeyDown = benchmarkKey;
+
+	bool oceanKey = (GetAsyncKeyState('O') & 0x8000) != 0;
+	if (oceanKey && !mOceanKeyDown)
+		mUseOcean = !mUseOcean;
+	mOceanKeyDown = oceanKey;
+
+	bool oceanBenchmarkKey = (GetAsyncKeyState('F') & 0x8000) != 0;
+	if (oceanBenchmarkKey && !mOceanBenchmarkKeyDown)
+		RunOceanBenchmark();
+	mOceanBenchmarkKeyDown = oceanBenchmarkKey;
 }
 
 void LitWavesApp::UpdateCamera(const GameTimer& gt)
@@ -531,6 +566,22 @@ void LitWavesApp::UpdateMainPassCB(const GameTimer& gt)
 
 void LitWavesApp::UpdateWaves(const GameTimer& gt)
 {
+	WaveVertexFormat format;
+	format.Stride = sizeof(Vertex);
+	format.PositionOffset = offsetof(Vertex, Pos);
+	format.NormalOffset = offsetof(Vertex, Normal);
+
+	auto currWavesVB = mCurrFrameResource->WavesVB.get();
+	if (mUseOcean)
+	{
+		mOcean->Update(gt.DeltaTime());
+		mOcean->ExportVertices(currWavesVB->MappedData(), format);
+		//버퍼를 바다로 덮었으므로 Waves로 돌아오면 모두 다시 쓴다.
+		mCurrFrameResource->WavesRevision = 0;
+		mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
+		return;
+	}
+
 	static float t_base = 0.0f;
 	if ((mTimer.TotalTime() - t_base) >= 0.25f)
 	{
@@ -543,15 +594,73 @@ void LitWavesApp::UpdateWaves(const GameTimer& gt)
 	}
 	mWaves->Update(gt.DeltaTime());
 
-	auto currWavesVB = mCurrFrameResource->WavesVB.get();
-	for (int i = 0; i < mWaves->VertexCount(); ++i)
+	//바뀐 행만 이 프레임 자원의 정점 버퍼에 바로 쓴다.
+	mCurrFrameResource->WavesRevision = mWaves->ExportVertices(
+		currWavesVB->MappedData(), format, mCurrFrameResource->WavesRevision);
+	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
+}
+
+//격자 크기와 스레드 수(1, 2, 4, ... 코어 수)별로 한 단계(높이 + 법선) 갱신에 걸리는 시간을 재서 출력 창에 찍는다.
+void LitWavesApp::RunWavesBenchmark()
+{
+	int maxThreads = std::max<int>(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	std::vector<int> threadCounts;
+	for (int count = 1; count < maxThreads; count *= 2)
+		threadCounts.emplace_back(count);
+	threadCounts.emplace_back(maxThreads);
+
+	//잠든 타일을 건너뛰지 않는 조밀한 갱신을 잰다. 스레드 수마다 같은 초기 상태에서 시작한다.
+	for (int size : { 256, 1024, 4096 })
 	{
-		Vertex v;
-		v.Pos = mWaves->Position(i);
-		v.Normal = mWaves->Normal(i);
-		currWavesVB->CopyData(i, v);
+		double baseMs = 0.0;
+		for (int threadCount : threadCounts)
+		{
+			Waves waves(size, size, 1.0f, 0.03f, 4.0f, 0.2f);
+			waves.SetSleepThreshold(-1.0f);
+			waves.WakeAll();
+			waves.Disturb(size / 2, size / 2, 1.0f);
+
+			TaskScheduler::Desc desc;
+			desc.ThreadCount = threadCount;
+			desc.PinThreads = true;
+			TaskScheduler scheduler(desc);
+			waves.SetScheduler(&scheduler);
+
+			//한 번은 캐시와 스레드를 데우는 데 쓴다.
+			waves.Update(0.03f);
+
+			int steps = std::max<int>(4, (1 << 24) / (size * size));
+			double ms = Benchmark::MeasureMs([&]() { waves.Update(0.03f); }, steps) / steps;
+			if (threadCount == 1)
+				baseMs = ms;
+			Benchmark::Report report(L"Waves ");
+			report << size << L"x" << size << L", " << threadCount << L" threads: " << ms << L" ms/step (x" <<
+				baseMs / ms << L"), active tiles " << waves.ActiveTileCount() << L"/" << waves.TileCount();
+			report.Print();
+			waves.SetScheduler(nullptr);
+		}
+	}
+}
+
+//격자 크기별로 바다 한 번 갱신(스펙트럼 갱신 + 복소 2D 역 FFT 세 번 + 법선)에 걸리는 시간을 출력 창에 찍는다.
+void LitWavesApp::RunOceanBenchmark()
+{
+	for (int size : { 128, 256, 512 })
+	{
+		SpectralOcean::Desc desc;
+		desc.Size = size;
+		desc.PatchSize = static_cast<float>(size);
+		SpectralOcean ocean(desc);
+
+		//한 번은 캐시와 스레드를 데우는 데 쓴다.
+		ocean.Update(0.03f);
+
+		int steps = std::max<int>(4, (1 << 22) / (size * size));
+		double ms = Benchmark::MeasureMs([&]() { ocean.Update(0.03f); }, steps) / steps;
+		Benchmark::Report report(L"Ocean FFT ");
+		report << size << L"x" << size << L": " << ms << L" ms/update";
+		report.Print();
 	}
-	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
 }
 
 void LitWavesApp::Update(const GameTimer& gt)
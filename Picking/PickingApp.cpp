@@ -42,6 +42,7 @@ bool PickingApp::Initialize()
 	BuildCarGeometry();
 	BuildMaterials();
 	BuildRenderItems();
+	BuildSelectionBvhs();
 	BuildFrameResources();
 	BuildPSOs();
 
@@ -270,20 +271,70 @@ void PickingApp::BuildRenderItems()
 		XMStoreFloat4x4(&renderItem->World, world);
 		XMStoreFloat4x4(&renderItem->TexTransform, texTransform);
 		renderItem->Visible = visible;
-		mRitemLayer[renderLayer].emplace_back(renderItem.get());
-		mAllRitems.emplace_back(std::move(renderItem));};
-	MakeRenderItem("carGeo", "car", "gray0", 
-		XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(0.0f, 1.0f, 0.0f), XMMatrixScaling(1.0f, 1.0f, 1.0f), RenderLayer::Opaque );
-	MakeRenderItem("carGeo", "", "highlight0", XMMatrixIdentity(), XMMatrixIdentity(), RenderLayer::Highlight, false);
-	mPickedRitem = mRitemLayer[RenderLayer::Highlight].at(0);
+		auto ritem = renderItem.get();
+		mRitemLayer[renderLayer].emplace_back(ritem);
+		mAllRitems.emplace_back(std::move(renderItem));
+		return ritem; };
+	XMMATRIX carWorld = XMMatrixScaling(1.0f, 1.0f, 1.0f) * XMMatrixTranslation(0.0f, 1.0f, 0.0f);
+	auto car = MakeRenderItem("carGeo", "car", "gray0", 
+		carWorld, XMMatrixScaling(1.0f, 1.0f, 1.0f), RenderLayer::Opaque );
+	mPickedRitem = MakeRenderItem("carGeo", "", "highlight0", XMMatrixIdentity(), XMMatrixIdentity(), RenderLayer::Highlight, false);
+
+	//영역 선택된 물체 위에 덧그릴 아이템
+	car->SelectionOverlay = MakeRenderItem("carGeo", "car", "highlight0", carWorld, XMMatrixIdentity(), RenderLayer::Highlight, false);
+}
+
+void PickingApp::BuildSelectionBvhs()
+{
+	std::vector<BoundingBox> worldBounds;
+	for (auto ri : mRitemLayer[RenderLayer::Opaque])
+	{
+		//같은 서브메쉬를 쓰는 아이템끼리는 BVH 하나를 같이 쓴다.
+		auto geo = ri->Geo;
+		std::string key = geo->Name + "_" + std::to_string(ri->StartIndexLocation);
+		auto& bvh = mMeshBvhs[key];
+		if (bvh == nullptr)
+		{
+			auto vertices = reinterpret_cast<Vertex*>(geo->VertexBufferCPU->GetBufferPointer());
+			auto indices = reinterpret_cast<std::uint32_t*>(geo->IndexBufferCPU->GetBufferPointer());
+			UINT vertexCount = geo->VertexBufferByteSize / geo->VertexByteStride;
+
+			std::vector<XMFLOAT3> positions(vertexCount);
+			for (auto i : Range(0, vertexCount))
+				positions[i] = vertices[i].Pos;
+
+			std::vector<std::uint32_t> submeshIndices(ri->IndexCount);
+			for (auto i : Range(0, ri->IndexCount))
+				submeshIndices[i] = indices[ri->StartIndexLocation + i] + ri->BaseVertexLocation;
+
+			bvh = std::make_unique<MeshBvh>();
+			bvh->Build(positions, submeshIndices);
+		}
+		ri->Bvh = bvh.get();
+
+		BoundingBox box;
+		ri->BBounds.Transform(box, XMLoadFloat4x4(&ri->World));
+		worldBounds.emplace_back(box);
+		mRitemBvhItems.emplace_back(ri);
+	}
+
+	mRitemBvh.Build(worldBounds);
 }
 
 void PickingApp::BuildFrameResources()
 {
+	//덧그릴 아이템이 있는 물체의 삼각형이 모두 골라져도 들어가도록 잡는다.
+	mMarqueeIndexCapacity = 0;
+	for (auto ri : mRitemLayer[RenderLayer::Opaque])
+	{
+		if (ri->SelectionOverlay != nullptr)
+			mMarqueeIndexCapacity += ri->IndexCount;
+	}
+
 	for (auto i : Range(0, gNumFrameResources))
 	{
 		auto frameRes = std::make_unique<FrameResource>(md3dDevice.Get(), 1,
-			static_cast<UINT>(mAllRitems.size()), static_cast<UINT>(mMaterials.size()));
+			static_cast<UINT>(mAllRitems.size()), static_cast<UINT>(mMaterials.size()), mMarqueeIndexCapacity);
 		mFrameResources.emplace_back(std::move(frameRes));
 	}
 }
@@ -492,6 +543,31 @@ void PickingApp::Update(const GameTimer& gt)
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
 	UpdateMainPassCB(gt);
+	UpdateMarqueeIB();
+}
+
+void PickingApp::UpdateMarqueeIB()
+{
+	if (mMarqueeFramesDirty <= 0)
+		return;
+
+	auto dstIndices = reinterpret_cast<std::uint32_t*>(mCurFrameRes->MarqueeIB->MappedData());
+	for (auto& hit : mMarqueeHits)
+	{
+		if (hit.Triangles.empty() || hit.Ritem->SelectionOverlay == nullptr)
+			continue;
+
+		auto indices = reinterpret_cast<std::uint32_t*>(hit.Ritem->Geo->IndexBufferCPU->GetBufferPointer());
+		std::uint32_t* dst = dstIndices + hit.FirstIndex;
+		for (auto tri : hit.Triangles)
+		{
+			dst[0] = indices[tri * 3 + 0];
+			dst[1] = indices[tri * 3 + 1];
+			dst[2] = indices[tri * 3 + 2];
+			dst += 3;
+		}
+	}
+	mMarqueeFramesDirty--;
 }
 
 void PickingApp::DrawRenderItems(
@@ -550,6 +626,7 @@ void PickingApp::Draw(const GameTimer& gt)
 
 	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Highlight].Get());
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Highlight]);
+	DrawMarqueeTriangles(mCommandList.Get());
 
 	mCommandList->ResourceBarrier(1, &RvToLv(CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT)));
@@ -576,12 +653,26 @@ void PickingApp::OnMouseDown(WPARAM btnState, int x, int y)
 	}
 	else if ((btnState & MK_RBUTTON) != 0)
 	{
-		Pick(x, y);
+		mMarqueeStart.x = x;
+		mMarqueeStart.y = y;
+		mMarqueeActive = true;
+
+		SetCapture(mhMainWnd);
 	}
 }
 void PickingApp::OnMouseUp(WPARAM btnState, int x, int y)
 {
 	ReleaseCapture();
+
+	if (mMarqueeActive == false)
+		return;
+	mMarqueeActive = false;
+
+	//거의 움직이지 않았으면 한 점 피킹, 끌었으면 영역 선택. Shift를 누르고 있으면 삼각형까지 골라 그 삼각형만 강조한다.
+	if (abs(x - mMarqueeStart.x) < 4 && abs(y - mMarqueeStart.y) < 4)
+		Pick(x, y);
+	else
+		SelectRect(mMarqueeStart.x, mMarqueeStart.y, x, y, (GetAsyncKeyState(VK_SHIFT) & 0x8000) != 0);
 }
 void PickingApp::OnMouseMove(WPARAM btnState, int x, int y)
 {
@@ -679,6 +770,109 @@ void PickingApp::Pick(int sx, int sy)
 		FindPicking(ri, rayOrigin, rayDir, invView);
 }
 
+BoundingFrustum PickingApp::BuildMarqueeFrustum(int x0, int y0, int x1, int y1)
+{
+	XMFLOAT4X4 P = mCamera.GetProj4x4f();
+
+	//Pick과 같은 방식으로 사각형 모서리를 시야 공간 기울기로 바꾼다.
+	float left = (2.0f * std::min<int>(x0, x1) / mClientWidth - 1.0f) / P(0, 0);
+	float right = (2.0f * std::max<int>(x0, x1) / mClientWidth - 1.0f) / P(0, 0);
+	float top = (-2.0f * std::min<int>(y0, y1) / mClientHeight + 1.0f) / P(1, 1);
+	float bottom = (-2.0f * std::max<int>(y0, y1) / mClientHeight + 1.0f) / P(1, 1);
+
+	BoundingFrustum viewFrustum(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f),
+		right, left, top, bottom, mCamera.GetNearZ(), mCamera.GetFarZ());
+
+	XMMATRIX V = mCamera.GetView();
+	XMMATRIX invView = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(V)), V);
+
+	BoundingFrustum worldFrustum;
+	viewFrustum.Transform(worldFrustum, invView);
+	return worldFrustum;
+}
+
+void PickingApp::SelectRect(int x0, int y0, int x1, int y1, bool withTriangles)
+{
+	for (auto& hit : mMarqueeHits)
+	{
+		if (hit.Ritem->SelectionOverlay != nullptr)
+			hit.Ritem->SelectionOverlay->Visible = false;
+	}
+	mMarqueeHits.clear();
+	UINT marqueeIndexCount = 0;
+
+	BoundingFrustum worldFrustum = BuildMarqueeFrustum(x0, y0, x1, y1);
+
+	std::vector<UINT> items;
+	mRitemBvh.Query(worldFrustum, items);
+
+	for (auto itemIdx : items)
+	{
+		auto ri = mRitemBvhItems[itemIdx];
+		if (ri->Visible == false)
+			continue;
+
+		MarqueeHit hit;
+		hit.Ritem = ri;
+		if (withTriangles)
+		{
+			//BoundingFrustum::Transform은 균등 스케일까지만 맞게 옮긴다.
+			XMMATRIX W = XMLoadFloat4x4(&ri->World);
+			XMMATRIX invWorld = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(W)), W);
+
+			BoundingFrustum localFrustum;
+			worldFrustum.Transform(localFrustum, invWorld);
+			ri->Bvh->Query(localFrustum, hit.Triangles);
+			if (hit.Triangles.empty())
+				continue;
+
+			for (auto& tri : hit.Triangles)
+				tri += ri->StartIndexLocation / 3;
+
+			//물체 전체 대신 고른 삼각형만 덧그린다.
+			if (ri->SelectionOverlay != nullptr)
+			{
+				hit.FirstIndex = marqueeIndexCount;
+				marqueeIndexCount += static_cast<UINT>(hit.Triangles.size() * 3);
+			}
+		}
+		else if (ri->SelectionOverlay != nullptr)
+			ri->SelectionOverlay->Visible = true;
+
+		mMarqueeHits.emplace_back(std::move(hit));
+	}
+
+	assert(marqueeIndexCount <= mMarqueeIndexCapacity);
+	mMarqueeFramesDirty = gNumFrameResources;
+}
+
+void PickingApp::DrawMarqueeTriangles(ID3D12GraphicsCommandList* cmdList)
+{
+	UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+	auto objCBRes = mCurFrameRes->ObjectCB->Resource();
+
+	D3D12_INDEX_BUFFER_VIEW ibv;
+	ibv.BufferLocation = mCurFrameRes->MarqueeIB->Resource()->GetGPUVirtualAddress();
+	ibv.Format = DXGI_FORMAT_R32_UINT;
+	ibv.SizeInBytes = std::max<UINT>(mMarqueeIndexCapacity, 1) * sizeof(std::uint32_t);
+
+	for (auto& hit : mMarqueeHits)
+	{
+		auto overlay = hit.Ritem->SelectionOverlay;
+		if (hit.Triangles.empty() || overlay == nullptr)
+			continue;
+
+		//덧그릴 아이템의 월드 행렬과 강조 재질을 그대로 쓴다.
+		cmdList->IASetVertexBuffers(0, 1, &RvToLv(overlay->Geo->VertexBufferView()));
+		cmdList->IASetIndexBuffer(&ibv);
+		cmdList->IASetPrimitiveTopology(overlay->PrimitiveType);
+
+		D3D12_GPU_VIRTUAL_ADDRESS objCBAddr = objCBRes->GetGPUVirtualAddress() + overlay->ObjCBIndex * objCBByteSize;
+		cmdList->SetGraphicsRootConstantBufferView(0, objCBAddr);
+		cmdList->DrawIndexedInstanced(static_cast<UINT>(hit.Triangles.size() * 3), 1, hit.FirstIndex, overlay->BaseVertexLocation, 0);
+	}
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
 {
 #if defined(DEBUG) | defined(_DEBUG)
@@ -7,6 +7,8 @@
 #include "../Common/d3dApp.h"
 #include "../Common/MathHelper.h"
 #include "../Common/Camera.h"
+#include "../Common/MeshBvh.h"
+#include "../Common/BoundsBvh.h"
 #include <map>
 
 class Waves;
@@ -35,6 +37,16 @@ struct RenderItem
 	DirectX::BoundingSphere BSphere{};
 
 	bool Visible = true;
+
+	MeshBvh* Bvh = nullptr;
+	RenderItem* SelectionOverlay = nullptr;
+};
+
+struct MarqueeHit
+{
+	RenderItem* Ritem = nullptr;
+	std::vector<UINT> Triangles;	// 인덱스 버퍼 기준 삼각형 번호
+	UINT FirstIndex = 0;			// 프레임 자원의 MarqueeIB에서 Triangles의 정점 인덱스가 시작하는 곳
 };
 
 enum class RenderLayer : int
@@ -81,6 +93,7 @@ private:
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialBuffer(const GameTimer& gt);
 	void UpdateMainPassCB(const GameTimer& gt);
+	void UpdateMarqueeIB();
 
 	void LoadTextures();
 	void BuildRootSignature();
@@ -100,6 +113,10 @@ private:
 	void Pick(int sx, int sy);
 	void FindPicking(RenderItem* ri,
 		const DirectX::XMVECTOR& viewRayOrigin, const DirectX::XMVECTOR& viewRayDir, const DirectX::XMMATRIX& invView);
+	void BuildSelectionBvhs();
+	DirectX::BoundingFrustum BuildMarqueeFrustum(int x0, int y0, int x1, int y1);
+	void SelectRect(int x0, int y0, int x1, int y1, bool withTriangles);
+	void DrawMarqueeTriangles(ID3D12GraphicsCommandList* cmdList);
 
 private:
 	std::vector<std::unique_ptr<Texture>> mTextures;
@@ -126,6 +143,15 @@ private:
 	float mSunPhi = DirectX::XM_PIDIV4;
 
 	POINT mLastMousePos;
+	POINT mMarqueeStart{};
+	bool mMarqueeActive = false;
+
+	std::unordered_map<std::string, std::unique_ptr<MeshBvh>> mMeshBvhs;
+	BoundsBvh mRitemBvh;
+	std::vector<RenderItem*> mRitemBvhItems;
+	std::vector<MarqueeHit> mMarqueeHits;
+	UINT mMarqueeIndexCapacity = 0;
+	int mMarqueeFramesDirty = 0;
 
 	Camera mCamera;
 };
@@ -5,6 +5,7 @@
 #include "FrameResource.h"
 #include "../Common/GeometryGenerator.h"
 #include "ShadowMap.h"
+#include "../Common/Benchmark.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -44,6 +45,7 @@ bool ShadowMapApp::Initialize()
 	BuildSkullGeometry();
 	BuildMaterials();
 	BuildRenderItems();
+	BuildCollisionWorld();
 	BuildFrameResources();
 	BuildPSOs();
 
@@ -569,6 +571,24 @@ void ShadowMapApp::BuildRenderItems()
 	}
 }
 
+void ShadowMapApp::BuildCollisionWorld()
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<std::uint32_t> indices;
+	for (auto ri : mRitemLayer[RenderLayer::Opaque])
+	{
+		//서브메쉬가 쓰는 정점 범위만 잘라서 넣는다.
+		SubmeshGeometry submesh{ ri->IndexCount, ri->StartIndexLocation, ri->BaseVertexLocation };
+		ri->Geo->ExtractSubmesh(submesh, positions, indices);
+		mCollisionWorld.AddMesh(positions, indices, XMLoadFloat4x4(&ri->World));
+	}
+	mCollisionWorld.Build();
+
+	//근평면(1.0)이 벽 속으로 들어가지 않을 만큼 반지름을 잡는다.
+	mCamera.SetCollision(&mCollisionWorld, 1.0f);
+	mCamera.EnableCollision(true);
+}
+
 void ShadowMapApp::BuildFrameResources()
 {
 	for (auto i : Range(0, gNumFrameResources))
@@ -670,7 +690,7 @@ void ShadowMapApp::OnKeyboardInput(const GameTimer& gt)
 	float walkSpeed = 0.0f;
 	float strafeSpeed = 0.0f;
 
-	std::vector<int> keyList{ 'W', 'S', 'D', 'A' };
+	std::vector<int> keyList{ 'W', 'S', 'D', 'A', '1', '2' };
 	for_each(keyList.begin(), keyList.end(), [&](int vKey) {
 		bool bPressed = GetAsyncKeyState(vKey) & 0x8000;
 		if (bPressed)
@@ -681,6 +701,8 @@ void ShadowMapApp::OnKeyboardInput(const GameTimer& gt)
 			case 'S':		walkSpeed += -speed;		break;
 			case 'D':		strafeSpeed += speed;		break;
 			case 'A':		strafeSpeed += -speed;		break;
+			case '1':		mCamera.EnableCollision(true);		break;
+			case '2':		mCamera.EnableCollision(false);		break;
 			}
 		}});
 	
@@ -688,6 +710,36 @@ void ShadowMapApp::OnKeyboardInput(const GameTimer& gt)
 	mCamera.Move(Camera::eStrafe, strafeSpeed * dt);
 
 	mCamera.UpdateViewMatrix();
+
+	//B를 누를 때 한 번만 돌린다.
+	bool benchmarkKey = (GetAsyncKeyState('B') & 0x8000) != 0;
+	if (benchmarkKey && !mBenchmarkKeyDown)
+		RunCollisionBenchmark();
+	mBenchmarkKeyDown = benchmarkKey;
+}
+
+void ShadowMapApp::RunCollisionBenchmark()
+{
+	//카메라 자리에서 한 프레임(60Hz)에 걷는 만큼씩 아무 방향으로 이어 걸으며 MoveSphere 한 번씩을 잰다.
+	//벽에 막혀 미끄러지는 경우도 섞이도록 결과 위치에서 다음 걸음을 시작한다.
+	const int moveCount = 20000;
+	const float stepLength = 10.0f / 60.0f;
+	const float radius = 1.0f;
+
+	XMFLOAT3 pos = mCamera.GetPosition3f();
+	std::vector<double> times(moveCount);
+	for (auto i : Range(0, moveCount))
+	{
+		float angle = MathHelper::RandF(0.0f, XM_2PI);
+		XMFLOAT3 move(stepLength * cosf(angle), MathHelper::RandF(-0.2f, 0.2f) * stepLength, stepLength * sinf(angle));
+
+		times[i] = Benchmark::MeasureMs([&]() { pos = mCollisionWorld.MoveSphere(pos, move, radius); }) * 1000.0;
+	}
+
+	Benchmark::Distribution us = Benchmark::Summarize(times);
+	Benchmark::Report report(L"MoveSphere ");
+	report << moveCount << L" moves: mean " << us.Mean << L" us, p99 " << us.P99 << L" us, max " << us.Max << L" us";
+	report.Print();
 }
 
 void ShadowMapApp::AnimateMaterials(const GameTimer& gt)
@@ -7,6 +7,7 @@
 #include "../Common/d3dApp.h"
 #include "../Common/MathHelper.h"
 #include "../Common/Camera.h"
+#include "../Common/CollisionWorld.h"
 #include <map>
 
 class ShadowMap;
@@ -106,6 +107,8 @@ private:
 	void MakePSOPipelineState(GraphicsPSO psoType);
 	void BuildPSOs();
 	void BuildRenderItems();
+	void BuildCollisionWorld();
+	void RunCollisionBenchmark();
 	void DrawRenderItems(
 		ID3D12GraphicsCommandList* cmdList,
 		const std::vector<RenderItem*> ritems);
@@ -155,4 +158,6 @@ private:
 	POINT mLastMousePos;
 
 	Camera mCamera;
+	CollisionWorld mCollisionWorld;
+	bool mBenchmarkKeyDown = false;
 };
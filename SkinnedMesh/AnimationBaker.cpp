@@ -0,0 +1,81 @@
+#include "AnimationBaker.h"
+#include "CpuSkinning.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+void BakeAnimationClip(const SkinnedData& skinnedInfo, SkinnedData::ClipHandle clip,
+	const AnimationBakeSettings& settings, BakedAnimationClip& baked,
+	const std::vector<M3DLoader::SkinnedVertex>* vertices, AnimationBakeReport* report)
+{
+	const UINT numBones = skinnedInfo.BoneCount();
+	const float startTime = clip->GetClipStartTime();
+	const float duration = clip->GetClipEndTime() - startTime;
+	const unsigned frameCount = duration > 0.0f ?
+		static_cast<unsigned>(ceilf(duration * std::max<float>(settings.SampleRate, 0.0f))) + 1 : 1;
+
+	// GetFinalTransforms와 같은 원래 경로. 클립에 붙은 표를 거치지 않으려고 직접 부른다.
+	SkinnedData::Scratch scratch;
+	scratch.Reserve(numBones);
+	std::vector<int> cursors(skinnedInfo.KeyCursorCount(), -1);
+	auto sampleClip = [&](float t, XMFLOAT4X4* finalTransforms) {
+		clip->SamplePoses(t, cursors.data(), scratch.Poses.data());
+		SoaAnimationClip::BuildMatrices(scratch.Poses.data(), numBones, scratch.ToParent.data());
+		skinnedInfo.ConcatenateHierarchy(scratch.ToParent.data(), finalTransforms, scratch);
+	};
+
+	std::vector<XMFLOAT4X4> pose(numBones);
+	baked.Resize(startTime, duration, numBones, frameCount);
+	baked.SetInterpolate(settings.Interpolate);
+	for (unsigned f = 0; f < frameCount; ++f)
+	{
+		sampleClip(frameCount > 1 ? startTime + duration * f / (frameCount - 1) : startTime, pose.data());
+		Matrix3x4* frame = baked.Frame(f);
+		for (UINT b = 0; b < numBones; ++b)
+		{
+			for (int r = 0; r < 3; ++r)
+				XMStoreFloat4A(&frame[b].Rows[r], XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pose[b].m[r])));
+		}
+	}
+
+	if (report == nullptr)
+		return;
+
+	*report = AnimationBakeReport();
+	report->FrameCount = frameCount;
+	report->BakedBytes = baked.ByteSize();
+	report->KeyBytes = clip->Compressed.ByteSize();
+	for (const BoneAnimation& bone : clip->BoneAnimations)
+		report->KeyBytes += bone.Keyframes.size() * sizeof(Keyframe);
+
+	if (vertices == nullptr || vertices->empty())
+		return;
+
+	// 프레임 위, 프레임 사이의 한가운데(가까운 프레임을 쓸 때 가장 나쁜 곳)와 그 사이를 모두 지난다.
+	const UINT vertexCount = static_cast<UINT>(vertices->size());
+	SkinnedVertexSoa expected, actual;
+	expected.Resize(vertexCount);
+	actual.Resize(vertexCount);
+	std::vector<XMFLOAT4X4> bakedPose(numBones);
+	const unsigned steps = (frameCount - 1) * AnimationBakeReport::SubSteps + 1;
+	double errorSum = 0.0;
+	for (unsigned s = 0; s < steps; ++s)
+	{
+		float t = steps > 1 ? startTime + duration * s / (steps - 1) : startTime;
+		sampleClip(t, pose.data());
+		baked.Sample(t, bakedPose.data());
+		SkinVertices(vertices->data(), vertexCount, pose.data(), expected.Groups.data());
+		SkinVertices(vertices->data(), vertexCount, bakedPose.data(), actual.Groups.data());
+
+		for (UINT v = 0; v < vertexCount; ++v)
+		{
+			XMFLOAT3 a = expected.Position(v);
+			XMFLOAT3 b = actual.Position(v);
+			float error = XMVectorGetX(XMVector3Length(XMLoadFloat3(&a) - XMLoadFloat3(&b)));
+			report->MaxVertexError = std::max<float>(report->MaxVertexError, error);
+			errorSum += error;
+		}
+	}
+	report->MeanVertexError = static_cast<float>(errorSum / (static_cast<double>(steps) * vertexCount));
+}
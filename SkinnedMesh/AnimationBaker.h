@@ -0,0 +1,32 @@
+#pragma once
+
+#include "SkinnedData.h"
+#include "LoadM3d.h"
+
+struct AnimationBakeSettings
+{
+	// 1초에 담을 프레임 수. 클립 길이를 고르게 나누도록 간격을 조금 줄이므로 실제로는 이보다 조금 많다.
+	float SampleRate = 30.0f;
+	// 끄면 재생할 때 이웃 프레임을 보간하지 않고 가까운 프레임을 쓴다.
+	bool Interpolate = true;
+};
+
+struct AnimationBakeReport
+{
+	unsigned FrameCount = 0;
+	size_t BakedBytes = 0;		// 표
+	size_t KeyBytes = 0;		// 원래 클립의 Keyframe(압축한 클립이면 압축한 트랙)
+	// 원래 경로(SoA 샘플 + 계층)로 스키닝한 정점과 표로 스키닝한 정점의 거리(모델 공간).
+	// 프레임 사이를 SubSteps로 나눈 시간마다 잰다.
+	float MaxVertexError = 0.0f;
+	float MeanVertexError = 0.0f;
+
+	static constexpr int SubSteps = 4;
+};
+
+// 오프라인이나 로딩 때 한 번 돌린다. skinnedInfo의 골격으로 clip을 샘플해 baked를 채우므로
+// 결과는 같은 골격의 SkinnedData::SetBakedClip에만 넘길 수 있다. clip에 이미 붙은 표는 보지 않는다.
+// report와 vertices(스킨드 메쉬)가 있으면 정점 위치 오차를 잰다.
+void BakeAnimationClip(const SkinnedData& skinnedInfo, SkinnedData::ClipHandle clip,
+	const AnimationBakeSettings& settings, BakedAnimationClip& baked,
+	const std::vector<M3DLoader::SkinnedVertex>* vertices = nullptr, AnimationBakeReport* report = nullptr);
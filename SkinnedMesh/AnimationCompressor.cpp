@@ -0,0 +1,175 @@
+#include "AnimationCompressor.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// 한 트랙(이동, 회전, 크기 중 하나)을 시간과 XMFLOAT4 값으로 풀어 둔 것
+	struct Track
+	{
+		std::vector<float> Times;
+		std::vector<XMFLOAT4> Values;
+		bool IsRotation = false;
+	};
+
+	XMVECTOR Interpolate(const Track& track, FXMVECTOR a, FXMVECTOR b, float u)
+	{
+		return track.IsRotation ? XMQuaternionSlerp(a, b, u) : XMVectorLerp(a, b, u);
+	}
+
+	// 두 회전 사이의 각도. 1에 가까운 내적에 acos를 쓰면 float 반올림만으로 0.04도쯤 나와서
+	// 반구를 맞춘 뒤 차와 합의 길이로 atan2를 쓴다. (|a - b| = 2sin(h/2), |a + b| = 2cos(h/2), 회전각 = 2h)
+	float Angle(FXMVECTOR a, FXMVECTOR b)
+	{
+		XMVECTOR qa = XMQuaternionNormalize(a);
+		XMVECTOR qb = XMQuaternionNormalize(b);
+		if (XMVectorGetX(XMQuaternionDot(qa, qb)) < 0.0f)
+			qb = XMVectorNegate(qb);
+		return 4.0f * atan2f(XMVectorGetX(XMVector4Length(qa - qb)), XMVectorGetX(XMVector4Length(qa + qb)));
+	}
+
+	float Error(const Track& track, FXMVECTOR a, FXMVECTOR b)
+	{
+		if (track.IsRotation)
+			return Angle(a, b);
+		return XMVectorGetX(XMVector3Length(a - b));
+	}
+
+	// 남길 키의 번호. 앞에서부터 남긴 키(anchor)에서 구간을 늘려 가다가 그 사이의 원래 키 하나라도
+	// tolerance를 넘으면 바로 앞 키를 남긴다. stored는 저장했다 되살린 값(양자화 오차 포함)이다.
+	std::vector<int> ReduceKeys(const Track& track, const std::vector<XMFLOAT4>& stored, float tolerance)
+	{
+		const int n = static_cast<int>(track.Times.size());
+		if (n == 0)
+			return {};
+
+		// 트랙 전체가 첫 키 하나로 되면 키 하나만 남긴다.
+		XMVECTOR first = XMLoadFloat4(&stored[0]);
+		bool constant = true;
+		for (int k = 0; k < n && constant; ++k)
+			constant = Error(track, first, XMLoadFloat4(&track.Values[k])) <= tolerance;
+		if (constant)
+			return { 0 };
+
+		auto Fits = [&](int a, int b) {
+			XMVECTOR A = XMLoadFloat4(&stored[a]);
+			XMVECTOR B = XMLoadFloat4(&stored[b]);
+			for (int k = a + 1; k < b; ++k)
+			{
+				float u = (track.Times[k] - track.Times[a]) / (track.Times[b] - track.Times[a]);
+				if (Error(track, Interpolate(track, A, B, u), XMLoadFloat4(&track.Values[k])) > tolerance)
+					return false;
+			}
+			return true; };
+
+		std::vector<int> kept{ 0 };
+		int anchor = 0;
+		for (int j = 2; j < n; ++j)
+		{
+			if (!Fits(anchor, j))
+			{
+				anchor = j - 1;
+				kept.push_back(anchor);
+			}
+		}
+		kept.push_back(n - 1);
+		return kept;
+	}
+
+	std::uint16_t QuantizeTime(const CompressedAnimationClip& clip, float t)
+	{
+		if (clip.Duration <= 0.0f)
+			return 0;
+		float u = std::min<float>(std::max<float>((t - clip.StartTime) / clip.Duration, 0.0f), 1.0f);
+		return static_cast<std::uint16_t>(lrintf(u * CompressedAnimationClip::TimeSteps));
+	}
+
+	template<typename T>
+	size_t VectorBytes(const std::vector<T>& v) { return v.size() * sizeof(T); }
+}
+
+void CompressAnimationClip(const AnimationClip& clip, const AnimationCompressionSettings& settings,
+	CompressedAnimationClip& compressed, AnimationCompressionReport* report)
+{
+	compressed.StartTime = clip.GetClipStartTime();
+	compressed.Duration = clip.GetClipEndTime() - compressed.StartTime;
+	compressed.BoneAnimations.assign(clip.BoneAnimations.size(), CompressedBoneAnimation{});
+
+	for (size_t b = 0; b < clip.BoneAnimations.size(); ++b)
+	{
+		const std::vector<Keyframe>& keys = clip.BoneAnimations[b].Keyframes;
+		CompressedBoneAnimation& out = compressed.BoneAnimations[b];
+
+		Track translation, rotation, scale;
+		rotation.IsRotation = true;
+		for (const Keyframe& key : keys)
+		{
+			for (Track* track : { &translation, &rotation, &scale })
+				track->Times.push_back(key.TimePos);
+			translation.Values.emplace_back(key.Translation.x, key.Translation.y, key.Translation.z, 0.0f);
+			rotation.Values.push_back(key.RotationQuat);
+			scale.Values.emplace_back(key.Scale.x, key.Scale.y, key.Scale.z, 0.0f);
+		}
+
+		// 회전은 48비트로 줄인 값으로 보간해 보고 키를 고른다.
+		std::vector<XMFLOAT4> packedRotations(rotation.Values.size());
+		std::vector<PackedQuaternion> packed(rotation.Values.size());
+		for (size_t k = 0; k < packed.size(); ++k)
+		{
+			packed[k] = PackQuaternion(XMLoadFloat4(&rotation.Values[k]));
+			XMStoreFloat4(&packedRotations[k], UnpackQuaternion(packed[k]));
+		}
+
+		for (int k : ReduceKeys(translation, translation.Values, settings.TranslationTolerance))
+		{
+			out.TranslationTimes.push_back(QuantizeTime(compressed, translation.Times[k]));
+			out.Translations.push_back(keys[k].Translation);
+		}
+		for (int k : ReduceKeys(rotation, packedRotations, settings.RotationTolerance))
+		{
+			out.RotationTimes.push_back(QuantizeTime(compressed, rotation.Times[k]));
+			out.Rotations.push_back(packed[k]);
+		}
+		for (int k : ReduceKeys(scale, scale.Values, settings.ScaleTolerance))
+		{
+			out.ScaleTimes.push_back(QuantizeTime(compressed, scale.Times[k]));
+			out.Scales.push_back(keys[k].Scale);
+		}
+	}
+
+	if (report == nullptr)
+		return;
+
+	report->OriginalBytes = 0;
+	report->OriginalKeys = 0;
+	report->CompressedKeys = 0;
+	report->CompressedBytes = compressed.ByteSize();
+	report->Bones.assign(clip.BoneAnimations.size(), AnimationCompressionReport::BoneError{});
+	for (size_t b = 0; b < clip.BoneAnimations.size(); ++b)
+	{
+		const BoneAnimation& original = clip.BoneAnimations[b];
+		const CompressedBoneAnimation& bone = compressed.BoneAnimations[b];
+		report->OriginalBytes += VectorBytes(original.Keyframes);
+		report->OriginalKeys += original.Keyframes.size() * 3;
+		report->CompressedKeys += bone.Translations.size() + bone.Rotations.size() + bone.Scales.size();
+
+		AnimationCompressionReport::BoneError& error = report->Bones[b];
+		int cursors[CompressedAnimationClip::TracksPerBone] = { -1, -1, -1 };
+		auto Measure = [&](float t) {
+			XMVECTOR T0, Q0, S0, T1, Q1, S1;
+			original.Sample(t, T0, Q0, S0);
+			compressed.SampleBone(static_cast<unsigned>(b), t, cursors, T1, Q1, S1);
+			error.Translation = std::max<float>(error.Translation, XMVectorGetX(XMVector3Length(T1 - T0)));
+			error.RotationDegrees = std::max<float>(error.RotationDegrees, XMConvertToDegrees(Angle(Q0, Q1)));
+			error.Scale = std::max<float>(error.Scale, XMVectorGetX(XMVector3Length(S1 - S0))); };
+
+		for (size_t k = 0; k < original.Keyframes.size(); ++k)
+		{
+			Measure(original.Keyframes[k].TimePos);
+			if (k + 1 < original.Keyframes.size())
+				Measure(0.5f * (original.Keyframes[k].TimePos + original.Keyframes[k + 1].TimePos));
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "SkinnedData.h"
+
+// 키를 뺐을 때 남은 키로 보간한 값이 원래 키와 이만큼 안에 있으면 뺀다. (뼈의 부모 기준 공간)
+struct AnimationCompressionSettings
+{
+	float TranslationTolerance = 0.001f;
+	float RotationTolerance = 0.0005f;	// 라디안
+	float ScaleTolerance = 0.001f;
+};
+
+struct AnimationCompressionReport
+{
+	struct BoneError
+	{
+		float Translation = 0.0f;
+		float RotationDegrees = 0.0f;
+		float Scale = 0.0f;
+	};
+
+	size_t OriginalBytes = 0;
+	size_t CompressedBytes = 0;
+	size_t OriginalKeys = 0;
+	size_t CompressedKeys = 0;
+	// 원래 키 시간과 그 중간에서 잰 뼈별 최대 오차. 재생할 때와 같이 압축한 트랙을 바로 샘플해서 잰다.
+	std::vector<BoneError> Bones;
+
+	float Ratio() const { return CompressedBytes > 0 ? static_cast<float>(OriginalBytes) / CompressedBytes : 0.0f; }
+};
+
+// 오프라인에서 한 번 돌리는 압축. report가 있으면 원래 클립과 비교한 결과를 채운다.
+// 결과는 SkinnedData::SetCompressedClip으로 넣으면 압축한 채로 재생된다.
+void CompressAnimationClip(const AnimationClip& clip, const AnimationCompressionSettings& settings,
+	CompressedAnimationClip& compressed, AnimationCompressionReport* report = nullptr);
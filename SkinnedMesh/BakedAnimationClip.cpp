@@ -0,0 +1,57 @@
+#include "BakedAnimationClip.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+void BakedAnimationClip::Resize(float startTime, float duration, unsigned boneCount, unsigned frameCount)
+{
+	mStartTime = startTime;
+	mBoneCount = boneCount;
+	mFrameCount = frameCount;
+	mFramesPerSecond = frameCount > 1 && duration > 0.0f ? (frameCount - 1) / duration : 0.0f;
+	mPalettes.resize(static_cast<size_t>(frameCount) * boneCount);
+}
+
+void BakedAnimationClip::Clear()
+{
+	mPalettes.clear();
+	mBoneCount = 0;
+	mFrameCount = 0;
+	mFramesPerSecond = 0.0f;
+}
+
+void BakedAnimationClip::Sample(float t, XMFLOAT4X4* finalTransforms) const
+{
+	const float last = static_cast<float>(mFrameCount - 1);
+	const float u = std::min<float>(std::max<float>((t - mStartTime) * mFramesPerSecond, 0.0f), last);
+	const XMVECTOR rowW = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	if (!mInterpolate || mFrameCount == 1)
+	{
+		const Matrix3x4* frame = Frame(static_cast<unsigned>(u + 0.5f));
+		for (unsigned b = 0; b < mBoneCount; ++b)
+		{
+			XMFLOAT4X4& finalTransform = finalTransforms[b];
+			for (int r = 0; r < 3; ++r)
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[r]), XMLoadFloat4A(&frame[b].Rows[r]));
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[3]), rowW);
+		}
+		return;
+	}
+
+	const unsigned i = std::min<unsigned>(static_cast<unsigned>(u), mFrameCount - 2);
+	const XMVECTOR s = XMVectorReplicate(u - i);
+	const Matrix3x4* a = Frame(i);
+	const Matrix3x4* b = Frame(i + 1);
+	for (unsigned bone = 0; bone < mBoneCount; ++bone)
+	{
+		XMFLOAT4X4& finalTransform = finalTransforms[bone];
+		for (int r = 0; r < 3; ++r)
+		{
+			XMVECTOR row = XMLoadFloat4A(&a[bone].Rows[r]);
+			row = XMVectorMultiplyAdd(s, XMLoadFloat4A(&b[bone].Rows[r]) - row, row);
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[r]), row);
+		}
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[3]), rowW);
+	}
+}
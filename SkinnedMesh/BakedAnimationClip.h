@@ -0,0 +1,41 @@
+#pragma once
+
+#include "SoaAnimationClip.h"
+
+// 클립을 일정한 간격으로 샘플해 최종 변환(팔레트)을 프레임 순서로 이어 담은 표. 골격의 오프셋까지 곱한 값이라
+// 재생은 이웃한 두 프레임을 찾아 선형 보간하거나 가까운 프레임을 복사하는 것뿐이다. 키 탐색도 계층 계산도 없다.
+// 뼈마다 Matrix3x4(48바이트)로 담아 셰이더 팔레트와 같은 배치이고 크기가 있는 뼈도 그대로 담는다.
+// 두 행렬을 선형 보간하면 회전이 조금 줄어들므로 프레임 간격이 벌어질수록 오차가 커진다.
+class BakedAnimationClip
+{
+public:
+	// 프레임 i는 시간 startTime + duration * i / (frameCount - 1)이다. 값은 Frame으로 채운다.
+	void Resize(float startTime, float duration, unsigned boneCount, unsigned frameCount);
+	void Clear();
+
+	bool Empty() const { return mPalettes.empty(); }
+	unsigned BoneCount() const { return mBoneCount; }
+	unsigned FrameCount() const { return mFrameCount; }
+	// 1초에 담은 프레임 수
+	float SampleRate() const { return mFramesPerSecond; }
+	// 표가 차지하는 바이트 수
+	size_t ByteSize() const { return mPalettes.size() * sizeof(Matrix3x4); }
+
+	// 끄면 가장 가까운 프레임을 그대로 쓴다.
+	void SetInterpolate(bool interpolate) { mInterpolate = interpolate; }
+	bool Interpolates() const { return mInterpolate; }
+
+	Matrix3x4* Frame(unsigned frame) { return &mPalettes[static_cast<size_t>(frame) * mBoneCount]; }
+	const Matrix3x4* Frame(unsigned frame) const { return &mPalettes[static_cast<size_t>(frame) * mBoneCount]; }
+
+	// 시간 t(클립 구간으로 자른다)의 최종 변환 BoneCount()개를 GetFinalTransforms처럼 전치한 4x4로 쓴다.
+	void Sample(float t, DirectX::XMFLOAT4X4* finalTransforms) const;
+
+private:
+	std::vector<Matrix3x4> mPalettes;		// FrameCount() * BoneCount()
+	float mStartTime = 0.0f;
+	float mFramesPerSecond = 0.0f;			// (mFrameCount - 1) / mDuration
+	unsigned mBoneCount = 0;
+	unsigned mFrameCount = 0;
+	bool mInterpolate = true;
+};
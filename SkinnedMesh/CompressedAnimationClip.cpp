@@ -0,0 +1,160 @@
+#include "CompressedAnimationClip.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr float Sqrt2 = 1.41421356f;
+	constexpr std::uint32_t ComponentMax = (1u << 15) - 1;
+
+	template<typename T>
+	size_t VectorBytes(const std::vector<T>& v) { return v.size() * sizeof(T); }
+
+	// 양자화한 시간 t에서 트랙의 구간 [k, k + 1]과 그 안의 비율. 양 끝 밖이면 끝 키 하나(k0 == k1)를 쓴다.
+	void FindTrackKeys(const std::vector<std::uint16_t>& times, float t, int* cursor, int& k0, int& k1, float& u)
+	{
+		const int count = static_cast<int>(times.size());
+		u = 0.0f;
+		if (count == 1 || t <= times.front())
+		{
+			k0 = k1 = 0;
+			if (cursor != nullptr) *cursor = 0;
+			return;
+		}
+		if (t >= times.back())
+		{
+			k0 = k1 = count - 1;
+			if (cursor != nullptr) *cursor = count - 2;
+			return;
+		}
+
+		k0 = FindKeySegment(times.data(), count, t, cursor != nullptr ? *cursor : -1);
+		k1 = k0 + 1;
+		if (cursor != nullptr) *cursor = k0;
+		u = (t - times[k0]) / static_cast<float>(times[k1] - times[k0]);
+	}
+
+	XMVECTOR SampleVector(const std::vector<std::uint16_t>& times, const std::vector<XMFLOAT3>& values,
+		float t, int* cursor, FXMVECTOR empty)
+	{
+		if (times.empty())
+			return empty;
+
+		int k0, k1;
+		float u;
+		FindTrackKeys(times, t, cursor, k0, k1, u);
+		return XMVectorLerp(XMLoadFloat3(&values[k0]), XMLoadFloat3(&values[k1]), u);
+	}
+}
+
+PackedQuaternion PackQuaternion(FXMVECTOR Q)
+{
+	XMFLOAT4 q;
+	XMStoreFloat4(&q, XMQuaternionNormalize(Q));
+	const float c[4] = { q.x, q.y, q.z, q.w };
+
+	int largest = 0;
+	for (int i = 1; i < 4; ++i)
+	{
+		if (fabsf(c[i]) > fabsf(c[largest]))
+			largest = i;
+	}
+	// q와 -q는 같은 회전이라 뺀 성분이 양수가 되게 부호를 맞춘다.
+	const float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	std::uint64_t bits = static_cast<std::uint64_t>(largest);
+	for (int i = 0, shift = 2; i < 4; ++i)
+	{
+		if (i == largest) continue;
+
+		float v = std::min<float>(std::max<float>(c[i] * sign * Sqrt2, -1.0f), 1.0f);
+		std::uint64_t quantized = static_cast<std::uint64_t>(lrintf((v * 0.5f + 0.5f) * ComponentMax));
+		bits |= quantized << shift;
+		shift += 15;
+	}
+
+	PackedQuaternion packed;
+	packed.Bits[0] = static_cast<std::uint16_t>(bits);
+	packed.Bits[1] = static_cast<std::uint16_t>(bits >> 16);
+	packed.Bits[2] = static_cast<std::uint16_t>(bits >> 32);
+	return packed;
+}
+
+XMVECTOR UnpackQuaternion(const PackedQuaternion& packed)
+{
+	const std::uint64_t bits = static_cast<std::uint64_t>(packed.Bits[0]) |
+		(static_cast<std::uint64_t>(packed.Bits[1]) << 16) |
+		(static_cast<std::uint64_t>(packed.Bits[2]) << 32);
+	const int largest = static_cast<int>(bits & 3);
+
+	float c[4];
+	float sum = 0.0f;
+	for (int i = 0, shift = 2; i < 4; ++i)
+	{
+		if (i == largest) continue;
+
+		float v = static_cast<float>((bits >> shift) & ComponentMax) / ComponentMax;
+		c[i] = (v * 2.0f - 1.0f) / Sqrt2;
+		sum += c[i] * c[i];
+		shift += 15;
+	}
+	c[largest] = sqrtf(std::max<float>(1.0f - sum, 0.0f));
+
+	return XMQuaternionNormalize(XMVectorSet(c[0], c[1], c[2], c[3]));
+}
+
+size_t CompressedAnimationClip::ByteSize() const
+{
+	size_t bytes = 0;
+	for (const CompressedBoneAnimation& bone : BoneAnimations)
+	{
+		bytes += VectorBytes(bone.TranslationTimes) + VectorBytes(bone.Translations);
+		bytes += VectorBytes(bone.RotationTimes) + VectorBytes(bone.Rotations);
+		bytes += VectorBytes(bone.ScaleTimes) + VectorBytes(bone.Scales);
+	}
+	return bytes;
+}
+
+void CompressedAnimationClip::SampleBone(unsigned bone, float t, int* cursors,
+	XMVECTOR& T, XMVECTOR& Q, XMVECTOR& S) const
+{
+	const CompressedBoneAnimation& track = BoneAnimations[bone];
+	const float time = Duration > 0.0f ?
+		std::min<float>(std::max<float>((t - StartTime) / Duration, 0.0f), 1.0f) * TimeSteps : 0.0f;
+
+	T = SampleVector(track.TranslationTimes, track.Translations, time, cursors != nullptr ? &cursors[0] : nullptr,
+		XMVectorZero());
+	S = SampleVector(track.ScaleTimes, track.Scales, time, cursors != nullptr ? &cursors[2] : nullptr,
+		XMVectorSplatOne());
+
+	if (track.RotationTimes.empty())
+	{
+		Q = XMQuaternionIdentity();
+		return;
+	}
+
+	int k0, k1;
+	float u;
+	FindTrackKeys(track.RotationTimes, time, cursors != nullptr ? &cursors[1] : nullptr, k0, k1, u);
+	Q = UnpackQuaternion(track.Rotations[k0]);
+	if (k1 != k0)
+		Q = XMQuaternionSlerp(Q, UnpackQuaternion(track.Rotations[k1]), u);
+}
+
+void CompressedAnimationClip::Sample(float t, int* cursors, SoaTransform* poses) const
+{
+	const unsigned boneCount = static_cast<unsigned>(BoneAnimations.size());
+	const unsigned groupCount = (boneCount + SoaAnimationClip::Lanes - 1) / SoaAnimationClip::Lanes;
+	for (unsigned bone = 0; bone < groupCount * SoaAnimationClip::Lanes; ++bone)
+	{
+		// 남는 레인은 단위 변환으로 채운다.
+		XMVECTOR T = XMVectorZero();
+		XMVECTOR Q = XMQuaternionIdentity();
+		XMVECTOR S = XMVectorSplatOne();
+		if (bone < boneCount)
+			SampleBone(bone, t, cursors != nullptr ? &cursors[bone * TracksPerBone] : nullptr, T, Q, S);
+
+		poses[bone / SoaAnimationClip::Lanes].SetLane(bone % SoaAnimationClip::Lanes, T, Q, S);
+	}
+}
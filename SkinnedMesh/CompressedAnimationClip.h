@@ -0,0 +1,50 @@
+#pragma once
+
+#include "SoaAnimationClip.h"
+
+// 단위 쿼터니언을 가장 큰 성분을 뺀 세 성분(각 15비트)과 뺀 성분의 자리(2비트)로 48비트에 담는다.
+// 뺀 성분은 양수로 맞춰 두고 sqrt(1 - a^2 - b^2 - c^2)로 되살린다. 나머지 세 성분은 [-1/sqrt(2), 1/sqrt(2)] 안이다.
+struct PackedQuaternion
+{
+	std::uint16_t Bits[3];
+};
+
+PackedQuaternion PackQuaternion(DirectX::FXMVECTOR Q);
+DirectX::XMVECTOR UnpackQuaternion(const PackedQuaternion& packed);
+
+// 압축한 뼈 애니메이션. 이동, 회전, 크기를 따로 줄이므로 트랙마다 키 시간이 다르다.
+// 시간은 클립 구간을 0 ~ TimeSteps로 나눈 값이다.
+struct CompressedBoneAnimation
+{
+	std::vector<std::uint16_t> TranslationTimes;
+	std::vector<DirectX::XMFLOAT3> Translations;
+	std::vector<std::uint16_t> RotationTimes;
+	std::vector<PackedQuaternion> Rotations;
+	std::vector<std::uint16_t> ScaleTimes;
+	std::vector<DirectX::XMFLOAT3> Scales;
+};
+
+// AnimationCompressor가 만든 클립. 재생할 때도 압축을 풀지 않는다. 트랙마다 t를 감싸는 구간을 찾아
+// 그 양 끝 키만 풀어서 보간(회전은 slerp)하므로 메모리에는 압축한 트랙만 있다.
+struct CompressedAnimationClip
+{
+	static constexpr float TimeSteps = 65535.0f;
+	// 뼈마다 이동, 회전, 크기 트랙의 키 커서
+	static constexpr unsigned TracksPerBone = 3;
+
+	float StartTime = 0.0f;
+	float Duration = 0.0f;
+	std::vector<CompressedBoneAnimation> BoneAnimations;
+
+	bool Empty() const { return BoneAnimations.empty(); }
+	// 키 데이터가 차지하는 바이트 수
+	size_t ByteSize() const;
+
+	// 뼈 하나의 시간 t(클립 구간으로 자른다) 값. cursors는 그 뼈의 트랙 TracksPerBone개이고 nullptr이면
+	// 매번 이진 탐색한다. 키가 없는 트랙은 단위 변환의 값이다.
+	void SampleBone(unsigned bone, float t, int* cursors,
+		DirectX::XMVECTOR& T, DirectX::XMVECTOR& Q, DirectX::XMVECTOR& S) const;
+	// SoaAnimationClip::Sample처럼 poses에 뼈 네 개씩 시간 t의 포즈를 쓴다.
+	// cursors는 뼈마다 TracksPerBone개(처음엔 -1)이고 nullptr이면 매번 이진 탐색한다.
+	void Sample(float t, int* cursors, SoaTransform* poses) const;
+};
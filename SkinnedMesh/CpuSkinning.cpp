@@ -0,0 +1,262 @@
+#include "CpuSkinning.h"
+#include "../Common/TaskScheduler.h"
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+using SkinnedVertex = M3DLoader::SkinnedVertex;
+
+namespace
+{
+	// 작업 하나가 맡는 정점 수. 여덟의 배수라야 작업 경계가 SoA 묶음 경계와 맞는다.
+	constexpr UINT VerticesPerTask = 1024;
+
+	void GetWeights(const SkinnedVertex& v, float weights[4])
+	{
+		weights[0] = v.BoneWeights.x;
+		weights[1] = v.BoneWeights.y;
+		weights[2] = v.BoneWeights.z;
+		weights[3] = 1.0f - weights[0] - weights[1] - weights[2];
+	}
+
+	// 정점 하나의 뼈 행렬 네 개를 가중치로 섞는다. 전치된 상태의 앞 세 행만 쓰면 된다.
+	void BlendRows(const SkinnedVertex& v, const XMFLOAT4X4* palette, XMVECTOR& row0, XMVECTOR& row1, XMVECTOR& row2)
+	{
+		float weights[4];
+		GetWeights(v, weights);
+
+		row0 = row1 = row2 = XMVectorZero();
+		for (int i = 0; i < 4; ++i)
+		{
+			const XMFLOAT4X4& m = palette[v.BoneIndices[i]];
+			XMVECTOR w = XMVectorReplicate(weights[i]);
+			row0 = XMVectorMultiplyAdd(w, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(m.m[0])), row0);
+			row1 = XMVectorMultiplyAdd(w, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(m.m[1])), row1);
+			row2 = XMVectorMultiplyAdd(w, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(m.m[2])), row2);
+		}
+	}
+
+	// 정점 네 개를 스키닝해 SoA 묶음 하나로 만든다.
+	void SkinGroup(const SkinnedVertex* const v[4], const XMFLOAT4X4* palette, SkinnedVertexSoa::Group& out)
+	{
+		XMMATRIX rows[3];
+		for (int lane = 0; lane < 4; ++lane)
+			BlendRows(*v[lane], palette, rows[0].r[lane], rows[1].r[lane], rows[2].r[lane]);
+
+		// 전치하면 m[r].r[c]가 네 정점의 원소 (r, c)를 모은 것이 된다.
+		const XMMATRIX m[3] = { XMMatrixTranspose(rows[0]), XMMatrixTranspose(rows[1]), XMMatrixTranspose(rows[2]) };
+
+		auto Gather = [&v](const XMFLOAT3 SkinnedVertex::* member) {
+			return XMMatrixTranspose(XMMATRIX(XMLoadFloat3(&(v[0]->*member)), XMLoadFloat3(&(v[1]->*member)),
+				XMLoadFloat3(&(v[2]->*member)), XMLoadFloat3(&(v[3]->*member)))); };
+		auto Transform = [&m](const XMMATRIX& p, int row, bool point) {
+			XMVECTOR r = XMVectorMultiplyAdd(m[row].r[0], p.r[0],
+				XMVectorMultiplyAdd(m[row].r[1], p.r[1], m[row].r[2] * p.r[2]));
+			return point ? r + m[row].r[3] : r; };
+
+		XMMATRIX pos = Gather(&SkinnedVertex::Pos);
+		XMStoreFloat4A(&out.PosX, Transform(pos, 0, true));
+		XMStoreFloat4A(&out.PosY, Transform(pos, 1, true));
+		XMStoreFloat4A(&out.PosZ, Transform(pos, 2, true));
+
+		XMMATRIX normal = Gather(&SkinnedVertex::Normal);
+		XMStoreFloat4A(&out.NormalX, Transform(normal, 0, false));
+		XMStoreFloat4A(&out.NormalY, Transform(normal, 1, false));
+		XMStoreFloat4A(&out.NormalZ, Transform(normal, 2, false));
+
+		XMMATRIX tangent = Gather(&SkinnedVertex::TangentU);
+		XMStoreFloat4A(&out.TangentX, Transform(tangent, 0, false));
+		XMStoreFloat4A(&out.TangentY, Transform(tangent, 1, false));
+		XMStoreFloat4A(&out.TangentZ, Transform(tangent, 2, false));
+	}
+
+#if defined(__AVX2__)
+	const float* PaletteRow(const XMFLOAT4X4* palette, BYTE bone, int row)
+	{
+		return palette[bone].m[row];
+	}
+
+	// a의 네 float을 아래 반쪽에, b의 네 float을 위 반쪽에 담는다.
+	__m256 LoadPair(const float* a, const float* b)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(a)), _mm_loadu_ps(b), 1);
+	}
+
+	// 128비트 반쪽마다 따로 4x4 전치한다.
+	void Transpose(__m256& r0, __m256& r1, __m256& r2, __m256& r3)
+	{
+		__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+		__m256 t1 = _mm256_unpacklo_ps(r2, r3);
+		__m256 t2 = _mm256_unpackhi_ps(r0, r1);
+		__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+		r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+		r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+		r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	}
+
+	void StorePair(SkinnedVertexSoa::Group& lo, SkinnedVertexSoa::Group& hi,
+		XMFLOAT4A SkinnedVertexSoa::Group::* member, __m256 v)
+	{
+		_mm_store_ps(&(lo.*member).x, _mm256_castps256_ps128(v));
+		_mm_store_ps(&(hi.*member).x, _mm256_extractf128_ps(v, 1));
+	}
+
+	// 정점 여덟 개를 스키닝해 SoA 묶음 두 개로 만든다. 정점 k와 k + 4를 한 레지스터의 두 반쪽에 둔다.
+	// 반쪽마다 전치하면 아래 반쪽이 lo 묶음, 위 반쪽이 hi 묶음의 성분이 된다.
+	void SkinGroupPair(const SkinnedVertex* const v[8], const XMFLOAT4X4* palette,
+		SkinnedVertexSoa::Group& lo, SkinnedVertexSoa::Group& hi)
+	{
+		__m256 m[3][4];
+		for (int k = 0; k < 4; ++k)
+		{
+			const SkinnedVertex& a = *v[k];
+			const SkinnedVertex& b = *v[k + 4];
+			float wa[4], wb[4];
+			GetWeights(a, wa);
+			GetWeights(b, wb);
+
+			for (int row = 0; row < 3; ++row)
+			{
+				__m256 acc = _mm256_setzero_ps();
+				for (int i = 0; i < 4; ++i)
+				{
+					__m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(wa[i])), _mm_set1_ps(wb[i]), 1);
+					__m256 r = LoadPair(PaletteRow(palette, a.BoneIndices[i], row), PaletteRow(palette, b.BoneIndices[i], row));
+					acc = _mm256_add_ps(acc, _mm256_mul_ps(w, r));
+				}
+				m[row][k] = acc;
+			}
+		}
+		for (int row = 0; row < 3; ++row)
+			Transpose(m[row][0], m[row][1], m[row][2], m[row][3]);
+
+		// XMFLOAT3 뒤에 다른 멤버가 있으므로 네 번째 float까지 읽어도 정점 밖으로 나가지 않는다.
+		auto Gather = [&v](const XMFLOAT3 SkinnedVertex::* member, __m256 p[4]) {
+			for (int k = 0; k < 4; ++k)
+				p[k] = LoadPair(&(v[k]->*member).x, &(v[k + 4]->*member).x);
+			Transpose(p[0], p[1], p[2], p[3]); };
+		auto Transform = [&m](const __m256 p[4], int row, bool point) {
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(m[row][0], p[0]), _mm256_mul_ps(m[row][1], p[1])),
+				_mm256_mul_ps(m[row][2], p[2]));
+			return point ? _mm256_add_ps(r, m[row][3]) : r; };
+
+		using Group = SkinnedVertexSoa::Group;
+		__m256 p[4];
+		Gather(&SkinnedVertex::Pos, p);
+		StorePair(lo, hi, &Group::PosX, Transform(p, 0, true));
+		StorePair(lo, hi, &Group::PosY, Transform(p, 1, true));
+		StorePair(lo, hi, &Group::PosZ, Transform(p, 2, true));
+
+		Gather(&SkinnedVertex::Normal, p);
+		StorePair(lo, hi, &Group::NormalX, Transform(p, 0, false));
+		StorePair(lo, hi, &Group::NormalY, Transform(p, 1, false));
+		StorePair(lo, hi, &Group::NormalZ, Transform(p, 2, false));
+
+		Gather(&SkinnedVertex::TangentU, p);
+		StorePair(lo, hi, &Group::TangentX, Transform(p, 0, false));
+		StorePair(lo, hi, &Group::TangentY, Transform(p, 1, false));
+		StorePair(lo, hi, &Group::TangentZ, Transform(p, 2, false));
+	}
+#endif
+
+	// [0, count)를 묶음 단위로 스키닝하고 output(첫 정점, 묶음, 묶음 안 정점 수)으로 넘긴다.
+	template<typename Output>
+	void SkinRange(const SkinnedVertex* vertices, UINT count, const XMFLOAT4X4* palette, Output&& output)
+	{
+		UINT i = 0;
+#if defined(__AVX2__)
+		for (; i + 8 <= count; i += 8)
+		{
+			const SkinnedVertex* v[8];
+			for (int lane = 0; lane < 8; ++lane)
+				v[lane] = &vertices[i + lane];
+
+			SkinnedVertexSoa::Group lo, hi;
+			SkinGroupPair(v, palette, lo, hi);
+			output(i, lo, 4);
+			output(i + 4, hi, 4);
+		}
+#endif
+		for (; i < count; i += 4)
+		{
+			const UINT n = std::min<UINT>(4, count - i);
+			const SkinnedVertex* v[4];
+			for (UINT lane = 0; lane < 4; ++lane)
+				v[lane] = &vertices[i + std::min<UINT>(lane, n - 1)];
+
+			SkinnedVertexSoa::Group group;
+			SkinGroup(v, palette, group);
+			output(i, group, n);
+		}
+	}
+
+	// 묶음을 다시 전치해서 정점 n개의 Pos, Normal, TangentU에 쓴다.
+	void StoreGroup(const SkinnedVertexSoa::Group& group, UINT n, const SkinnedVertex* src, SkinnedVertex* dst)
+	{
+		auto Scatter = [&](const XMFLOAT4A& x, const XMFLOAT4A& y, const XMFLOAT4A& z, XMFLOAT3 SkinnedVertex::* member) {
+			XMMATRIX t = XMMatrixTranspose(XMMATRIX(XMLoadFloat4A(&x), XMLoadFloat4A(&y), XMLoadFloat4A(&z), XMVectorZero()));
+			for (UINT lane = 0; lane < n; ++lane)
+				XMStoreFloat3(&(dst[lane].*member), t.r[lane]);
+		};
+
+		if (src != dst)
+			std::copy(src, src + n, dst);
+		Scatter(group.PosX, group.PosY, group.PosZ, &SkinnedVertex::Pos);
+		Scatter(group.NormalX, group.NormalY, group.NormalZ, &SkinnedVertex::Normal);
+		Scatter(group.TangentX, group.TangentY, group.TangentZ, &SkinnedVertex::TangentU);
+	}
+}
+
+void SkinnedVertexSoa::Resize(UINT vertexCount)
+{
+	VertexCount = vertexCount;
+	Groups.resize((vertexCount + 3) / 4);
+}
+
+XMFLOAT3 SkinnedVertexSoa::Position(UINT vertex) const
+{
+	const Group& group = Groups[vertex / 4];
+	const UINT lane = vertex % 4;
+	return XMFLOAT3((&group.PosX.x)[lane], (&group.PosY.x)[lane], (&group.PosZ.x)[lane]);
+}
+
+void SkinVertices(const SkinnedVertex* vertices, UINT count, const XMFLOAT4X4* finalTransforms, SkinnedVertex* out)
+{
+	SkinRange(vertices, count, finalTransforms, [&](UINT first, const SkinnedVertexSoa::Group& group, UINT n) {
+		StoreGroup(group, n, &vertices[first], &out[first]); });
+}
+
+void SkinVertices(const SkinnedVertex* vertices, UINT count, const XMFLOAT4X4* finalTransforms, SkinnedVertexSoa::Group* out)
+{
+	SkinRange(vertices, count, finalTransforms, [&](UINT first, const SkinnedVertexSoa::Group& group, UINT) {
+		out[first / 4] = group; });
+}
+
+void ParallelSkinVertices(TaskScheduler& scheduler, const std::vector<SkinnedVertex>& vertices,
+	const XMFLOAT4X4* finalTransforms, std::vector<SkinnedVertex>& out)
+{
+	const UINT count = static_cast<UINT>(vertices.size());
+	out.resize(count);
+
+	const int tasks = static_cast<int>((count + VerticesPerTask - 1) / VerticesPerTask);
+	ParallelFor(scheduler, 0, tasks, [&](int task) {
+		UINT first = task * VerticesPerTask;
+		SkinVertices(&vertices[first], std::min<UINT>(VerticesPerTask, count - first), finalTransforms, &out[first]);
+	}, 1);
+}
+
+void ParallelSkinVertices(TaskScheduler& scheduler, const std::vector<SkinnedVertex>& vertices,
+	const XMFLOAT4X4* finalTransforms, SkinnedVertexSoa& out)
+{
+	const UINT count = static_cast<UINT>(vertices.size());
+	out.Resize(count);
+
+	const int tasks = static_cast<int>((count + VerticesPerTask - 1) / VerticesPerTask);
+	ParallelFor(scheduler, 0, tasks, [&](int task) {
+		UINT first = task * VerticesPerTask;
+		SkinVertices(&vertices[first], std::min<UINT>(VerticesPerTask, count - first), finalTransforms, &out.Groups[first / 4]);
+	}, 1);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "LoadM3d.h"
+
+class TaskScheduler;
+
+// CPU에서 스키닝한 정점을 네 개씩 묶어 성분별로 담는다.
+// 마지막 묶음의 남는 레인에는 마지막 정점을 한 번 더 담는다.
+struct SkinnedVertexSoa
+{
+	struct Group
+	{
+		DirectX::XMFLOAT4A PosX, PosY, PosZ;
+		DirectX::XMFLOAT4A NormalX, NormalY, NormalZ;
+		DirectX::XMFLOAT4A TangentX, TangentY, TangentZ;
+	};
+
+	UINT VertexCount = 0;
+	std::vector<Group> Groups;
+
+	void Resize(UINT vertexCount);
+	DirectX::XMFLOAT3 Position(UINT vertex) const;
+};
+
+// 셰이더와 같은 선형 블렌드 스키닝. 네 번째 가중치는 1 - x - y - z이고, 법선과 접선은 셰이더처럼 정규화하지 않는다.
+// finalTransforms는 GetFinalTransforms의 결과(셰이더로 보내기 위해 전치된 상태)를 그대로 받는다.
+// 네 정점씩(AVX2로 빌드하면 여덟 정점씩) 뼈 행렬을 섞은 뒤 전치해서 위치, 법선, 접선을 성분별로 한꺼번에 변환한다.
+
+// 원래 배치로 낸다. Pos, Normal, TangentU만 스키닝한 값이고 나머지는 vertices에서 복사한다.
+void SkinVertices(const M3DLoader::SkinnedVertex* vertices, UINT count,
+	const DirectX::XMFLOAT4X4* finalTransforms, M3DLoader::SkinnedVertex* out);
+// SoA로 낸다. out은 (count + 3) / 4개의 묶음이다.
+void SkinVertices(const M3DLoader::SkinnedVertex* vertices, UINT count,
+	const DirectX::XMFLOAT4X4* finalTransforms, SkinnedVertexSoa::Group* out);
+
+// 정점 범위를 나눠 작업자 스레드에서 스키닝한다. out은 vertices 크기에 맞춘다.
+void ParallelSkinVertices(TaskScheduler& scheduler, const std::vector<M3DLoader::SkinnedVertex>& vertices,
+	const DirectX::XMFLOAT4X4* finalTransforms, std::vector<M3DLoader::SkinnedVertex>& out);
+void ParallelSkinVertices(TaskScheduler& scheduler, const std::vector<M3DLoader::SkinnedVertex>& vertices,
+	const DirectX::XMFLOAT4X4* finalTransforms, SkinnedVertexSoa& out);
@@ -0,0 +1,250 @@
+#include "SkinnedCrowd.h"
+#include "../Common/Util.h"
+#include "../Common/TaskScheduler.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+SkinnedCrowd::SkinnedCrowd(const SkinnedData* skinnedInfo)
+	: mSkinnedInfo(skinnedInfo)
+{}
+
+int SkinnedCrowd::Add(SkinnedData::ClipHandle clip, float timePos, float speed, const XMFLOAT3& position)
+{
+	mInstances.emplace_back();
+	mInstances.back().Speed = speed;
+	mInstances.back().Position = position;
+
+	const size_t numBones = mSkinnedInfo->BoneCount();
+	mKeyCursors.resize(mInstances.size() * mSkinnedInfo->KeyCursorCount(), -1);
+	mOwnPalettes.resize(mInstances.size() * numBones);
+	mNextPalettes.resize(mInstances.size() * numBones);
+
+	int instance = static_cast<int>(mInstances.size()) - 1;
+	SetClip(instance, clip, timePos);
+	return instance;
+}
+
+void SkinnedCrowd::SetClip(int instance, SkinnedData::ClipHandle clip, float timePos)
+{
+	Instance& inst = mInstances[instance];
+	inst.Clip = clip;
+	inst.ClipEndTime = clip->GetClipEndTime();
+	inst.TimePos = timePos;
+	inst.Interval = 0;	// 보간하던 팔레트는 지난 클립의 것이다.
+
+	const UINT cursorCount = mSkinnedInfo->KeyCursorCount();
+	std::fill_n(mKeyCursors.begin() + static_cast<size_t>(instance) * cursorCount, cursorCount, -1);
+}
+
+void SkinnedCrowd::Clear()
+{
+	mInstances.clear();
+	mKeyCursors.clear();
+	mOwnPalettes.clear();
+	mNextPalettes.clear();
+	mPoseCount = 0;
+	mUpdatedCount = 0;
+}
+
+void SkinnedCrowd::SetView(const XMFLOAT3& eye, const BoundingFrustum* frustum, float boundingRadius)
+{
+	mEye = eye;
+	mCullOffscreen = frustum != nullptr;
+	if (frustum != nullptr)
+		mFrustum = *frustum;
+	mBoundingRadius = boundingRadius;
+}
+
+float SkinnedCrowd::Schedule(int instance, float dt)
+{
+	Instance& inst = mInstances[instance];
+
+	int lod = -1;
+	int interval = 1;
+	if (!mLodLevels.empty())
+	{
+		float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&inst.Position) - XMLoadFloat3(&mEye)));
+		lod = 0;
+		while (lod + 1 < static_cast<int>(mLodLevels.size()) && distance > mLodLevels[lod].MaxDistance)
+			++lod;
+		interval = std::max<int>(mLodLevels[lod].UpdateInterval, 1);
+	}
+
+	BoundingSphere bounds(inst.Position, mBoundingRadius);
+	const bool visible = !mCullOffscreen || mFrustum.Intersects(bounds);
+	const bool ownPalette = !visible || interval > 1;
+	float timePos = inst.TimePos;
+
+	inst.LookAhead = false;
+	if (!visible)
+	{
+		// 화면 밖으로 나가는 프레임에만 지금 포즈를 남겨 두고 그 뒤로는 시간만 간다.
+		inst.Due = inst.Snap = !inst.OwnPalette;
+	}
+	else if (!ownPalette)
+	{
+		inst.Due = true;
+		inst.Snap = false;
+	}
+	else
+	{
+		// 캐릭터마다 갱신하는 프레임을 번호만큼 어긋나게 둔다.
+		// 팔레트를 처음 갖게 되었거나 화면에 다시 들어왔거나 간격이 바뀐 프레임은 지금 포즈로 바로 맞추고,
+		// 그대로 멈춰 있지 않도록 다음 갱신 프레임(phase가 0인 프레임)에 닿을 포즈도 같이 구한다.
+		const int phase = static_cast<int>((mFrame + instance) % interval);
+		inst.Snap = !inst.OwnPalette || !inst.Visible || inst.Interval != interval;
+		inst.LookAhead = inst.Snap || phase == 0;
+		inst.Due = inst.LookAhead;
+		inst.Remaining = interval - phase + 1;
+		if (inst.LookAhead)
+		{
+			const int ahead = phase == 0 ? interval : interval - phase;
+			timePos += ahead * dt * inst.Speed;
+			if (timePos > inst.ClipEndTime)
+				timePos = inst.ClipEndTime > 0.0f ? fmodf(timePos, inst.ClipEndTime) : 0.0f;
+		}
+	}
+
+	inst.Lod = lod;
+	inst.Visible = visible;
+	inst.OwnPalette = ownPalette;
+	inst.Interval = visible ? interval : 0;
+	return timePos;
+}
+
+void SkinnedCrowd::Update(float dt)
+{
+	++mFrame;
+	const int count = static_cast<int>(mInstances.size());
+	const UINT numBones = mSkinnedInfo->BoneCount();
+
+	// 시간을 보내고, 이번 프레임에 포즈를 구할 캐릭터를 (클립, 맞춘 시간, 건너뛸 끝 뼈 단계)로 정렬해 같은 포즈끼리 모은다.
+	mPoseKeys.clear();
+	mUpdatedCount = 0;
+	for (auto i : Range(0, count))
+	{
+		Instance& inst = mInstances[i];
+		inst.TimePos += dt * inst.Speed;
+		if (inst.TimePos > inst.ClipEndTime)
+			inst.TimePos = inst.ClipEndTime > 0.0f ? fmodf(inst.TimePos, inst.ClipEndTime) : 0.0f;
+
+		float timePos = Schedule(i, dt);
+		if (!inst.Due)
+			continue;
+
+		++mUpdatedCount;
+		UINT skipLeafLevels = inst.Lod >= 0 ? mLodLevels[inst.Lod].SkipLeafLevels : 0;
+		auto addKey = [&](float t, bool snap) {
+			// 시간을 맞추지 않으면 캐릭터의 두 포즈(지금, 다음 목표)가 섞이지 않게 따로 번호를 준다.
+			std::int64_t time = mTimeStep > 0.0f ?
+				static_cast<std::int64_t>(floorf(t / mTimeStep)) : static_cast<std::int64_t>(i) * 2 + (snap ? 1 : 0);
+			mPoseKeys.push_back({ inst.Clip, time, skipLeafLevels, i, t, snap }); };
+
+		if (inst.Snap)
+			addKey(inst.TimePos, true);
+		if (inst.LookAhead || !inst.Snap)
+			addKey(timePos, false);
+	}
+	std::sort(mPoseKeys.begin(), mPoseKeys.end());
+
+	// 같은 포즈의 첫 캐릭터가 대표로 요청을 만든다. 키 커서도 대표의 것을 쓰므로 작업끼리 겹치지 않는다.
+	// 한 캐릭터가 두 포즈를 구하는 프레임에는 Snap 포즈가 커서 없이 이진 탐색한다.
+	mRequests.clear();
+	for (auto k : Range(0, static_cast<int>(mPoseKeys.size())))
+	{
+		const PoseKey& key = mPoseKeys[k];
+		Instance& inst = mInstances[key.Instance];
+		if (k == 0 || key.Clip != mPoseKeys[k - 1].Clip || key.Time != mPoseKeys[k - 1].Time ||
+			key.SkipLeafLevels != mPoseKeys[k - 1].SkipLeafLevels)
+		{
+			SkinnedData::PoseRequest request;
+			request.Clip = inst.Clip;
+			request.TimePos = mTimeStep > 0.0f ? std::min<float>(key.Time * mTimeStep, inst.ClipEndTime) : key.TimePos;
+			request.KeyCursors = key.Snap && inst.LookAhead ? nullptr :
+				&mKeyCursors[static_cast<size_t>(key.Instance) * mSkinnedInfo->KeyCursorCount()];
+			request.SkipLeafLevels = key.SkipLeafLevels;
+			mRequests.push_back(request);
+		}
+		(key.Snap ? inst.SnapPose : inst.Pose) = static_cast<int>(mRequests.size()) - 1;
+	}
+
+	mPoseCount = static_cast<UINT>(mRequests.size());
+	if (mPalettes.size() < static_cast<size_t>(mPoseCount) * numBones)
+		mPalettes.resize(static_cast<size_t>(mPoseCount) * numBones);
+	for (auto p : Range(0, static_cast<int>(mPoseCount)))
+		mRequests[p].FinalTransforms = &mPalettes[static_cast<size_t>(p) * numBones];
+
+	// 덩어리 하나를 작업 하나가 맡고 덩어리마다 작업 공간을 따로 쓴다.
+	const int tasks = (static_cast<int>(mPoseCount) + PosesPerTask - 1) / PosesPerTask;
+	if (mScratches.size() < static_cast<size_t>(tasks))
+		mScratches.resize(tasks);
+
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+	ParallelFor(scheduler, 0, tasks, [this](int task) {
+		int first = task * PosesPerTask;
+		int last = std::min<int>(first + PosesPerTask, static_cast<int>(mPoseCount));
+		mSkinnedInfo->GetFinalTransforms(&mRequests[first], static_cast<UINT>(last - first), mScratches[task]);
+	}, 1);
+
+	if (mLodLevels.empty() && !mCullOffscreen)
+		return;
+	ParallelFor(scheduler, 0, count, [this](int instance) { UpdateOwnPalette(instance); }, InstancesPerTask);
+}
+
+void SkinnedCrowd::UpdateOwnPalette(int instance)
+{
+	const Instance& inst = mInstances[instance];
+	if (!inst.OwnPalette || (!inst.Due && !inst.Visible))
+		return;
+
+	const size_t numBones = mSkinnedInfo->BoneCount();
+	XMFLOAT4X4* own = &mOwnPalettes[instance * numBones];
+	Matrix3x4* next = &mNextPalettes[instance * numBones];
+
+	if (inst.Due)
+	{
+		// Snap이면 지금 포즈로 맞추고, 아니면 지난번에 구한 포즈에 닿았으므로 그것을 내보낸다.
+		// 그리고 새로 구한 포즈를 다음 목표로 둔다.
+		const XMFLOAT4X4* snapPose = &mPalettes[static_cast<size_t>(inst.SnapPose) * numBones];
+		const XMFLOAT4X4* pose = &mPalettes[static_cast<size_t>(inst.Pose) * numBones];
+		for (size_t b = 0; b < numBones; ++b)
+		{
+			for (int r = 0; r < 3; ++r)
+			{
+				XMFLOAT4* ownRow = reinterpret_cast<XMFLOAT4*>(own[b].m[r]);
+				if (inst.Snap)
+					XMStoreFloat4(ownRow, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(snapPose[b].m[r])));
+				else
+					XMStoreFloat4(ownRow, XMLoadFloat4A(&next[b].Rows[r]));
+				if (inst.LookAhead)
+					XMStoreFloat4A(&next[b].Rows[r], XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pose[b].m[r])));
+			}
+			if (inst.Snap)
+				XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(own[b].m[3]), XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+		return;
+	}
+
+	// 남은 프레임 수로 나눠 조금씩 다가가면 갱신 사이를 선형으로 보간한 것과 같다.
+	const XMVECTOR u = XMVectorReplicate(1.0f / inst.Remaining);
+	for (size_t b = 0; b < numBones; ++b)
+	{
+		for (int r = 0; r < 3; ++r)
+		{
+			XMFLOAT4* ownRow = reinterpret_cast<XMFLOAT4*>(own[b].m[r]);
+			XMVECTOR v = XMLoadFloat4(ownRow);
+			XMStoreFloat4(ownRow, XMVectorMultiplyAdd(u, XMLoadFloat4A(&next[b].Rows[r]) - v, v));
+		}
+	}
+}
+
+const XMFLOAT4X4* SkinnedCrowd::FinalTransforms(int instance) const
+{
+	const Instance& inst = mInstances[instance];
+	const size_t numBones = mSkinnedInfo->BoneCount();
+	if (inst.OwnPalette)
+		return &mOwnPalettes[instance * numBones];
+	return &mPalettes[static_cast<size_t>(inst.Pose) * numBones];
+}
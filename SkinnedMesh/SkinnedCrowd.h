@@ -0,0 +1,136 @@
+#pragma once
+
+#include "SkinnedData.h"
+#include <cfloat>
+#include <cstdint>
+
+class TaskScheduler;
+
+// 같은 SkinnedData(골격)를 쓰는 캐릭터 무리. 캐릭터마다 클립, 시간, 재생 속도가 따로 있고
+// Update가 포즈 계산을 작업자 스레드에 나눠 맡긴다.
+// 같은 클립에서 시간을 TimeStep 단위로 맞췄을 때 같은 캐릭터끼리는 포즈를 한 번만 계산하고 팔레트를 같이 쓴다.
+// LOD 단계를 주면 카메라에서 먼 캐릭터는 포즈를 드물게 구하고 화면 밖 캐릭터는 포즈를 멈춘다.
+class SkinnedCrowd
+{
+public:
+	// 카메라에서 MaxDistance까지 쓰는 단계. UpdateInterval 프레임마다 그만큼 뒤의 포즈를 구해 두고
+	// 그 사이 프레임에는 팔레트를 그 포즈 쪽으로 선형 보간한다. 캐릭터마다 갱신하는 프레임을 어긋나게 둬서
+	// 프레임마다 포즈를 구하는 캐릭터 수가 고르다.
+	// 끝 뼈(손가락, 발가락 같은) SkipLeafLevels 단계는 부모에 붙은 바인드 포즈로 둔다.
+	struct LodLevel
+	{
+		float MaxDistance = FLT_MAX;
+		int UpdateInterval = 1;
+		UINT SkipLeafLevels = 0;
+	};
+
+public:
+	explicit SkinnedCrowd(const SkinnedData* skinnedInfo);
+	SkinnedCrowd(const SkinnedCrowd& rhs) = delete;
+	SkinnedCrowd& operator=(const SkinnedCrowd& rhs) = delete;
+
+	// 캐릭터를 넣고 번호를 돌려준다. position은 거리와 화면 안인지를 잴 월드 위치다.
+	int Add(SkinnedData::ClipHandle clip, float timePos, float speed = 1.0f,
+		const DirectX::XMFLOAT3& position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
+	void SetClip(int instance, SkinnedData::ClipHandle clip, float timePos);
+	void SetPosition(int instance, const DirectX::XMFLOAT3& position) { mInstances[instance].Position = position; }
+	void Clear();
+
+	UINT Count() const { return static_cast<UINT>(mInstances.size()); }
+
+	// 포즈를 같이 쓸 시간 간격(초). 0이면 캐릭터마다 제 시간으로 따로 계산한다.
+	void SetTimeStep(float timeStep) { mTimeStep = timeStep; }
+	// 작업을 나눌 스레드 풀. nullptr이면 TaskScheduler::Default()를 쓴다.
+	void SetScheduler(TaskScheduler* scheduler) { mScheduler = scheduler; }
+
+	// MaxDistance가 커지는 순서로 준다. 마지막 단계보다 먼 캐릭터도 마지막 단계를 쓴다. 비우면 LOD를 쓰지 않는다.
+	void SetLodLevels(const std::vector<LodLevel>& levels) { mLodLevels = levels; }
+	// 거리를 잴 카메라 위치와 화면 밖을 가릴 월드 공간 절두체. frustum이 nullptr이면 가리지 않는다.
+	// 캐릭터는 위치를 중심으로 반지름이 boundingRadius인 구로 본다.
+	void SetView(const DirectX::XMFLOAT3& eye, const DirectX::BoundingFrustum* frustum, float boundingRadius);
+
+	// 시간을 dt만큼 보내고(클립 끝에서 처음으로 돈다) 모든 캐릭터의 팔레트를 구한다.
+	void Update(float dt);
+
+	// 캐릭터의 최종 변환 BoneCount()개. GetFinalTransforms처럼 셰이더로 보낼 수 있게 전치되어 있다.
+	// 다음 Update 전까지 유효하다.
+	const DirectX::XMFLOAT4X4* FinalTransforms(int instance) const;
+	// 지난 Update에서 실제로 계산한 포즈 수
+	UINT EvaluatedPoseCount() const { return mPoseCount; }
+	// 지난 Update에서 포즈를 구한 캐릭터 수. 나머지는 보간했거나 화면 밖이라 멈춰 있다.
+	UINT UpdatedInstanceCount() const { return mUpdatedCount; }
+
+private:
+	struct Instance
+	{
+		SkinnedData::ClipHandle Clip = nullptr;
+		float ClipEndTime = 0.0f;
+		float TimePos = 0.0f;
+		float Speed = 1.0f;
+		DirectX::XMFLOAT3 Position{};
+		int Pose = 0;				// mPalettes에서 쓸 포즈
+		int Lod = -1;				// 지금 쓰는 LOD 단계
+		bool Visible = true;
+		// mPalettes를 바로 읽지 않고 캐릭터 몫의 팔레트(mOwnPalettes)에 보간해 둔다.
+		bool OwnPalette = false;
+		bool Due = false;			// 이번 프레임에 포즈를 구한다.
+		bool Snap = false;			// 지금 시간의 포즈(SnapPose)를 구해 팔레트를 바로 맞춘다.
+		bool LookAhead = false;		// 다음 갱신 프레임에 닿을 포즈(Pose)를 구해 다음 목표로 둔다.
+		int SnapPose = 0;			// mPalettes에서 Snap일 때 쓸 지금 시간의 포즈
+		int Interval = 0;			// 지난 프레임의 갱신 간격. 0이면 다음 프레임에 팔레트를 새로 맞춘다.
+		int Remaining = 1;			// 다음 포즈에 닿기까지 남은 프레임
+	};
+
+	// 같은 포즈를 찾으려고 (클립, 맞춘 시간, 건너뛸 끝 뼈 단계)로 정렬한다.
+	struct PoseKey
+	{
+		SkinnedData::ClipHandle Clip;
+		std::int64_t Time;
+		UINT SkipLeafLevels;
+		int Instance;
+		float TimePos;
+		bool Snap;					// 캐릭터의 SnapPose로 쓴다.
+
+		bool operator<(const PoseKey& rhs) const
+		{
+			if (Clip != rhs.Clip) return Clip < rhs.Clip;
+			if (Time != rhs.Time) return Time < rhs.Time;
+			if (SkipLeafLevels != rhs.SkipLeafLevels) return SkipLeafLevels < rhs.SkipLeafLevels;
+			if (Instance != rhs.Instance) return Instance < rhs.Instance;
+			return Snap < rhs.Snap;
+		}
+	};
+
+	// 작업 하나가 맡는 포즈 수. 덩어리마다 작업 공간을 하나씩 둔다.
+	static constexpr int PosesPerTask = 16;
+	// 팔레트를 보간하는 작업 하나가 맡는 캐릭터 수
+	static constexpr int InstancesPerTask = 64;
+
+	// LOD 단계와 이번 프레임에 포즈를 구할지 정하고, Pose로 구할 시간을 돌려준다.
+	// Snap이면 이와 따로 지금 시간(TimePos)의 포즈도 구한다.
+	float Schedule(int instance, float dt);
+	void UpdateOwnPalette(int instance);
+
+	const SkinnedData* mSkinnedInfo = nullptr;
+	TaskScheduler* mScheduler = nullptr;
+	float mTimeStep = 1.0f / 120.0f;
+	UINT mPoseCount = 0;
+	UINT mUpdatedCount = 0;
+	std::uint64_t mFrame = 0;
+
+	std::vector<LodLevel> mLodLevels;
+	DirectX::XMFLOAT3 mEye{};
+	DirectX::BoundingFrustum mFrustum{};
+	bool mCullOffscreen = false;
+	float mBoundingRadius = 1.0f;
+
+	std::vector<Instance> mInstances;
+	std::vector<int> mKeyCursors;		// 캐릭터마다 KeyCursorCount()개
+	std::vector<PoseKey> mPoseKeys;
+	std::vector<SkinnedData::PoseRequest> mRequests;
+	std::vector<DirectX::XMFLOAT4X4> mPalettes;
+	std::vector<SkinnedData::Scratch> mScratches;
+	// 캐릭터마다 BoneCount()개. 보간해서 내보내는 팔레트와 다음에 닿을 팔레트
+	std::vector<DirectX::XMFLOAT4X4> mOwnPalettes;
+	std::vector<Matrix3x4> mNextPalettes;
+};
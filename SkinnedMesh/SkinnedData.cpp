@@ -1,8 +1,38 @@
 #include "SkinnedData.h"
 #include "../Common/Util.h"
+#include <algorithm>
+#include <cassert>
 
 using namespace DirectX;
 
+namespace
+{
+	void LoadRows(const Matrix3x4& m, XMVECTOR rows[3])
+	{
+		rows[0] = XMLoadFloat4A(&m.Rows[0]);
+		rows[1] = XMLoadFloat4A(&m.Rows[1]);
+		rows[2] = XMLoadFloat4A(&m.Rows[2]);
+	}
+
+	// 전치한 아핀 행렬끼리의 곱. 원래 행렬로는 out = a * b이고 out^T = b^T * a^T이다.
+	// a^T의 네 번째 행은 (0, 0, 0, 1)이라 b^T 행의 w는 결과의 w에 그대로 더해진다. out은 a나 b와 같아도 된다.
+	void Concatenate(const XMVECTOR a[3], const XMVECTOR b[3], XMVECTOR out[3])
+	{
+		const XMVECTOR maskW = XMVectorSelectControl(0, 0, 0, 1);
+		XMVECTOR rows[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			XMVECTOR row = XMVectorSelect(XMVectorZero(), b[i], maskW);
+			row = XMVectorMultiplyAdd(XMVectorSplatX(b[i]), a[0], row);
+			row = XMVectorMultiplyAdd(XMVectorSplatY(b[i]), a[1], row);
+			rows[i] = XMVectorMultiplyAdd(XMVectorSplatZ(b[i]), a[2], row);
+		}
+		out[0] = rows[0];
+		out[1] = rows[1];
+		out[2] = rows[2];
+	}
+}
+
 Keyframe::Keyframe()
 	: TimePos(0.0f),
 	Translation(0.0f, 0.0f, 0.0f),
@@ -25,48 +55,47 @@ float BoneAnimation::GetEndTime() const
 
 void BoneAnimation::Interpolate(float t, XMFLOAT4X4& M) const
 {
-	auto AffineTransformation = [](const Keyframe& keyframe) {
-		XMVECTOR S = XMLoadFloat3(&keyframe.Scale);
-		XMVECTOR P = XMLoadFloat3(&keyframe.Translation);
-		XMVECTOR Q = XMLoadFloat4(&keyframe.RotationQuat);
-		XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-		return XMMatrixAffineTransformation(S, zero, Q, P); };
-
-	if (t <= Keyframes.front().TimePos)
-		XMStoreFloat4x4(&M, AffineTransformation(Keyframes.front()));
-	else if (t >= Keyframes.back().TimePos)
-		XMStoreFloat4x4(&M, AffineTransformation(Keyframes.back()));
-	else
-	{
-		for (auto i : Range(0, (int)Keyframes.size() - 1))
-		{
-			if (Keyframes[i].TimePos > t) continue;
-			if (Keyframes[i + 1].TimePos < t) continue;
-
-			float lerpPercent = (t - Keyframes[i].TimePos) / (Keyframes[i + 1].TimePos - Keyframes[i].TimePos);
-
-			XMVECTOR s0 = XMLoadFloat3(&Keyframes[i].Scale);
-			XMVECTOR s1 = XMLoadFloat3(&Keyframes[i + 1].Scale);
-
-			XMVECTOR p0 = XMLoadFloat3(&Keyframes[i].Translation);
-			XMVECTOR p1 = XMLoadFloat3(&Keyframes[i + 1].Translation);
-
-			XMVECTOR q0 = XMLoadFloat4(&Keyframes[i].RotationQuat);
-			XMVECTOR q1 = XMLoadFloat4(&Keyframes[i + 1].RotationQuat);
+	XMVECTOR T, Q, S;
+	Sample(t, T, Q, S);
+	XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, T));
+}
 
-			XMVECTOR S = XMVectorLerp(s0, s1, lerpPercent);
-			XMVECTOR P = XMVectorLerp(p0, p1, lerpPercent);
-			XMVECTOR Q = XMQuaternionSlerp(q0, q1, lerpPercent);
-			XMVECTOR zero = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
-			XMStoreFloat4x4(&M, XMMatrixAffineTransformation(S, zero, Q, P));
+void BoneAnimation::Sample(float t, XMVECTOR& T, XMVECTOR& Q, XMVECTOR& S) const
+{
+	if (Keyframes.empty())
+	{
+		T = XMVectorZero();
+		Q = XMQuaternionIdentity();
+		S = XMVectorSplatOne();
+		return;
+	}
 
-			break;
-		}
+	const Keyframe* k0 = &Keyframes.front();
+	const Keyframe* k1 = k0;
+	float lerpPercent = 0.0f;
+	if (t >= Keyframes.back().TimePos)
+		k0 = k1 = &Keyframes.back();
+	else if (t > Keyframes.front().TimePos)
+	{
+		// t보다 큰 첫 키의 앞 키가 구간의 시작이다. 키 시간이 Keyframe 사이에 흩어져 있어 FindKeySegment를 쓰지 않는다.
+		auto upper = std::upper_bound(Keyframes.begin(), Keyframes.end(), t,
+			[](float time, const Keyframe& keyframe) { return time < keyframe.TimePos; });
+		k1 = &*upper;
+		k0 = k1 - 1;
+		lerpPercent = (t - k0->TimePos) / (k1->TimePos - k0->TimePos);
 	}
+
+	T = XMVectorLerp(XMLoadFloat3(&k0->Translation), XMLoadFloat3(&k1->Translation), lerpPercent);
+	S = XMVectorLerp(XMLoadFloat3(&k0->Scale), XMLoadFloat3(&k1->Scale), lerpPercent);
+	Q = XMQuaternionSlerp(XMLoadFloat4(&k0->RotationQuat), XMLoadFloat4(&k1->RotationQuat), lerpPercent);
 }
 
 float AnimationClip::GetClipStartTime() const
 {
+	if (!Compressed.Empty())
+		return Compressed.StartTime;
+
 	float t = MathHelper::Infinity;
 	for (UINT i = 0; i < BoneAnimations.size(); ++i)
 	{
@@ -78,6 +107,9 @@ float AnimationClip::GetClipStartTime() const
 
 float AnimationClip::GetClipEndTime() const
 {
+	if (!Compressed.Empty())
+		return Compressed.StartTime + Compressed.Duration;
+
 	float t = 0.0f;
 	for (UINT i = 0; i < BoneAnimations.size(); ++i)
 	{
@@ -87,12 +119,22 @@ float AnimationClip::GetClipEndTime() const
 	return t;
 }
 
-void AnimationClip::Interpolate(float t, std::vector<XMFLOAT4X4>& boneTransforms) const
+void AnimationClip::SamplePoses(float t, int* cursors, SoaTransform* poses) const
 {
-	for (UINT i = 0; i < BoneAnimations.size(); ++i)
-	{
-		BoneAnimations[i].Interpolate(t, boneTransforms[i]);
-	}
+	if (!Compressed.Empty())
+		Compressed.Sample(t, cursors, poses);
+	else
+		Soa.Sample(t, cursors, poses);
+}
+
+void SkinnedData::Scratch::Reserve(UINT boneCount)
+{
+	if (ToParent.size() < boneCount) ToParent.resize(boneCount);
+	if (ToRoot.size() < boneCount) ToRoot.resize(boneCount);
+
+	size_t groupCount = (boneCount + SoaAnimationClip::Lanes - 1) / SoaAnimationClip::Lanes;
+	if (Poses.size() < groupCount) Poses.resize(groupCount);
+	if (LayerPoses.size() < groupCount) LayerPoses.resize(groupCount);
 }
 
 float SkinnedData::GetClipStartTime(const std::string& clipName) const
@@ -112,6 +154,12 @@ UINT SkinnedData::BoneCount() const
 	return static_cast<UINT>(mBoneHierarchy.size());
 }
 
+SkinnedData::ClipHandle SkinnedData::FindClip(const std::string& clipName) const
+{
+	auto clip = mAnimations.find(clipName);
+	return clip != mAnimations.end() ? &clip->second : nullptr;
+}
+
 void SkinnedData::Set(
 	std::vector<int>& boneHierarchy,
 	std::vector<XMFLOAT4X4>& boneOffsets,
@@ -120,36 +168,213 @@ void SkinnedData::Set(
 	mBoneHierarchy = boneHierarchy;
 	mBoneOffsets = boneOffsets;
 	mAnimations = animations;
+
+	// m3d의 뼈는 부모가 먼저 나오지만 그렇지 않은 계층도 부모 다음에 자식이 오도록 순서를 만든다.
+	const int numBones = static_cast<int>(mBoneHierarchy.size());
+	mBoneOrder.clear();
+	mBoneOrder.reserve(numBones);
+	std::vector<bool> placed(numBones, false);
+	while (static_cast<int>(mBoneOrder.size()) < numBones)
+	{
+		size_t before = mBoneOrder.size();
+		for (auto i : Range(0, numBones))
+		{
+			int parentIndex = mBoneHierarchy[i];
+			if (placed[i] || (parentIndex >= 0 && !placed[parentIndex]))
+				continue;
+			mBoneOrder.push_back(i);
+			placed[i] = true;
+		}
+		assert(mBoneOrder.size() > before && "bone hierarchy has a cycle");
+		if (mBoneOrder.size() == before)
+			break;
+	}
+
+	// 뼈의 높이(자식이 없는 뼈가 0, 부모는 자식보다 크다)가 큰 순서로 다시 놓는다. 그래도 부모가 먼저 오고,
+	// 끝 뼈 몇 단계를 건너뛸 때 앞부분만 돌면 된다. 루트는 건너뛰지 않도록 가장 높게 둔다.
+	std::vector<int> height(numBones, 0);
+	for (auto i = mBoneOrder.rbegin(); i != mBoneOrder.rend(); ++i)
+	{
+		int parentIndex = mBoneHierarchy[*i];
+		if (parentIndex >= 0)
+			height[parentIndex] = std::max<int>(height[parentIndex], height[*i] + 1);
+	}
+	const int maxHeight = height.empty() ? 0 : *std::max_element(height.begin(), height.end());
+	for (int bone : mBoneOrder)
+	{
+		if (mBoneHierarchy[bone] < 0)
+			height[bone] = maxHeight;
+	}
+	std::stable_sort(mBoneOrder.begin(), mBoneOrder.end(), [&height](int a, int b) { return height[a] > height[b]; });
+
+	mHeightEnds.assign(maxHeight + 1, 0);
+	for (auto h : Range(0, maxHeight + 1))
+		mHeightEnds[h] = static_cast<UINT>(std::count_if(height.begin(), height.end(), [h](int x) { return x >= h; }));
+
+	mOffsetRows.resize(mBoneOffsets.size());
+	for (size_t i = 0; i < mBoneOffsets.size(); ++i)
+	{
+		XMMATRIX offset = XMMatrixTranspose(XMLoadFloat4x4(&mBoneOffsets[i]));
+		XMStoreFloat4A(&mOffsetRows[i].Rows[0], offset.r[0]);
+		XMStoreFloat4A(&mOffsetRows[i].Rows[1], offset.r[1]);
+		XMStoreFloat4A(&mOffsetRows[i].Rows[2], offset.r[2]);
+	}
+
+	for (auto& animation : mAnimations)
+	{
+		AnimationClip& clip = animation.second;
+		clip.Soa.Build(clip.BoneAnimations.data(), static_cast<unsigned>(clip.BoneAnimations.size()));
+		clip.Baked.Clear();
+	}
+}
+
+void SkinnedData::SetClip(const std::string& clipName, const AnimationClip& clip)
+{
+	AnimationClip& target = mAnimations[clipName];
+	target = clip;
+	target.Soa.Build(target.BoneAnimations.data(), static_cast<unsigned>(target.BoneAnimations.size()));
+	target.Baked.Clear();
+}
+
+void SkinnedData::SetCompressedClip(const std::string& clipName, const CompressedAnimationClip& compressed)
+{
+	assert(compressed.BoneAnimations.size() == BoneCount() && "compressed clip is for another skeleton");
+
+	AnimationClip& target = mAnimations[clipName];
+	target.BoneAnimations.clear();
+	target.Soa = SoaAnimationClip{};
+	target.Compressed = compressed;
+	target.Baked.Clear();
+}
+
+void SkinnedData::SetBakedClip(const std::string& clipName, const BakedAnimationClip& baked)
+{
+	auto clip = mAnimations.find(clipName);
+	if (clip == mAnimations.end())
+		return;
+
+	assert((baked.Empty() || baked.BoneCount() == BoneCount()) && "baked clip is for another skeleton");
+	clip->second.Baked = baked;
 }
 
 void SkinnedData::GetFinalTransforms(
 	const std::string& clipName, float timePos, std::vector<XMFLOAT4X4>& finalTransforms) const
+{
+	Scratch scratch;
+	PoseRequest request;
+	request.Clip = FindClip(clipName);
+	request.TimePos = timePos;
+	request.FinalTransforms = finalTransforms.data();
+	GetFinalTransforms(&request, 1, scratch);
+}
+
+void SkinnedData::GetFinalTransforms(const PoseRequest* requests, UINT count, Scratch& scratch) const
 {
 	UINT numBones = static_cast<UINT>(mBoneOffsets.size());
+	scratch.Reserve(numBones);
 
-	std::vector<XMFLOAT4X4> toParentTransforms(numBones);
+	for (UINT c = 0; c < count; ++c)
+	{
+		const PoseRequest& request = requests[c];
+		if (!request.Clip->Baked.Empty())
+		{
+			request.Clip->Baked.Sample(request.TimePos, request.FinalTransforms);
+			continue;
+		}
 
-	auto clip = mAnimations.find(clipName);
-	clip->second.Interpolate(timePos, toParentTransforms);
+		request.Clip->SamplePoses(request.TimePos, request.KeyCursors, scratch.Poses.data());
+		SoaAnimationClip::BuildMatrices(scratch.Poses.data(), numBones, scratch.ToParent.data());
+		ConcatenateHierarchy(scratch.ToParent.data(), request.FinalTransforms, scratch, request.SkipLeafLevels);
+	}
+}
 
-	std::vector<XMFLOAT4X4> toRootTransforms(numBones);
-	toRootTransforms[0] = toParentTransforms[0];
+void SkinnedData::GetFinalTransforms(const BlendRequest* requests, UINT count, Scratch& scratch) const
+{
+	UINT numBones = static_cast<UINT>(mBoneOffsets.size());
+	unsigned groupCount = (numBones + SoaAnimationClip::Lanes - 1) / SoaAnimationClip::Lanes;
+	scratch.Reserve(numBones);
 
-	for (auto i : Range(1, numBones))
+	for (UINT c = 0; c < count; ++c)
 	{
-		XMMATRIX toParent = XMLoadFloat4x4(&toParentTransforms[i]);
-		int parentIndex = mBoneHierarchy[i];
-		XMMATRIX parentToRoot = XMLoadFloat4x4(&toRootTransforms[parentIndex]);
-		XMMATRIX toRoot = XMMatrixMultiply(toParent, parentToRoot);
+		const BlendRequest& request = requests[c];
+		const BlendLayer& base = request.Layers[0];
+		base.Clip->SamplePoses(base.TimePos, base.KeyCursors, scratch.Poses.data());
+
+		for (UINT l = 1; l < request.LayerCount; ++l)
+		{
+			const BlendLayer& layer = request.Layers[l];
+			if (layer.Weight <= 0.0f)
+				continue;
+
+			layer.Clip->SamplePoses(layer.TimePos, layer.KeyCursors, scratch.LayerPoses.data());
+			SoaAnimationClip::BlendPoses(scratch.LayerPoses.data(),
+				layer.Mask != nullptr ? layer.Mask->Weights.data() : nullptr, layer.Weight, groupCount, scratch.Poses.data());
+		}
+
+		SoaAnimationClip::BuildMatrices(scratch.Poses.data(), numBones, scratch.ToParent.data());
+		ConcatenateHierarchy(scratch.ToParent.data(), request.FinalTransforms, scratch);
+	}
+}
+
+SkinnedData::BoneMask SkinnedData::MakeBoneMask(int rootBone, float weight) const
+{
+	const UINT numBones = BoneCount();
+	BoneMask mask;
+	mask.Weights.assign((numBones + SoaAnimationClip::Lanes - 1) / SoaAnimationClip::Lanes, XMFLOAT4A(0.0f, 0.0f, 0.0f, 0.0f));
+
+	// 부모가 먼저 오는 순서로 돌면 부모가 마스크에 들었는지 이미 알고 있다.
+	std::vector<bool> inMask(numBones, false);
+	for (int bone : mBoneOrder)
+	{
+		int parentIndex = mBoneHierarchy[bone];
+		inMask[bone] = bone == rootBone || (parentIndex >= 0 && inMask[parentIndex]);
+		if (inMask[bone])
+			mask.SetWeight(bone, weight);
+	}
+	return mask;
+}
+
+void SkinnedData::ConcatenateHierarchy(const Matrix3x4* toParent, XMFLOAT4X4* finalTransforms,
+	Scratch& scratch, UINT skipLeafLevels) const
+{
+	scratch.Reserve(static_cast<UINT>(mBoneOrder.size()));
+	Matrix3x4* toRootTransforms = scratch.ToRoot.data();
+	const XMVECTOR rowW = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+
+	const size_t evaluated = mHeightEnds[std::min<size_t>(skipLeafLevels, mHeightEnds.size() - 1)];
+	for (size_t i = 0; i < evaluated; ++i)
+	{
+		int bone = mBoneOrder[i];
+		XMVECTOR toRoot[3];
+		LoadRows(toParent[bone], toRoot);
+
+		int parentIndex = mBoneHierarchy[bone];
+		if (parentIndex >= 0)
+		{
+			XMVECTOR parentToRoot[3];
+			LoadRows(toRootTransforms[parentIndex], parentToRoot);
+			Concatenate(toRoot, parentToRoot, toRoot);
+		}
+		XMStoreFloat4A(&toRootTransforms[bone].Rows[0], toRoot[0]);
+		XMStoreFloat4A(&toRootTransforms[bone].Rows[1], toRoot[1]);
+		XMStoreFloat4A(&toRootTransforms[bone].Rows[2], toRoot[2]);
+
+		// (offset * toRoot)^T = toRoot^T * offset^T. 전치한 형태로 곱하므로 따로 전치하지 않는다.
+		XMVECTOR offset[3];
+		LoadRows(mOffsetRows[bone], offset);
+		Concatenate(offset, toRoot, offset);
 
-		XMStoreFloat4x4(&toRootTransforms[i], toRoot);
+		XMFLOAT4X4& finalTransform = finalTransforms[bone];
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[0]), offset[0]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[1]), offset[1]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[2]), offset[2]);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(finalTransform.m[3]), rowW);
 	}
 
-	for (auto i : Range(0, numBones))
+	// 부모에 대해 바인드 포즈인 뼈는 offset * toRoot가 부모의 것과 같다. 부모는 앞에서 이미 썼다.
+	for (size_t i = evaluated; i < mBoneOrder.size(); ++i)
 	{
-		XMMATRIX offset = XMLoadFloat4x4(&mBoneOffsets[i]);
-		XMMATRIX toRoot = XMLoadFloat4x4(&toRootTransforms[i]);
-		XMMATRIX finalTransform = XMMatrixMultiply(offset, toRoot);
-		XMStoreFloat4x4(&finalTransforms[i], XMMatrixTranspose(finalTransform));
+		int bone = mBoneOrder[i];
+		finalTransforms[bone] = finalTransforms[mBoneHierarchy[bone]];
 	}
 }
@@ -2,6 +2,9 @@
 
 #include "../Common/d3dUtil.h"
 #include "../Common/MathHelper.h"
+#include "SoaAnimationClip.h"
+#include "BakedAnimationClip.h"
+#include "CompressedAnimationClip.h"
 
 struct Keyframe
 {
@@ -20,6 +23,8 @@ struct BoneAnimation
 	float GetEndTime() const;
 
 	void Interpolate(float t, DirectX::XMFLOAT4X4& M) const;
+	// Interpolate와 같은 값을 행렬 대신 이동, 회전, 크기로 구한다. 키가 없으면 단위 변환
+	void Sample(float t, DirectX::XMVECTOR& T, DirectX::XMVECTOR& Q, DirectX::XMVECTOR& S) const;
 
 	std::vector<Keyframe> Keyframes;
 };
@@ -29,15 +34,83 @@ struct AnimationClip
 	float GetClipStartTime() const;
 	float GetClipEndTime() const;
 
-	void Interpolate(float t, std::vector<DirectX::XMFLOAT4X4>& boneTransforms) const;
+	// 압축한 클립이 있으면 그것을, 없으면 Soa를 샘플한다. cursors는 SkinnedData::KeyCursorCount()개이고
+	// nullptr이면 매번 이진 탐색한다.
+	void SamplePoses(float t, int* cursors, SoaTransform* poses) const;
 
 	std::vector<BoneAnimation> BoneAnimations;
+	// SkinnedData::Set과 SetClip에서 BoneAnimations로 만든다.
+	SoaAnimationClip Soa;
+	// SkinnedData::SetCompressedClip으로 넣는다. 이때는 BoneAnimations와 Soa가 비어 있고 압축한 트랙을 바로 샘플한다.
+	CompressedAnimationClip Compressed;
+	// SkinnedData::SetBakedClip으로 넣는다. 비어 있지 않으면 PoseRequest는 샘플과 계층 대신 이 표를 읽는다.
+	BakedAnimationClip Baked;
 };
 
 class SkinnedData
 {
 public:
+	// 이름으로 한 번 찾아 둔 클립. 매 프레임 문자열로 unordered_map을 찾지 않으려고 쓴다.
+	// Set으로 클립을 다시 넣으면 무효가 된다.
+	using ClipHandle = const AnimationClip*;
+
+	// 호출하는 쪽이 들고 있는 작업 공간. 뼈 수만큼 한 번 커진 뒤로는 다시 할당하지 않는다.
+	struct Scratch
+	{
+		void Reserve(UINT boneCount);
+
+		std::vector<Matrix3x4> ToParent;
+		std::vector<Matrix3x4> ToRoot;
+		std::vector<SoaTransform> Poses;
+		std::vector<SoaTransform> LayerPoses;
+	};
+
+	// 캐릭터 하나의 입력과 출력. FinalTransforms는 BoneCount()개를 담을 수 있어야 한다.
+	// KeyCursors는 캐릭터가 들고 있는 키 구간(KeyCursorCount()개, 처음엔 -1)이고 없으면 매번 이진 탐색한다.
+	// SoA 클립은 앞의 뼈 묶음 수만큼만 쓴다. 클립을 바꾸면 -1로 다시 채운다.
+	struct PoseRequest
+	{
+		ClipHandle Clip = nullptr;
+		float TimePos = 0.0f;
+		DirectX::XMFLOAT4X4* FinalTransforms = nullptr;
+		int* KeyCursors = nullptr;
+		// 끝 뼈에서 이만큼의 단계(자식이 없는 뼈가 첫 단계)는 부모에 대해 바인드 포즈로 두고 계층 계산을 건너뛴다.
+		UINT SkipLeafLevels = 0;
+	};
+
+	// 레이어가 뼈마다 얼마나 덮을지(0 ~ 1). 뼈 네 개씩 묶어 SoA 포즈와 같은 순서로 담는다.
+	struct BoneMask
+	{
+		void SetWeight(UINT bone, float weight) { (&Weights[bone / SoaAnimationClip::Lanes].x)[bone % SoaAnimationClip::Lanes] = weight; }
+
+		std::vector<DirectX::XMFLOAT4A> Weights;
+	};
+
+	// 클립 하나를 재생하는 층. Weight와 Mask로 아래 층까지 섞은 포즈를 이 층의 포즈 쪽으로 섞는다.
+	// 두 층을 같은 마스크 없이 섞으면 크로스페이드, 상체 마스크를 주면 부분 레이어가 된다.
+	struct BlendLayer
+	{
+		ClipHandle Clip = nullptr;
+		float TimePos = 0.0f;
+		float Weight = 1.0f;
+		const BoneMask* Mask = nullptr;		// nullptr이면 모든 뼈
+		int* KeyCursors = nullptr;			// PoseRequest::KeyCursors와 같다.
+	};
+
+	// 캐릭터 하나의 층들. 첫 층은 바탕이라 Weight와 Mask를 보지 않는다.
+	struct BlendRequest
+	{
+		const BlendLayer* Layers = nullptr;
+		UINT LayerCount = 0;
+		DirectX::XMFLOAT4X4* FinalTransforms = nullptr;
+	};
+
 	UINT BoneCount() const;
+	// 캐릭터 하나가 들고 있을 키 커서 수. 압축한 클립은 뼈마다 트랙 셋의 커서를 쓴다.
+	UINT KeyCursorCount() const { return BoneCount() * CompressedAnimationClip::TracksPerBone; }
+
+	// 없는 이름이면 nullptr
+	ClipHandle FindClip(const std::string& clipName) const;
 
 	float GetClipStartTime(const std::string& clipName) const;
 	float GetClipEndTime(const std::string& clipName) const;
@@ -47,11 +120,40 @@ public:
 		std::vector<DirectX::XMFLOAT4X4>& boneOffsets,
 		std::unordered_map<std::string, AnimationClip>& animations);
 
+	// 클립 하나를 넣거나 같은 이름의 클립을 바꾼다. 바꾼 클립의 핸들은 그대로지만 키 커서는 -1로 다시 채워야 한다.
+	// 구워 둔 표는 지워진다. (Set도 같다)
+	void SetClip(const std::string& clipName, const AnimationClip& clip);
+	// 압축한 클립(CompressAnimationClip)을 넣거나 같은 이름의 클립을 바꾼다. 키와 SoA 클립은 버리고 압축한 트랙만 둔다.
+	// 핸들과 키 커서는 SetClip과 같다.
+	void SetCompressedClip(const std::string& clipName, const CompressedAnimationClip& compressed);
+	// 이 골격으로 구운 표(BakeAnimationClip)를 클립에 붙인다. 빈 표를 넘기면 다시 키를 샘플한다.
+	// 핸들과 키 커서는 그대로 쓴다.
+	void SetBakedClip(const std::string& clipName, const BakedAnimationClip& baked);
+
 	void GetFinalTransforms(const std::string& clipName, float timePos,
 		std::vector<DirectX::XMFLOAT4X4>& finalTransforms) const;
+	// 여러 캐릭터를 한 번에 계산한다. scratch를 계속 넘기면 힙 할당이 없다.
+	// 구워 둔 클립은 표에서 읽으므로 KeyCursors와 SkipLeafLevels를 보지 않는다.
+	void GetFinalTransforms(const PoseRequest* requests, UINT count, Scratch& scratch) const;
+	// 층마다 SoA 포즈를 샘플해서 차례로 섞고 계층은 한 번만 이어 붙인다. scratch를 계속 넘기면 힙 할당이 없다.
+	// 섞으려면 뼈별 포즈가 있어야 하므로 구워 둔 표는 쓰지 않는다.
+	void GetFinalTransforms(const BlendRequest* requests, UINT count, Scratch& scratch) const;
+
+	// rootBone과 그 아래 모든 뼈를 weight로, 나머지 뼈를 0으로 채운 마스크
+	BoneMask MakeBoneMask(int rootBone, float weight = 1.0f) const;
+
+	// 뼈별 부모 기준 변환(toParent)을 부모가 먼저 오는 순서로 이어 붙여 루트 기준으로 만들고,
+	// 곧바로 오프셋을 곱해 셰이더로 보낼 (전치한) 최종 변환을 쓴다. scratch.ToRoot를 쓴다.
+	// 끝 뼈 skipLeafLevels 단계는 부모의 최종 변환을 그대로 쓴다(ToRoot는 채우지 않는다).
+	void ConcatenateHierarchy(const Matrix3x4* toParent, DirectX::XMFLOAT4X4* finalTransforms,
+		Scratch& scratch, UINT skipLeafLevels = 0) const;
 
 private:
 	std::vector<int> mBoneHierarchy;
 	std::vector<DirectX::XMFLOAT4X4> mBoneOffsets;
+	// Set에서 만든다. 부모가 자식보다 먼저 오는 뼈 순서와 3x4로 바꿔 둔 오프셋
+	std::vector<int> mBoneOrder;
+	std::vector<UINT> mHeightEnds;		// 높이가 h 이상인 뼈 수. mBoneOrder에서 그만큼이 앞에 있다.
+	std::vector<Matrix3x4> mOffsetRows;
 	std::unordered_map<std::string, AnimationClip> mAnimations;
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../Common/GeometryGenerator.h"
 #include "ShadowMap.h"
 #include "Ssao.h"
+#include <string>
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -565,9 +566,18 @@ void SkinnedMeshApp::LoadSkinnedModel()
 	mSkinnedModelInst = std::make_unique<SkinnedModelInstance>();
 	mSkinnedModelInst->SkinnedInfo = &mSkinnedInfo;
 	mSkinnedModelInst->FinalTransforms.resize(mSkinnedInfo.BoneCount());
-	mSkinnedModelInst->ClipName = "Take1";
+	mSkinnedModelInst->SetClip("Take1");
 	mSkinnedModelInst->TimePos = 0.0f;
 
+	//무리는 시작 시간을 8가지로만 나눠 두어 같은 포즈를 나눠 쓰게 한다.
+	for (auto i : Range(0, CrowdRows * CrowdColumns))
+		mCrowd.Add(mSkinnedModelInst->Clip, mSkinnedModelInst->ClipEndTime * (i % 8) / 8.0f);
+	//멀어질수록 포즈를 드물게 구하고 끝 뼈를 건너뛴다.
+	mCrowd.SetLodLevels({ { 10.0f, 1, 0 }, { 20.0f, 2, 0 }, { 40.0f, 4, 1 }, { FLT_MAX, 8, 2 } });
+
+	mSkinnedPicker.Build(vertices, indices, mSkinnedInfo.BoneCount());
+	mSkinnedVertices = vertices;
+
 	const UINT vbByteSize = (UINT)vertices.size() * sizeof(SkinnedVertex);
 	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
@@ -633,6 +643,8 @@ void SkinnedMeshApp::BuildMaterials()
 			skinMat.DiffuseAlbedo, skinMat.FresnelR0, skinMat.Roughness);
 		srvHeapIndex += 2;
 		});
+
+	MakeMaterial("highlight0", matCBIndex++, 4, 5, { 1.0f, 1.0f, 0.0f, 0.6f }, { 0.06f, 0.06f, 0.06f }, 0.0f);
 }
 
 void SkinnedMeshApp::BuildRenderItems()
@@ -680,18 +692,35 @@ void SkinnedMeshApp::BuildRenderItems()
 		MakeRenderItem("shapeGeo", "sphere", "mirror0", rightSphereWorld, XMMatrixIdentity(), RenderLayer::Opaque);
 	}
 
+	XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
+	XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
+	XMMATRIX modelOffset = XMMatrixTranslation(0.0f, 0.0f, -5.0f);
+	XMMATRIX modelWorld = modelScale * modelRot * modelOffset;
 	for(auto i : Range(0, static_cast<UINT>(mSkinnedMats.size())))
 	{
 		std::string submeshName = "sm_" + std::to_string(i);
-		
-		auto ritem = std::make_unique<RenderItem>();
+		MakeRenderItem(mSkinnedModelFilename, submeshName, mSkinnedMats[i].Name, modelWorld, 
+			XMMatrixIdentity(), RenderLayer::SkinnedOpaque, true, 0, mSkinnedModelInst.get());
+	}
 
-		XMMATRIX modelScale = XMMatrixScaling(0.05f, 0.05f, -0.05f);
-		XMMATRIX modelRot = XMMatrixRotationY(MathHelper::Pi);
-		XMMATRIX modelOffset = XMMatrixTranslation(0.0f, 0.0f, -5.0f);
+	//피킹된 삼각형도 같은 본 팔레트로 스키닝해야 애니메이션 중에 메쉬와 어긋나지 않는다.
+	MakeRenderItem(mSkinnedModelFilename, "sm_0", "highlight0", modelWorld, XMMatrixIdentity(), 
+		RenderLayer::SkinnedHighlight, false, 0, mSkinnedModelInst.get());
+	mPickedRitem = mRitemLayer[RenderLayer::SkinnedHighlight].at(0);
 
-		MakeRenderItem(mSkinnedModelFilename, submeshName, mSkinnedMats[i].Name, modelScale * modelRot * modelOffset, 
-			XMMatrixIdentity(), RenderLayer::SkinnedOpaque, true, 0, mSkinnedModelInst.get());
+	//무리는 피킹 대상인 병사 뒤에 붙인다. 처음에는 숨겨 두고 G로 보인다.
+	for (auto i : Range(0, static_cast<int>(mCrowd.Count())))
+	{
+		XMMATRIX offset = XMMatrixTranslation(
+			-3.5f + (i % CrowdColumns) * 1.0f, 0.0f, 2.0f + (i / CrowdColumns) * 1.0f);
+		//병사 키가 3.6 정도라서 허리쯤을 중심으로 잡는다.
+		mCrowd.SetPosition(i, XMFLOAT3(-3.5f + (i % CrowdColumns) * 1.0f, 1.8f, 2.0f + (i / CrowdColumns) * 1.0f));
+		for (auto sm : Range(0, static_cast<UINT>(mSkinnedMats.size())))
+		{
+			MakeRenderItem(mSkinnedModelFilename, "sm_" + std::to_string(sm), mSkinnedMats[sm].Name,
+				modelScale * modelRot * offset, XMMatrixIdentity(), RenderLayer::SkinnedOpaque, false, 1 + i, mSkinnedModelInst.get());
+			mCrowdRitems.emplace_back(mRitemLayer[RenderLayer::SkinnedOpaque].back());
+		}
 	}
 }
 
@@ -700,7 +729,7 @@ void SkinnedMeshApp::BuildFrameResources()
 	for (auto i : Range(0, gNumFrameResources))
 	{
 		auto frameRes = std::make_unique<FrameResource>(md3dDevice.Get(), 2,
-			static_cast<UINT>(mAllRitems.size()), 1, static_cast<UINT>(mMaterials.size()));
+			static_cast<UINT>(mAllRitems.size()), 1 + mCrowd.Count(), static_cast<UINT>(mMaterials.size()));
 		mFrameResources.emplace_back(std::move(frameRes));
 	}
 }
@@ -736,6 +765,26 @@ void SkinnedMeshApp::MakeSkinnedOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* i
 	inoutDesc->PS = GetShaderBytecode(mShaders, "opaquePS");
 }
 
+void SkinnedMeshApp::MakeSkinnedHighlightDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
+{
+	MakeSkinnedOpaqueDesc(inoutDesc);
+	inoutDesc->DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+
+	D3D12_RENDER_TARGET_BLEND_DESC blendDesc;
+	blendDesc.BlendEnable = true;
+	blendDesc.LogicOpEnable = false;
+	blendDesc.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+	blendDesc.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+	blendDesc.BlendOp = D3D12_BLEND_OP_ADD;
+	blendDesc.SrcBlendAlpha = D3D12_BLEND_ONE;
+	blendDesc.DestBlendAlpha = D3D12_BLEND_ZERO;
+	blendDesc.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+	blendDesc.LogicOp = D3D12_LOGIC_OP_NOOP;
+	blendDesc.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+	inoutDesc->BlendState.RenderTarget[0] = blendDesc;
+}
+
 void SkinnedMeshApp::MakeShadowOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
 {
 	inoutDesc->RasterizerState.DepthBias = 100000;
@@ -820,6 +869,7 @@ void SkinnedMeshApp::MakePSOPipelineState(GraphicsPSO psoType)
 	{
 	case GraphicsPSO::Opaque:																										break;
 	case GraphicsPSO::SkinnedOpaque:					MakeSkinnedOpaqueDesc(&psoDesc);		break;
+	case GraphicsPSO::SkinnedHighlight:				MakeSkinnedHighlightDesc(&psoDesc);	break;
 	case GraphicsPSO::ShadowOpaque:					MakeShadowOpaqueDesc(&psoDesc);		break;
 	case GraphicsPSO::SkinnedShadowOpaque:	MakeSkinnedShadowOpaque(&psoDesc);	break;
 	case GraphicsPSO::Debug:									MakeDebugDesc(&psoDesc);						break;
@@ -845,6 +895,7 @@ void SkinnedMeshApp::OnResize()
 	D3DApp::OnResize();
 
 	mCamera.SetLens(0.25f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.f);
+	BoundingFrustum::CreateFromMatrix(mCamFrustum, mCamera.GetProj());
 
 	if (mSsao != nullptr)
 	{
@@ -879,6 +930,105 @@ void SkinnedMeshApp::OnKeyboardInput(const GameTimer& gt)
 	mCamera.Move(Camera::eStrafe, strafeSpeed * dt);
 
 	mCamera.UpdateViewMatrix();
+
+	//B를 누를 때 한 번만 돌린다.
+	bool benchmarkKey = (GetAsyncKeyState('B') & 0x8000) != 0;
+	if (benchmarkKey && !mBenchmarkKeyDown)
+	{
+		RunAnimationBenchmark();
+		RunHierarchyBenchmark();
+		RunCrowdBenchmark();
+		RunSkinningBenchmark();
+		RunBlendBenchmark();
+		RunAnimationLodBenchmark();
+		RunBakedAnimationBenchmark();
+	}
+	mBenchmarkKeyDown = benchmarkKey;
+
+	//C를 누를 때마다 압축한 클립과 원래 클립을 바꾼다.
+	bool compressKey = (GetAsyncKeyState('C') & 0x8000) != 0;
+	if (compressKey && !mCompressKeyDown)
+		ToggleCompressedClip();
+	mCompressKeyDown = compressKey;
+
+	//K를 누를 때마다 지금 클립을 구운 표로 재생하거나 다시 키를 샘플한다.
+	bool bakeKey = (GetAsyncKeyState('K') & 0x8000) != 0;
+	if (bakeKey && !mBakeKeyDown)
+		ToggleBakedClip();
+	mBakeKeyDown = bakeKey;
+
+	//G를 누를 때마다 무리를 보이거나 숨긴다.
+	bool crowdKey = (GetAsyncKeyState('G') & 0x8000) != 0;
+	if (crowdKey && !mCrowdKeyDown)
+	{
+		mShowCrowd = !mShowCrowd;
+		for (auto ri : mCrowdRitems)
+			ri->Visible = mShowCrowd;
+	}
+	mCrowdKeyDown = crowdKey;
+}
+
+//지금 클립을 압축해서 압축률과 뼈별 최대 오차를 출력 창에 찍고, 압축한 채로 SkinnedData에 넣는다.
+//다시 부르면 원래 클립으로 돌린다.
+void SkinnedMeshApp::ToggleCompressedClip()
+{
+	const std::string& clipName = mSkinnedModelInst->ClipName;
+	if (!mUseCompressedClip && mUncompressedClip.BoneAnimations.empty())
+		mUncompressedClip = *mSkinnedInfo.FindClip(clipName);
+
+	mUseCompressedClip = !mUseCompressedClip;
+	mUseBakedClip = false;	//클립을 다시 넣으면 구워 둔 표는 지워진다.
+	if (!mUseCompressedClip)
+	{
+		mSkinnedInfo.SetClip(clipName, mUncompressedClip);
+		mSkinnedModelInst->SetClip(clipName);
+		OutputDebugStringW(L"Animation compression off\n");
+		return;
+	}
+
+	AnimationCompressionSettings settings;
+	CompressedAnimationClip compressed;
+	AnimationCompressionReport report;
+	CompressAnimationClip(mUncompressedClip, settings, compressed, &report);
+
+	mSkinnedInfo.SetCompressedClip(clipName, compressed);
+	mSkinnedModelInst->SetClip(clipName);
+
+	std::wstring text = L"Animation compression on: " + std::to_wstring(report.OriginalBytes) + L" -> " +
+		std::to_wstring(report.CompressedBytes) + L" bytes (" + std::to_wstring(report.Ratio()) + L":1), keys " +
+		std::to_wstring(report.OriginalKeys) + L" -> " + std::to_wstring(report.CompressedKeys) + L"\n";
+	for (size_t i = 0; i < report.Bones.size(); ++i)
+	{
+		const AnimationCompressionReport::BoneError& error = report.Bones[i];
+		text += L"  bone " + std::to_wstring(i) + L": translation " + std::to_wstring(error.Translation) +
+			L", rotation " + std::to_wstring(error.RotationDegrees) + L" deg, scale " + std::to_wstring(error.Scale) + L"\n";
+	}
+	OutputDebugStringW(text.c_str());
+}
+
+//병사와 무리 모두 표에서 읽는다. 압축을 켠 상태면 압축한 클립을 굽는다.
+void SkinnedMeshApp::ToggleBakedClip()
+{
+	const std::string& clipName = mSkinnedModelInst->ClipName;
+	mUseBakedClip = !mUseBakedClip;
+	if (!mUseBakedClip)
+	{
+		mSkinnedInfo.SetBakedClip(clipName, BakedAnimationClip());
+		OutputDebugStringW(L"Baked animation off\n");
+		return;
+	}
+
+	AnimationBakeSettings settings;
+	BakedAnimationClip baked;
+	AnimationBakeReport report;
+	BakeAnimationClip(mSkinnedInfo, mSkinnedModelInst->Clip, settings, baked, &mSkinnedVertices, &report);
+	mSkinnedInfo.SetBakedClip(clipName, baked);
+
+	std::wstring text = L"Baked animation on: " + std::to_wstring(baked.SampleRate()) + L" Hz, " +
+		std::to_wstring(report.FrameCount) + L" frames, " + std::to_wstring(report.BakedBytes) + L" bytes (keys " +
+		std::to_wstring(report.KeyBytes) + L" bytes), max vertex error " + std::to_wstring(report.MaxVertexError) +
+		L", mean " + std::to_wstring(report.MeanVertexError) + L"\n";
+	OutputDebugStringW(text.c_str());
 }
 
 void SkinnedMeshApp::AnimateMaterials(const GameTimer& gt)
@@ -914,7 +1064,7 @@ void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 {
 	auto currSkinnedCB = mCurFrameRes->SkinnedCB.get();
 
-	mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime());
+	mSkinnedModelInst->UpdateSkinnedAnimation(gt.DeltaTime(), mSkinnedScratch);
 
 	SkinnedConstants skinnedConstants;
 	std::copy(
@@ -923,6 +1073,21 @@ void SkinnedMeshApp::UpdateSkinnedCBs(const GameTimer& gt)
 		&skinnedConstants.BoneTransforms[0]);
 
 	currSkinnedCB->CopyData(0, skinnedConstants);
+
+	if (!mShowCrowd)
+		return;
+
+	XMMATRIX view = mCamera.GetView();
+	BoundingFrustum worldFrustum;
+	mCamFrustum.Transform(worldFrustum, Inverse(view));
+	mCrowd.SetView(mCamera.GetPosition3f(), &worldFrustum, 2.4f);
+	mCrowd.Update(gt.DeltaTime());
+	for (auto i : Range(0, static_cast<int>(mCrowd.Count())))
+	{
+		const XMFLOAT4X4* finalTransforms = mCrowd.FinalTransforms(i);
+		std::copy(finalTransforms, finalTransforms + mSkinnedInfo.BoneCount(), &skinnedConstants.BoneTransforms[0]);
+		currSkinnedCB->CopyData(1 + i, skinnedConstants);
+	}
 }
 
 void SkinnedMeshApp::UpdateMaterialBuffer(const GameTimer& gt)
@@ -1132,6 +1297,9 @@ void SkinnedMeshApp::DrawRenderItems(
 
 	for (auto& ri : ritems)
 	{
+		if (ri->Visible == false)
+			continue;
+
 		cmdList->IASetVertexBuffers(0, 1, &RvToLv(ri->Geo->VertexBufferView()));
 		cmdList->IASetIndexBuffer(&RvToLv(ri->Geo->IndexBufferView()));
 		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
@@ -1273,6 +1441,9 @@ void SkinnedMeshApp::Draw(const GameTimer& gt)
 	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::SkinnedOpaque].Get());
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::SkinnedOpaque]);
 
+	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::SkinnedHighlight].Get());
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::SkinnedHighlight]);
+
 	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Debug].Get());
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Debug]);
 
@@ -1304,6 +1475,10 @@ void SkinnedMeshApp::OnMouseDown(WPARAM btnState, int x, int y)
 
 		SetCapture(mhMainWnd);
 	}
+	else if ((btnState & MK_RBUTTON) != 0)
+	{
+		Pick(x, y);
+	}
 }
 void SkinnedMeshApp::OnMouseUp(WPARAM btnState, int x, int y)
 {
@@ -1325,6 +1500,44 @@ void SkinnedMeshApp::OnMouseMove(WPARAM btnState, int x, int y)
 	mLastMousePos.y = y;
 }
 
+void SkinnedMeshApp::Pick(int sx, int sy)
+{
+	XMFLOAT4X4 P = mCamera.GetProj4x4f();
+
+	float vx = (2.0f * sx / mClientWidth - 1.0f) / P(0, 0);
+	float vy = (-2.0f * sy / mClientHeight + 1.0f) / P(1, 1);
+
+	XMVECTOR viewRayOrigin = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMVECTOR viewRayDir = XMVectorSet(vx, vy, 1.0f, 0.0f);
+
+	XMMATRIX V = mCamera.GetView();
+	XMMATRIX invView = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(V)), V);
+
+	mPickedRitem->Visible = false;
+
+	//서브셋들은 같은 월드 행렬과 본 팔레트를 쓰므로 모델 로컬 공간에서 한 번만 검사한다.
+	auto ri = mRitemLayer[RenderLayer::SkinnedOpaque].front();
+	XMMATRIX W = XMLoadFloat4x4(&ri->World);
+	XMMATRIX invWorld = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(W)), W);
+	XMMATRIX toLocal = XMMatrixMultiply(invView, invWorld);
+
+	XMVECTOR rayOrigin = XMVector3TransformCoord(viewRayOrigin, toLocal);
+	XMVECTOR rayDir = XMVector3Normalize(XMVector3TransformNormal(viewRayDir, toLocal));
+
+	float tmin = 0.0f;
+	UINT pickedTriangle = 0;
+	if (mSkinnedPicker.Pick(ri->SkinnedModelInst->FinalTransforms, rayOrigin, rayDir, tmin, pickedTriangle) == false)
+		return;
+
+	mPickedRitem->Visible = true;
+	mPickedRitem->IndexCount = 3;
+	mPickedRitem->BaseVertexLocation = 0;
+	mPickedRitem->StartIndexLocation = 3 * pickedTriangle;
+
+	mPickedRitem->World = ri->World;
+	mPickedRitem->NumFramesDirty = gNumFrameResources;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
 {
 #if defined(DEBUG) | defined(_DEBUG)
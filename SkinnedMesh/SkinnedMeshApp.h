@@ -10,6 +10,11 @@
 #include "FrameResource.h"
 #include "SkinnedData.h"
 #include "LoadM3d.h"
+#include "SkinnedPicker.h"
+#include "AnimationCompressor.h"
+#include "SkinnedCrowd.h"
+#include "CpuSkinning.h"
+#include "AnimationBaker.h"
 #include <map>
 
 class ShadowMap;
@@ -21,16 +26,32 @@ struct SkinnedModelInstance
 	SkinnedData* SkinnedInfo = nullptr;
 	std::vector<DirectX::XMFLOAT4X4> FinalTransforms;
 	std::string ClipName;
+	SkinnedData::ClipHandle Clip = nullptr;
+	std::vector<int> KeyCursors;
+	float ClipEndTime{ 0.0f };
 	float TimePos{ 0.0f };
 
-	void UpdateSkinnedAnimation(float dt)
+	void SetClip(const std::string& clipName)
+	{
+		ClipName = clipName;
+		Clip = SkinnedInfo->FindClip(clipName);
+		ClipEndTime = Clip->GetClipEndTime();
+		KeyCursors.assign(SkinnedInfo->KeyCursorCount(), -1);
+	}
+
+	void UpdateSkinnedAnimation(float dt, SkinnedData::Scratch& scratch)
 	{
 		TimePos += dt;
 
-		if (TimePos > SkinnedInfo->GetClipEndTime(ClipName))
+		if (TimePos > ClipEndTime)
 			TimePos = 0.0f;
 
-		SkinnedInfo->GetFinalTransforms(ClipName, TimePos, FinalTransforms);
+		SkinnedData::PoseRequest request;
+		request.Clip = Clip;
+		request.TimePos = TimePos;
+		request.FinalTransforms = FinalTransforms.data();
+		request.KeyCursors = KeyCursors.data();
+		SkinnedInfo->GetFinalTransforms(&request, 1, scratch);
 	}
 };
 
@@ -67,6 +88,7 @@ enum class RenderLayer : int
 {
 	Opaque = 0,
 	SkinnedOpaque,
+	SkinnedHighlight,
 	Debug,
 	Sky,
 	Count
@@ -76,6 +98,7 @@ enum class GraphicsPSO : int
 {
 	Opaque = 0,
 	SkinnedOpaque,
+	SkinnedHighlight,
 	ShadowOpaque,
 	SkinnedShadowOpaque,
 	Debug,
@@ -91,6 +114,7 @@ constexpr std::array<GraphicsPSO, static_cast<size_t>(GraphicsPSO::Count)> Graph
 {
 	GraphicsPSO::Opaque,
 	GraphicsPSO::SkinnedOpaque,
+	GraphicsPSO::SkinnedHighlight,
 	GraphicsPSO::ShadowOpaque,
 	GraphicsPSO::SkinnedShadowOpaque,
 	GraphicsPSO::Debug,
@@ -142,6 +166,7 @@ private:
 	void BuildMaterials();
 	void MakeOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeSkinnedOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
+	void MakeSkinnedHighlightDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeShadowOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeSkinnedShadowOpaque(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeDebugDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
@@ -158,6 +183,18 @@ private:
 		const std::vector<RenderItem*> ritems);
 	void DrawSceneToShadowMap();
 	void DrawNormalsAndDepth();
+	void Pick(int sx, int sy);
+	void ToggleCompressedClip();
+	void ToggleBakedClip();
+
+	//SkinnedMeshBench.cpp
+	void RunAnimationBenchmark();
+	void RunHierarchyBenchmark();
+	void RunCrowdBenchmark();
+	void RunSkinningBenchmark();
+	void RunBlendBenchmark();
+	void RunAnimationLodBenchmark();
+	void RunBakedAnimationBenchmark();
 
 	CD3DX12_CPU_DESCRIPTOR_HANDLE GetCpuSrv(int index) const;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE GetGpuSrv(int index) const;
@@ -220,8 +257,26 @@ private:
 	std::string mSkinnedModelFilename{ "Models/soldier.m3d" };
 	std::unique_ptr<SkinnedModelInstance> mSkinnedModelInst{ nullptr };
 	SkinnedData mSkinnedInfo{};
+	std::vector<M3DLoader::SkinnedVertex> mSkinnedVertices;
 	std::vector<M3DLoader::Subset> mSkinnedSubsets;
 	std::vector<M3DLoader::M3dMaterial> mSkinnedMats;
 	std::vector<std::string> mSkinnedTextureNames;
+	SkinnedPicker mSkinnedPicker;
+	SkinnedData::Scratch mSkinnedScratch;
+	bool mBenchmarkKeyDown = false;
+	AnimationClip mUncompressedClip;
+	bool mUseCompressedClip = false;
+	bool mCompressKeyDown = false;
+	bool mUseBakedClip = false;
+	bool mBakeKeyDown = false;
+	//병사 무리. 스킨드 상수 버퍼 1번부터 캐릭터마다 하나씩 쓴다.
+	static constexpr int CrowdRows = 8;
+	static constexpr int CrowdColumns = 8;
+	SkinnedCrowd mCrowd{ &mSkinnedInfo };
+	std::vector<RenderItem*> mCrowdRitems;
+	bool mShowCrowd = false;
+	bool mCrowdKeyDown = false;
+	//카메라 공간 절두체. 무리에서 화면 밖 캐릭터를 가릴 때 월드 공간으로 옮겨 쓴다.
+	DirectX::BoundingFrustum mCamFrustum{};
 	
 };
@@ -0,0 +1,432 @@
+﻿#include "SkinnedMeshApp.h"
+#include "../Common/Util.h"
+#include "../Common/TaskScheduler.h"
+#include "../Common/Benchmark.h"
+#include <climits>
+
+using namespace DirectX;
+
+//캐릭터 수별로 이름으로 한 명씩 부르는 GetFinalTransforms, 클립 핸들과 작업 공간을 넘겨
+//한 번에 부르는 GetFinalTransforms, 여기에 키 커서까지 넘긴 경우의 처리량(캐릭터/ms)을 출력 창에 찍는다.
+//캐릭터마다 시작 시간을 다르게 두고 세 경우 모두 같은 시간을 앞으로 재생한다.
+void SkinnedMeshApp::RunAnimationBenchmark()
+{
+	const UINT numBones = mSkinnedInfo.BoneCount();
+	const UINT cursorCount = mSkinnedInfo.KeyCursorCount();
+	const float endTime = mSkinnedModelInst->ClipEndTime;
+	const float dt = 1.0f / 60.0f;
+	const int frames = 16;
+
+	for (int characters : { 1, 64, 1024 })
+	{
+		std::vector<XMFLOAT4X4> transforms(static_cast<size_t>(characters) * numBones);
+		std::vector<int> keyCursors(static_cast<size_t>(characters) * cursorCount, -1);
+		std::vector<float> startTime(characters);
+		for (auto& t : startTime)
+			t = MathHelper::RandF(0.0f, endTime);
+
+		std::vector<SkinnedData::PoseRequest> requests(characters);
+		for (auto c : Range(0, characters))
+		{
+			requests[c].Clip = mSkinnedModelInst->Clip;
+			requests[c].FinalTransforms = &transforms[static_cast<size_t>(c) * numBones];
+		}
+
+		auto timeAt = [&](int c, int frame) { return fmodf(startTime[c] + frame * dt, endTime); };
+		auto batch = [&](bool useCursors) {
+			for (auto c : Range(0, characters))
+				requests[c].KeyCursors = useCursors ? &keyCursors[static_cast<size_t>(c) * cursorCount] : nullptr;
+
+			return Benchmark::MeasureMs([&]() {
+				for (int frame = 0; frame < frames; ++frame)
+				{
+					for (auto c : Range(0, characters))
+						requests[c].TimePos = timeAt(c, frame);
+					mSkinnedInfo.GetFinalTransforms(requests.data(), static_cast<UINT>(characters), mSkinnedScratch);
+				}});
+		};
+
+		std::vector<XMFLOAT4X4> single(numBones);
+		double singleMs = Benchmark::MeasureMs([&]() {
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				for (auto c : Range(0, characters))
+					mSkinnedInfo.GetFinalTransforms(mSkinnedModelInst->ClipName, timeAt(c, frame), single);
+			}});
+		double batchMs = batch(false);
+		double cursorMs = batch(true);
+		double total = static_cast<double>(characters) * frames;
+
+		Benchmark::Report report(L"Skinned animation ");
+		report << characters << L" characters (" << numBones << L" bones): by name " << total / singleMs <<
+			L" characters/ms, batched " << total / batchMs <<
+			L" characters/ms, batched + key cursors " << total / cursorMs << L" characters/ms";
+		report.Print();
+	}
+}
+
+//캐릭터마다 시작 시간을 다르게 둔 무리를 돌려 처리량(캐릭터/ms)과 실제로 계산한 포즈 수를 출력 창에 찍는다.
+//포즈를 나눠 쓰지 않을 때(시간 간격 0)와 1/120초 간격으로 나눠 쓸 때를 비교한다.
+void SkinnedMeshApp::RunCrowdBenchmark()
+{
+	const float endTime = mSkinnedModelInst->ClipEndTime;
+	const float dt = 1.0f / 60.0f;
+	const int frames = 16;
+
+	for (int characters : { 1000, 4000 })
+	{
+		SkinnedCrowd crowd(&mSkinnedInfo);
+		for (auto c : Range(0, characters))
+			crowd.Add(mSkinnedModelInst->Clip, MathHelper::RandF(0.0f, endTime));
+
+		auto run = [&](float timeStep) {
+			crowd.SetTimeStep(timeStep);
+			crowd.Update(0.0f);	//작업 공간을 미리 키워 둔다.
+			return Benchmark::MeasureMs([&]() { crowd.Update(dt); }, frames);
+		};
+
+		double total = static_cast<double>(characters) * frames;
+		double unsharedMs = run(0.0f);
+		double sharedMs = run(1.0f / 120.0f);
+
+		Benchmark::Report report(L"Skinned crowd ");
+		report << characters << L" characters: unshared " << total / unsharedMs << L" characters/ms, shared " <<
+			total / sharedMs << L" characters/ms (" << crowd.EvaluatedPoseCount() << L" poses)";
+		report.Print();
+	}
+}
+
+//병사 메쉬를 지금 포즈로 CPU에서 스키닝해 1초에 처리하는 정점 수를 출력 창에 찍는다.
+//정점마다 영향 뼈 행렬로 XMVector3Transform을 하는 방식, SkinVertices(원래 배치, SoA)와 이를 스레드로 나눈 경우를 비교한다.
+void SkinnedMeshApp::RunSkinningBenchmark()
+{
+	const XMFLOAT4X4* palette = mSkinnedModelInst->FinalTransforms.data();
+	const UINT count = static_cast<UINT>(mSkinnedVertices.size());
+	const int passes = 32;
+	std::vector<M3DLoader::SkinnedVertex> out(count);
+	SkinnedVertexSoa soa;
+	soa.Resize(count);
+
+	//백만 정점/초
+	auto measure = [&](auto&& skin) {
+		return static_cast<double>(count) * passes / Benchmark::MeasureMs(skin, passes) / 1000.0;
+	};
+
+	double perVertex = measure([&]() {
+		for (auto i : Range(0, static_cast<int>(count)))
+		{
+			const M3DLoader::SkinnedVertex& v = mSkinnedVertices[i];
+			float weights[4] = { v.BoneWeights.x, v.BoneWeights.y, v.BoneWeights.z,
+				1.0f - v.BoneWeights.x - v.BoneWeights.y - v.BoneWeights.z };
+			XMVECTOR pos = XMVectorZero();
+			XMVECTOR normal = XMVectorZero();
+			XMVECTOR tangent = XMVectorZero();
+			for (auto b : Range(0, 4))
+			{
+				XMMATRIX M = XMMatrixTranspose(XMLoadFloat4x4(&palette[v.BoneIndices[b]]));
+				XMVECTOR w = XMVectorReplicate(weights[b]);
+				pos = XMVectorMultiplyAdd(w, XMVector3Transform(XMLoadFloat3(&v.Pos), M), pos);
+				normal = XMVectorMultiplyAdd(w, XMVector3TransformNormal(XMLoadFloat3(&v.Normal), M), normal);
+				tangent = XMVectorMultiplyAdd(w, XMVector3TransformNormal(XMLoadFloat3(&v.TangentU), M), tangent);
+			}
+			out[i] = v;
+			XMStoreFloat3(&out[i].Pos, pos);
+			XMStoreFloat3(&out[i].Normal, normal);
+			XMStoreFloat3(&out[i].TangentU, tangent);
+		}});
+	double original = measure([&]() { SkinVertices(mSkinnedVertices.data(), count, palette, out.data()); });
+	double soaSingle = measure([&]() { SkinVertices(mSkinnedVertices.data(), count, palette, soa.Groups.data()); });
+	TaskScheduler& scheduler = TaskScheduler::Default();
+	double originalParallel = measure([&]() { ParallelSkinVertices(scheduler, mSkinnedVertices, palette, out); });
+	double soaParallel = measure([&]() { ParallelSkinVertices(scheduler, mSkinnedVertices, palette, soa); });
+
+	Benchmark::Report report(L"CPU skinning ");
+	report << count << L" vertices (Mvertices/s): per vertex " << perVertex << L", original layout " << original <<
+		L", SoA " << soaSingle << L", " << scheduler.ThreadCount() << L" threads original layout " <<
+		originalParallel << L", SoA " << soaParallel;
+	report.Print();
+}
+
+//클립 하나를 재생할 때와 두 시간을 크로스페이드할 때, 여기에 상체 레이어를 하나 더 얹을 때의 처리량(캐릭터/ms)을
+//출력 창에 찍는다. 층은 모두 지금 클립을 서로 다른 시간으로 재생한다.
+void SkinnedMeshApp::RunBlendBenchmark()
+{
+	const UINT numBones = mSkinnedInfo.BoneCount();
+	const UINT cursorCount = mSkinnedInfo.KeyCursorCount();
+	const SkinnedData::ClipHandle clip = mSkinnedModelInst->Clip;
+	const float endTime = mSkinnedModelInst->ClipEndTime;
+	const float dt = 1.0f / 60.0f;
+	const int characters = 256;
+	const int frames = 16;
+	const int maxLayers = 3;
+	//soldier.m3d에서 허리 뼈. 다리는 2번 뼈에서 갈라지므로 3번 아래가 상체다.
+	const SkinnedData::BoneMask upperBody = mSkinnedInfo.MakeBoneMask(3);
+
+	std::vector<XMFLOAT4X4> transforms(static_cast<size_t>(characters) * numBones);
+	std::vector<int> keyCursors(static_cast<size_t>(characters) * maxLayers * cursorCount, -1);
+	std::vector<float> startTime(characters);
+	for (auto& t : startTime)
+		t = MathHelper::RandF(0.0f, endTime);
+
+	std::vector<SkinnedData::BlendLayer> layers(static_cast<size_t>(characters) * maxLayers);
+	std::vector<SkinnedData::BlendRequest> requests(characters);
+	for (auto c : Range(0, characters))
+	{
+		for (auto l : Range(0, maxLayers))
+		{
+			SkinnedData::BlendLayer& layer = layers[c * maxLayers + l];
+			layer.Clip = clip;
+			layer.KeyCursors = &keyCursors[(static_cast<size_t>(c) * maxLayers + l) * cursorCount];
+		}
+		layers[c * maxLayers + 1].Weight = 0.5f;
+		layers[c * maxLayers + 2].Mask = &upperBody;
+		requests[c].Layers = &layers[c * maxLayers];
+		requests[c].FinalTransforms = &transforms[static_cast<size_t>(c) * numBones];
+	}
+
+	auto timeAt = [&](int c, int frame, int layer) { return fmodf(startTime[c] + frame * dt + layer * 0.25f * endTime, endTime); };
+	auto blend = [&](UINT layerCount) {
+		for (auto& request : requests)
+			request.LayerCount = layerCount;
+
+		return Benchmark::MeasureMs([&]() {
+			for (int frame = 0; frame < frames; ++frame)
+			{
+				for (auto c : Range(0, characters))
+					for (auto l : Range(0, maxLayers))
+						layers[c * maxLayers + l].TimePos = timeAt(c, frame, l);
+				mSkinnedInfo.GetFinalTransforms(requests.data(), static_cast<UINT>(characters), mSkinnedScratch);
+			}});
+	};
+
+	std::vector<SkinnedData::PoseRequest> singles(characters);
+	for (auto c : Range(0, characters))
+	{
+		singles[c].Clip = clip;
+		singles[c].FinalTransforms = &transforms[static_cast<size_t>(c) * numBones];
+		singles[c].KeyCursors = &keyCursors[static_cast<size_t>(c) * maxLayers * cursorCount];
+	}
+	double singleMs = Benchmark::MeasureMs([&]() {
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (auto c : Range(0, characters))
+				singles[c].TimePos = timeAt(c, frame, 0);
+			mSkinnedInfo.GetFinalTransforms(singles.data(), static_cast<UINT>(characters), mSkinnedScratch);
+		}});
+	double crossFadeMs = blend(2);
+	double layeredMs = blend(3);
+	double total = static_cast<double>(characters) * frames;
+
+	Benchmark::Report report(L"Animation blending ");
+	report << characters << L" characters: single clip " << total / singleMs << L" characters/ms, crossfade " <<
+		total / crossFadeMs << L" characters/ms (x" << crossFadeMs / singleMs << L"), crossfade + upper body layer " <<
+		total / layeredMs << L" characters/ms (x" << layeredMs / singleMs << L")";
+	report.Print();
+}
+
+//원점에서 +z를 보는 카메라 앞뒤 100 x 100 안에 흩어 둔 무리를 LOD 없이 돌릴 때와 LOD 단계와 화면 밖 멈춤을 켤 때
+//처리량(캐릭터/ms)과 프레임마다 포즈를 구한 캐릭터 수(최소 ~ 최대), 가장 느린 프레임을 출력 창에 찍는다.
+//LOD 효과만 보려고 포즈는 나눠 쓰지 않는다.
+void SkinnedMeshApp::RunAnimationLodBenchmark()
+{
+	const float endTime = mSkinnedModelInst->ClipEndTime;
+	const float dt = 1.0f / 60.0f;
+	const int characters = 4000;
+	const int frames = 64;
+
+	SkinnedCrowd crowd(&mSkinnedInfo);
+	crowd.SetTimeStep(0.0f);
+	for (auto c : Range(0, characters))
+		crowd.Add(mSkinnedModelInst->Clip, MathHelper::RandF(0.0f, endTime), 1.0f,
+			XMFLOAT3(MathHelper::RandF(-50.0f, 50.0f), 1.8f, MathHelper::RandF(-50.0f, 50.0f)));
+
+	auto run = [&](bool lod, UINT& minUpdated, UINT& maxUpdated, double& maxFrameMs) {
+		crowd.SetLodLevels(lod ?
+			std::vector<SkinnedCrowd::LodLevel>{ { 10.0f, 1, 0 }, { 20.0f, 2, 0 }, { 40.0f, 4, 1 }, { FLT_MAX, 8, 2 } } :
+			std::vector<SkinnedCrowd::LodLevel>{});
+		crowd.SetView(XMFLOAT3(0.0f, 0.0f, 0.0f), lod ? &mCamFrustum : nullptr, 2.4f);
+		//처음 몇 프레임은 캐릭터마다 팔레트를 바로 맞추므로 재지 않는다.
+		for (int frame = 0; frame < 8; ++frame)
+			crowd.Update(dt);
+
+		minUpdated = UINT_MAX;
+		maxUpdated = 0;
+		maxFrameMs = 0.0;
+		double totalMs = 0.0;
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			double ms = Benchmark::MeasureMs([&]() { crowd.Update(dt); });
+			totalMs += ms;
+			maxFrameMs = std::max<double>(maxFrameMs, ms);
+			minUpdated = std::min<UINT>(minUpdated, crowd.UpdatedInstanceCount());
+			maxUpdated = std::max<UINT>(maxUpdated, crowd.UpdatedInstanceCount());
+		}
+		return totalMs;
+	};
+
+	UINT fullMin = 0, fullMax = 0, lodMin = 0, lodMax = 0;
+	double fullMaxFrameMs = 0.0, lodMaxFrameMs = 0.0;
+	double fullMs = run(false, fullMin, fullMax, fullMaxFrameMs);
+	double lodMs = run(true, lodMin, lodMax, lodMaxFrameMs);
+	double total = static_cast<double>(characters) * frames;
+
+	Benchmark::Report report(L"Animation LOD ");
+	report << characters << L" characters: full rate " << total / fullMs << L" characters/ms (slowest frame " <<
+		fullMaxFrameMs << L" ms), LOD " << total / lodMs << L" characters/ms (" << lodMin << L" ~ " << lodMax <<
+		L" updated per frame, slowest frame " << lodMaxFrameMs << L" ms)";
+	report.Print();
+}
+
+//지금 클립을 15, 30, 60Hz로 구워서 가까운 프레임을 쓸 때와 이웃 프레임을 보간할 때마다
+//표 크기, 병사 메쉬의 정점 오차(모델 공간, 병사 키는 약 74)와 재생 처리량(캐릭터/ms)을 출력 창에 찍는다.
+//처리량은 키를 샘플하고 계층을 이어 붙이는 원래 경로와 비교한다.
+void SkinnedMeshApp::RunBakedAnimationBenchmark()
+{
+	const UINT numBones = mSkinnedInfo.BoneCount();
+	const SkinnedData::ClipHandle clip = mSkinnedModelInst->Clip;
+	const float endTime = mSkinnedModelInst->ClipEndTime;
+	const float dt = 1.0f / 60.0f;
+	const int characters = 256;
+	const int frames = 16;
+
+	std::vector<XMFLOAT4X4> transforms(static_cast<size_t>(characters) * numBones);
+	std::vector<float> startTime(characters);
+	for (auto& t : startTime)
+		t = MathHelper::RandF(0.0f, endTime);
+	auto timeAt = [&](int c, int frame) { return fmodf(startTime[c] + frame * dt, endTime); };
+
+	//K로 표를 붙여 두었어도 원래 경로를 재도록 GetFinalTransforms 안의 단계를 직접 부른다.
+	const UINT cursorCount = mSkinnedInfo.KeyCursorCount();
+	std::vector<int> keyCursors(static_cast<size_t>(characters) * cursorCount, -1);
+	mSkinnedScratch.Reserve(numBones);
+	double liveMs = Benchmark::MeasureMs([&]() {
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (auto c : Range(0, characters))
+			{
+				clip->SamplePoses(timeAt(c, frame), &keyCursors[static_cast<size_t>(c) * cursorCount],
+					mSkinnedScratch.Poses.data());
+				SoaAnimationClip::BuildMatrices(mSkinnedScratch.Poses.data(), numBones, mSkinnedScratch.ToParent.data());
+				mSkinnedInfo.ConcatenateHierarchy(mSkinnedScratch.ToParent.data(),
+					&transforms[static_cast<size_t>(c) * numBones], mSkinnedScratch);
+			}
+		}});
+	double total = static_cast<double>(characters) * frames;
+
+	Benchmark::Report report(L"Baked animation ");
+	report << characters << L" characters: sampled clip " << total / liveMs << L" characters/ms";
+	for (float sampleRate : { 15.0f, 30.0f, 60.0f })
+	{
+		for (bool interpolate : { false, true })
+		{
+			AnimationBakeSettings settings;
+			settings.SampleRate = sampleRate;
+			settings.Interpolate = interpolate;
+			BakedAnimationClip baked;
+			AnimationBakeReport bake;
+			BakeAnimationClip(mSkinnedInfo, clip, settings, baked, &mSkinnedVertices, &bake);
+
+			double bakedMs = Benchmark::MeasureMs([&]() {
+				for (int frame = 0; frame < frames; ++frame)
+				{
+					for (auto c : Range(0, characters))
+						baked.Sample(timeAt(c, frame), &transforms[static_cast<size_t>(c) * numBones]);
+				}});
+
+			report << L"\n  " << baked.SampleRate() << (interpolate ? L" Hz lerp: " : L" Hz nearest: ") <<
+				bake.BakedBytes << L" bytes (keys " << bake.KeyBytes << L" bytes), max vertex error " <<
+				bake.MaxVertexError << L", mean " << bake.MeanVertexError << L", " << total / bakedMs <<
+				L" characters/ms (x" << liveMs / bakedMs << L")";
+		}
+	}
+	report.Print();
+}
+
+//뼈 수가 다른 가짜 골격을 만들어 1초에 계산하는 골격 수를 출력 창에 찍는다.
+//계층 단계만(XMMatrixMultiply로 4x4를 곱하고 전치하는 방식과 3x4로 이어 붙이는 방식)과 샘플링까지 모두 잰다.
+void SkinnedMeshApp::RunHierarchyBenchmark()
+{
+	auto RandomAffine = []() {
+		XMVECTOR S = XMVectorReplicate(MathHelper::RandF(0.8f, 1.2f));
+		XMVECTOR Q = XMQuaternionRotationRollPitchYaw(
+			MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f));
+		XMVECTOR T = XMVectorSet(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), 0.0f);
+		return XMMatrixAffineTransformation(S, XMVectorZero(), Q, T); };
+
+	const int skeletons = 256;
+	const int repeats = 8;
+	for (int numBones : { 60, 128, 256 })
+	{
+		std::vector<int> hierarchy(numBones, -1);
+		std::vector<XMFLOAT4X4> offsets(numBones);
+		AnimationClip clip;
+		clip.BoneAnimations.resize(numBones);
+		for (auto i : Range(0, numBones))
+		{
+			if (i > 0) hierarchy[i] = MathHelper::Rand(std::max<int>(0, i - 4), i - 1);
+			XMStoreFloat4x4(&offsets[i], RandomAffine());
+
+			for (auto k : Range(0, 30))
+			{
+				Keyframe key;
+				key.TimePos = k / 30.0f;
+				XMVECTOR S, Q, T;
+				XMMatrixDecompose(&S, &Q, &T, RandomAffine());
+				XMStoreFloat3(&key.Translation, T);
+				XMStoreFloat4(&key.RotationQuat, Q);
+				clip.BoneAnimations[i].Keyframes.push_back(key);
+			}
+		}
+		std::unordered_map<std::string, AnimationClip> animations{ { "Bench", clip } };
+		SkinnedData rig;
+		rig.Set(hierarchy, offsets, animations);
+
+		std::vector<XMFLOAT4X4> transforms(static_cast<size_t>(skeletons) * numBones);
+		std::vector<SkinnedData::PoseRequest> requests(skeletons);
+		for (auto c : Range(0, skeletons))
+		{
+			requests[c].Clip = rig.FindClip("Bench");
+			requests[c].TimePos = MathHelper::RandF(0.0f, 1.0f);
+			requests[c].FinalTransforms = &transforms[static_cast<size_t>(c) * numBones];
+		}
+
+		// 계층 단계의 입력. 4x4와 전치한 3x4 두 가지로 둔다.
+		std::vector<XMFLOAT4X4> toParent(numBones);
+		std::vector<XMFLOAT4X4> toRoot(numBones);
+		std::vector<Matrix3x4> toParentRows(numBones);
+		for (auto i : Range(0, numBones))
+		{
+			XMMATRIX M = RandomAffine();
+			XMStoreFloat4x4(&toParent[i], M);
+			M = XMMatrixTranspose(M);
+			for (auto r : Range(0, 3))
+				XMStoreFloat4A(&toParentRows[i].Rows[r], M.r[r]);
+		}
+
+		int n = 0;
+		double matrix4x4Ms = Benchmark::MeasureMs([&]() {
+			XMFLOAT4X4* finalTransforms = requests[n++ % skeletons].FinalTransforms;
+			toRoot[0] = toParent[0];
+			for (auto i : Range(1, numBones))
+				XMStoreFloat4x4(&toRoot[i], XMMatrixMultiply(XMLoadFloat4x4(&toParent[i]), XMLoadFloat4x4(&toRoot[hierarchy[i]])));
+			for (auto i : Range(0, numBones))
+				XMStoreFloat4x4(&finalTransforms[i],
+					XMMatrixTranspose(XMMatrixMultiply(XMLoadFloat4x4(&offsets[i]), XMLoadFloat4x4(&toRoot[i]))));
+		}, repeats * skeletons);
+		n = 0;
+		double matrix3x4Ms = Benchmark::MeasureMs([&]() {
+			rig.ConcatenateHierarchy(toParentRows.data(), requests[n++ % skeletons].FinalTransforms, mSkinnedScratch);
+		}, repeats * skeletons);
+		double sampledMs = Benchmark::MeasureMs([&]() {
+			rig.GetFinalTransforms(requests.data(), static_cast<UINT>(skeletons), mSkinnedScratch);
+		}, repeats);
+
+		double total = static_cast<double>(repeats) * skeletons;
+		auto perSecond = [total](double ms) { return total / ms * 1000.0; };
+
+		Benchmark::Report report(L"Skeleton hierarchy ");
+		report << numBones << L" bones: 4x4 " << perSecond(matrix4x4Ms) << L" skeletons/s, 3x4 " <<
+			perSecond(matrix3x4Ms) << L" skeletons/s, sampled + 3x4 " << perSecond(sampledMs) << L" skeletons/s";
+		report.Print();
+	}
+}
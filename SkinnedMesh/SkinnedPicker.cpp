@@ -0,0 +1,181 @@
+#include "SkinnedPicker.h"
+#include "../Common/Util.h"
+
+using namespace DirectX;
+
+namespace
+{
+	void GetWeights(const M3DLoader::SkinnedVertex& v, float weights[4])
+	{
+		weights[0] = v.BoneWeights.x;
+		weights[1] = v.BoneWeights.y;
+		weights[2] = v.BoneWeights.z;
+		weights[3] = 1.0f - weights[0] - weights[1] - weights[2];
+	}
+}
+
+void SkinnedPicker::Build(const std::vector<M3DLoader::SkinnedVertex>& vertices,
+	const std::vector<std::uint16_t>& indices, UINT boneCount)
+{
+	mVertices = vertices;
+	mIndices = indices;
+	mClusters.assign(boneCount, Cluster{});
+
+	mPalette.resize(boneCount);
+	mSkinnedPos.resize(vertices.size());
+	mSkinnedStamp.assign(vertices.size(), 0);
+	mStamp = 0;
+
+	UINT triCount = static_cast<UINT>(indices.size() / 3);
+	std::vector<float> boneWeightSum(boneCount);
+	for (auto tri : Range(0, triCount))
+	{
+		std::fill(boneWeightSum.begin(), boneWeightSum.end(), 0.0f);
+		for (auto k : Range(0, 3))
+		{
+			auto& v = vertices[indices[tri * 3 + k]];
+			float weights[4];
+			GetWeights(v, weights);
+			for (auto i : Range(0, 4))
+				boneWeightSum[v.BoneIndices[i]] += weights[i];
+		}
+
+		auto dominant = std::max_element(boneWeightSum.begin(), boneWeightSum.end()) - boneWeightSum.begin();
+		mClusters[dominant].Triangles.emplace_back(tri);
+	}
+
+	// 클러스터 정점이 참조하는 본마다 바인드 포즈 경계를 따로 잡는다.
+	// 스키닝된 위치는 sum(w_i * M_i * p)이므로 각 본 경계를 M_i로 옮긴 상자들의 합 안에 들어간다.
+	for (auto& cluster : mClusters)
+	{
+		std::unordered_map<UINT, std::pair<XMFLOAT3, XMFLOAT3>> bindMinMax;
+		for (auto tri : cluster.Triangles)
+		{
+			for (auto k : Range(0, 3))
+			{
+				auto& v = vertices[indices[tri * 3 + k]];
+				float weights[4];
+				GetWeights(v, weights);
+				XMVECTOR p = XMLoadFloat3(&v.Pos);
+				for (auto i : Range(0, 4))
+				{
+					if (weights[i] <= 0.0f)
+						continue;
+
+					auto iter = bindMinMax.find(v.BoneIndices[i]);
+					if (iter == bindMinMax.end())
+					{
+						bindMinMax.emplace(v.BoneIndices[i], std::make_pair(v.Pos, v.Pos));
+						continue;
+					}
+					XMStoreFloat3(&iter->second.first, XMVectorMin(XMLoadFloat3(&iter->second.first), p));
+					XMStoreFloat3(&iter->second.second, XMVectorMax(XMLoadFloat3(&iter->second.second), p));
+				}
+			}
+		}
+
+		for (auto& minMax : bindMinMax)
+		{
+			Influence influence;
+			influence.Bone = minMax.first;
+			BoundingBox::CreateFromPoints(influence.BindBounds,
+				XMLoadFloat3(&minMax.second.first), XMLoadFloat3(&minMax.second.second));
+			cluster.Influences.emplace_back(influence);
+		}
+	}
+
+	mClusters.erase(std::remove_if(mClusters.begin(), mClusters.end(),
+		[](const Cluster& c) { return c.Triangles.empty(); }), mClusters.end());
+	mCandidates.reserve(mClusters.size());
+}
+
+XMVECTOR SkinnedPicker::SkinnedPosition(UINT vertex)
+{
+	if (mSkinnedStamp[vertex] == mStamp)
+		return XMLoadFloat3(&mSkinnedPos[vertex]);
+
+	auto& v = mVertices[vertex];
+	float weights[4];
+	GetWeights(v, weights);
+
+	XMVECTOR bindPos = XMVectorSetW(XMLoadFloat3(&v.Pos), 1.0f);
+	XMVECTOR pos = XMVectorZero();
+	for (auto i : Range(0, 4))
+	{
+		if (weights[i] <= 0.0f)
+			continue;
+		XMMATRIX M = XMLoadFloat4x4(&mPalette[v.BoneIndices[i]]);
+		pos = XMVectorMultiplyAdd(XMVectorReplicate(weights[i]), XMVector3Transform(bindPos, M), pos);
+	}
+
+	XMStoreFloat3(&mSkinnedPos[vertex], pos);
+	mSkinnedStamp[vertex] = mStamp;
+	mLastSkinnedCount++;
+	return pos;
+}
+
+bool SkinnedPicker::Pick(const std::vector<XMFLOAT4X4>& finalTransforms,
+	FXMVECTOR rayOrigin, FXMVECTOR rayDir, float& tmin, UINT& triangle)
+{
+	// 스탬프가 한 바퀴 돌면 캐시를 비운다.
+	if (++mStamp == 0)
+	{
+		std::fill(mSkinnedStamp.begin(), mSkinnedStamp.end(), 0);
+		mStamp = 1;
+	}
+	mLastSkinnedCount = 0;
+
+	for (auto i : Range(0, static_cast<int>(mPalette.size())))
+		XMStoreFloat4x4(&mPalette[i], XMMatrixTranspose(XMLoadFloat4x4(&finalTransforms[i])));
+
+	mCandidates.clear();
+	for (auto c : Range(0, static_cast<int>(mClusters.size())))
+	{
+		auto& influences = mClusters[c].Influences;
+		BoundingBox bounds;
+		influences.front().BindBounds.Transform(bounds, XMLoadFloat4x4(&mPalette[influences.front().Bone]));
+		for (auto i : Range(1, static_cast<int>(influences.size())))
+		{
+			BoundingBox posed;
+			influences[i].BindBounds.Transform(posed, XMLoadFloat4x4(&mPalette[influences[i].Bone]));
+			BoundingBox::CreateMerged(bounds, bounds, posed);
+		}
+
+		float tEnter = 0.0f;
+		if (bounds.Intersects(rayOrigin, rayDir, tEnter))
+			mCandidates.push_back({ tEnter, static_cast<UINT>(c) });
+	}
+
+	std::sort(mCandidates.begin(), mCandidates.end(),
+		[](const Candidate& a, const Candidate& b) { return a.TEnter < b.TEnter; });
+
+	float closest = MathHelper::Infinity;
+	bool hit = false;
+	for (auto& candidate : mCandidates)
+	{
+		// 남은 클러스터는 이미 찾은 교점보다 멀리서 시작한다.
+		if (candidate.TEnter > closest)
+			break;
+
+		for (auto tri : mClusters[candidate.Cluster].Triangles)
+		{
+			XMVECTOR v0 = SkinnedPosition(mIndices[tri * 3 + 0]);
+			XMVECTOR v1 = SkinnedPosition(mIndices[tri * 3 + 1]);
+			XMVECTOR v2 = SkinnedPosition(mIndices[tri * 3 + 2]);
+
+			float t = 0.0f;
+			if (TriangleTests::Intersects(rayOrigin, rayDir, v0, v1, v2, t) == false)
+				continue;
+			if (t >= closest)
+				continue;
+
+			closest = t;
+			triangle = tri;
+			hit = true;
+		}
+	}
+
+	if (hit)
+		tmin = closest;
+	return hit;
+}
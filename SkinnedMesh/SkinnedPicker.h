@@ -0,0 +1,56 @@
+#pragma once
+
+#include "LoadM3d.h"
+
+// 애니메이션 중인 스키닝 메쉬를 CPU에서 피킹한다.
+// 삼각형을 가장 영향이 큰 본 기준으로 클러스터로 묶어 두고, 질의 때는 현재 본 팔레트로
+// 클러스터 경계만 갱신한다. 광선에 걸린 클러스터의 정점만 그때 스키닝하므로
+// 메쉬 전체를 매번 스키닝하지 않는다.
+class SkinnedPicker
+{
+public:
+	void Build(const std::vector<M3DLoader::SkinnedVertex>& vertices,
+		const std::vector<std::uint16_t>& indices, UINT boneCount);
+
+	// finalTransforms는 GetFinalTransforms의 결과(셰이더로 보내기 위해 전치된 상태)를 그대로 받는다.
+	// 광선은 모델 로컬 공간 기준이고 triangle은 인덱스 버퍼 기준 삼각형 번호이다.
+	bool Pick(const std::vector<DirectX::XMFLOAT4X4>& finalTransforms,
+		DirectX::FXMVECTOR rayOrigin, DirectX::FXMVECTOR rayDir, float& tmin, UINT& triangle);
+
+	UINT ClusterCount() const { return static_cast<UINT>(mClusters.size()); }
+	// 마지막 Pick에서 실제로 스키닝한 정점 수
+	UINT LastSkinnedVertexCount() const { return mLastSkinnedCount; }
+
+private:
+	struct Influence
+	{
+		UINT Bone = 0;
+		DirectX::BoundingBox BindBounds{};
+	};
+
+	struct Cluster
+	{
+		std::vector<UINT> Triangles;
+		std::vector<Influence> Influences;
+	};
+
+	struct Candidate
+	{
+		float TEnter = 0.0f;
+		UINT Cluster = 0;
+	};
+
+	DirectX::XMVECTOR SkinnedPosition(UINT vertex);
+
+private:
+	std::vector<M3DLoader::SkinnedVertex> mVertices;
+	std::vector<std::uint16_t> mIndices;
+	std::vector<Cluster> mClusters;
+
+	std::vector<DirectX::XMFLOAT4X4> mPalette;
+	std::vector<DirectX::XMFLOAT3> mSkinnedPos;
+	std::vector<UINT> mSkinnedStamp;
+	std::vector<Candidate> mCandidates;
+	UINT mStamp = 0;
+	UINT mLastSkinnedCount = 0;
+};
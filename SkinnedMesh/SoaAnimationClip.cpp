@@ -0,0 +1,243 @@
+#include "SoaAnimationClip.h"
+#include "SkinnedData.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	// 두 키의 쿼터니언 내적이 이보다 작으면(뼈가 약 36도 넘게 돌면) slerp로 보간한다.
+	// 그보다 가까운 키에서 nlerp와 slerp의 차이는 0.06도 아래다.
+	constexpr float NlerpMinDot = 0.95f;
+
+	float& Lane(XMFLOAT4A& v, unsigned lane) { return (&v.x)[lane]; }
+	float Lane(const XMFLOAT4A& v, unsigned lane) { return (&v.x)[lane]; }
+
+	XMVECTOR LoadQuaternion(const SoaTransform& key, unsigned lane)
+	{
+		return XMVectorSet(Lane(key.Qx, lane), Lane(key.Qy, lane), Lane(key.Qz, lane), Lane(key.Qw, lane));
+	}
+}
+
+void SoaTransform::SetLane(unsigned lane, FXMVECTOR T, FXMVECTOR Q, FXMVECTOR S)
+{
+	Lane(Tx, lane) = XMVectorGetX(T);
+	Lane(Ty, lane) = XMVectorGetY(T);
+	Lane(Tz, lane) = XMVectorGetZ(T);
+	Lane(Qx, lane) = XMVectorGetX(Q);
+	Lane(Qy, lane) = XMVectorGetY(Q);
+	Lane(Qz, lane) = XMVectorGetZ(Q);
+	Lane(Qw, lane) = XMVectorGetW(Q);
+	Lane(Sx, lane) = XMVectorGetX(S);
+	Lane(Sy, lane) = XMVectorGetY(S);
+	Lane(Sz, lane) = XMVectorGetZ(S);
+}
+
+void SoaAnimationClip::Build(const BoneAnimation* bones, unsigned boneCount)
+{
+	mBoneCount = boneCount;
+	mGroups.assign((boneCount + Lanes - 1) / Lanes, Group{});
+
+	for (unsigned g = 0; g < mGroups.size(); ++g)
+	{
+		Group& group = mGroups[g];
+		const unsigned first = g * Lanes;
+		const unsigned count = std::min<unsigned>(Lanes, boneCount - first);
+
+		// 묶음 안 뼈들의 키 시간을 합친다. 뼈마다 합친 시간에서 다시 샘플해도 구간 사이가 선형(회전은 같은
+		// 호 위의 slerp)이라 값이 바뀌지 않는다. 내보낸 클립은 대개 모든 뼈의 키 시간이 같아 늘어나지 않는다.
+		for (unsigned lane = 0; lane < count; ++lane)
+		{
+			for (const Keyframe& key : bones[first + lane].Keyframes)
+				group.Times.push_back(key.TimePos);
+		}
+		std::sort(group.Times.begin(), group.Times.end());
+		group.Times.erase(std::unique(group.Times.begin(), group.Times.end()), group.Times.end());
+		if (group.Times.empty())
+			group.Times.push_back(0.0f);
+
+		// 남는 레인은 단위 변환으로 채운다.
+		group.Keys.resize(group.Times.size());
+		for (size_t k = 0; k < group.Times.size(); ++k)
+		{
+			for (unsigned lane = 0; lane < Lanes; ++lane)
+			{
+				XMVECTOR T = XMVectorZero();
+				XMVECTOR Q = XMQuaternionIdentity();
+				XMVECTOR S = XMVectorSplatOne();
+				if (lane < count)
+					bones[first + lane].Sample(group.Times[k], T, Q, S);
+
+				// 이웃한 키의 쿼터니언을 같은 반구로 맞춰 두면 nlerp에서 부호를 따로 보지 않아도 된다.
+				if (k > 0 && XMVectorGetX(XMQuaternionDot(Q, LoadQuaternion(group.Keys[k - 1], lane))) < 0.0f)
+					Q = XMVectorNegate(Q);
+
+				group.Keys[k].SetLane(lane, T, Q, S);
+			}
+		}
+
+		group.SlerpMask.assign(std::max<size_t>(group.Times.size() - 1, 1), 0);
+		for (size_t k = 0; k + 1 < group.Times.size(); ++k)
+		{
+			for (unsigned lane = 0; lane < count; ++lane)
+			{
+				XMVECTOR q0 = LoadQuaternion(group.Keys[k], lane);
+				XMVECTOR q1 = LoadQuaternion(group.Keys[k + 1], lane);
+				if (XMVectorGetX(XMQuaternionDot(q0, q1)) < NlerpMinDot)
+					group.SlerpMask[k] |= static_cast<std::uint8_t>(1u << lane);
+			}
+		}
+	}
+}
+
+void SoaAnimationClip::Sample(float t, int* cursors, SoaTransform* poses) const
+{
+	for (unsigned g = 0; g < mGroups.size(); ++g)
+	{
+		const Group& group = mGroups[g];
+		const int last = static_cast<int>(group.Times.size()) - 1;
+
+		if (last == 0 || t <= group.Times.front())
+		{
+			poses[g] = group.Keys.front();
+			if (cursors != nullptr) cursors[g] = 0;
+			continue;
+		}
+		if (t >= group.Times.back())
+		{
+			poses[g] = group.Keys.back();
+			if (cursors != nullptr) cursors[g] = last - 1;
+			continue;
+		}
+
+		int k = FindKeySegment(group.Times.data(), last + 1, t, cursors != nullptr ? cursors[g] : -1);
+		if (cursors != nullptr) cursors[g] = k;
+
+		const float lerpPercent = (t - group.Times[k]) / (group.Times[k + 1] - group.Times[k]);
+		const XMVECTOR u = XMVectorReplicate(lerpPercent);
+		const SoaTransform& a = group.Keys[k];
+		const SoaTransform& b = group.Keys[k + 1];
+		SoaTransform& pose = poses[g];
+
+		auto Lerp = [&u](const XMFLOAT4A& x0, const XMFLOAT4A& x1) {
+			XMVECTOR v0 = XMLoadFloat4A(&x0);
+			return XMVectorMultiplyAdd(u, XMLoadFloat4A(&x1) - v0, v0); };
+
+		XMStoreFloat4A(&pose.Tx, Lerp(a.Tx, b.Tx));
+		XMStoreFloat4A(&pose.Ty, Lerp(a.Ty, b.Ty));
+		XMStoreFloat4A(&pose.Tz, Lerp(a.Tz, b.Tz));
+		XMStoreFloat4A(&pose.Sx, Lerp(a.Sx, b.Sx));
+		XMStoreFloat4A(&pose.Sy, Lerp(a.Sy, b.Sy));
+		XMStoreFloat4A(&pose.Sz, Lerp(a.Sz, b.Sz));
+
+		// nlerp: 네 뼈의 쿼터니언을 성분별로 보간하고 한꺼번에 정규화한다.
+		XMVECTOR qx = Lerp(a.Qx, b.Qx);
+		XMVECTOR qy = Lerp(a.Qy, b.Qy);
+		XMVECTOR qz = Lerp(a.Qz, b.Qz);
+		XMVECTOR qw = Lerp(a.Qw, b.Qw);
+		XMVECTOR invLength = XMVectorReciprocalSqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+		XMStoreFloat4A(&pose.Qx, qx * invLength);
+		XMStoreFloat4A(&pose.Qy, qy * invLength);
+		XMStoreFloat4A(&pose.Qz, qz * invLength);
+		XMStoreFloat4A(&pose.Qw, qw * invLength);
+
+		for (unsigned mask = group.SlerpMask[k], lane = 0; mask != 0; mask >>= 1, ++lane)
+		{
+			if ((mask & 1) == 0) continue;
+
+			XMVECTOR Q = XMQuaternionSlerp(LoadQuaternion(a, lane), LoadQuaternion(b, lane), lerpPercent);
+			Lane(pose.Qx, lane) = XMVectorGetX(Q);
+			Lane(pose.Qy, lane) = XMVectorGetY(Q);
+			Lane(pose.Qz, lane) = XMVectorGetZ(Q);
+			Lane(pose.Qw, lane) = XMVectorGetW(Q);
+		}
+	}
+}
+
+void SoaAnimationClip::BlendPoses(const SoaTransform* layer, const XMFLOAT4A* boneWeights, float weight,
+	unsigned groupCount, SoaTransform* poses)
+{
+	const XMVECTOR signMask = XMVectorReplicate(-0.0f);
+
+	for (unsigned g = 0; g < groupCount; ++g)
+	{
+		XMVECTOR u = XMVectorReplicate(weight);
+		if (boneWeights != nullptr)
+			u *= XMLoadFloat4A(&boneWeights[g]);
+		if (XMVector4Equal(u, XMVectorZero()))
+			continue;
+
+		const SoaTransform& b = layer[g];
+		SoaTransform& pose = poses[g];
+
+		auto Lerp = [&u](XMFLOAT4A& x0, const XMFLOAT4A& x1) {
+			XMVECTOR v0 = XMLoadFloat4A(&x0);
+			XMStoreFloat4A(&x0, XMVectorMultiplyAdd(u, XMLoadFloat4A(&x1) - v0, v0)); };
+
+		Lerp(pose.Tx, b.Tx);
+		Lerp(pose.Ty, b.Ty);
+		Lerp(pose.Tz, b.Tz);
+		Lerp(pose.Sx, b.Sx);
+		Lerp(pose.Sy, b.Sy);
+		Lerp(pose.Sz, b.Sz);
+
+		// 두 클립의 쿼터니언은 반구가 다를 수 있으므로 내적이 음수인 레인은 b의 부호를 뒤집는다.
+		XMVECTOR ax = XMLoadFloat4A(&pose.Qx), ay = XMLoadFloat4A(&pose.Qy);
+		XMVECTOR az = XMLoadFloat4A(&pose.Qz), aw = XMLoadFloat4A(&pose.Qw);
+		XMVECTOR bx = XMLoadFloat4A(&b.Qx), by = XMLoadFloat4A(&b.Qy);
+		XMVECTOR bz = XMLoadFloat4A(&b.Qz), bw = XMLoadFloat4A(&b.Qw);
+		XMVECTOR sign = XMVectorAndInt(ax * bx + ay * by + az * bz + aw * bw, signMask);
+		XMVECTOR qx = XMVectorMultiplyAdd(u, XMVectorXorInt(bx, sign) - ax, ax);
+		XMVECTOR qy = XMVectorMultiplyAdd(u, XMVectorXorInt(by, sign) - ay, ay);
+		XMVECTOR qz = XMVectorMultiplyAdd(u, XMVectorXorInt(bz, sign) - az, az);
+		XMVECTOR qw = XMVectorMultiplyAdd(u, XMVectorXorInt(bw, sign) - aw, aw);
+		XMVECTOR invLength = XMVectorReciprocalSqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+		XMStoreFloat4A(&pose.Qx, qx * invLength);
+		XMStoreFloat4A(&pose.Qy, qy * invLength);
+		XMStoreFloat4A(&pose.Qz, qz * invLength);
+		XMStoreFloat4A(&pose.Qw, qw * invLength);
+	}
+}
+
+void SoaAnimationClip::BuildMatrices(const SoaTransform* poses, unsigned boneCount, Matrix3x4* out)
+{
+	const XMVECTOR one = XMVectorSplatOne();
+
+	for (unsigned g = 0; g * Lanes < boneCount; ++g)
+	{
+		const SoaTransform& pose = poses[g];
+
+		// XMMatrixRotationQuaternion의 각 원소를 네 뼈에 대해 한 번에 구한다.
+		XMVECTOR x = XMLoadFloat4A(&pose.Qx);
+		XMVECTOR y = XMLoadFloat4A(&pose.Qy);
+		XMVECTOR z = XMLoadFloat4A(&pose.Qz);
+		XMVECTOR w = XMLoadFloat4A(&pose.Qw);
+		XMVECTOR x2 = x + x;
+		XMVECTOR y2 = y + y;
+		XMVECTOR z2 = z + z;
+		XMVECTOR xx = x * x2, yy = y * y2, zz = z * z2;
+		XMVECTOR xy = x * y2, xz = x * z2, yz = y * z2;
+		XMVECTOR wx = w * x2, wy = w * y2, wz = w * z2;
+
+		XMVECTOR sx = XMLoadFloat4A(&pose.Sx);
+		XMVECTOR sy = XMLoadFloat4A(&pose.Sy);
+		XMVECTOR sz = XMLoadFloat4A(&pose.Sz);
+
+		// 전치한 행렬의 행 i(원래 행렬의 열 i)를 성분별로 모은 뒤 전치하면 r[lane]이 그 뼈의 행 i가 된다.
+		XMMATRIX row0 = XMMatrixTranspose(XMMATRIX(
+			sx * (one - yy - zz), sy * (xy - wz), sz * (xz + wy), XMLoadFloat4A(&pose.Tx)));
+		XMMATRIX row1 = XMMatrixTranspose(XMMATRIX(
+			sx * (xy + wz), sy * (one - xx - zz), sz * (yz - wx), XMLoadFloat4A(&pose.Ty)));
+		XMMATRIX row2 = XMMatrixTranspose(XMMATRIX(
+			sx * (xz - wy), sy * (yz + wx), sz * (one - xx - yy), XMLoadFloat4A(&pose.Tz)));
+
+		const unsigned count = std::min<unsigned>(Lanes, boneCount - g * Lanes);
+		for (unsigned lane = 0; lane < count; ++lane)
+		{
+			Matrix3x4& m = out[g * Lanes + lane];
+			XMStoreFloat4A(&m.Rows[0], row0.r[lane]);
+			XMStoreFloat4A(&m.Rows[1], row1.r[lane]);
+			XMStoreFloat4A(&m.Rows[2], row2.r[lane]);
+		}
+	}
+}
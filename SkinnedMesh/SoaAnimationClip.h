@@ -0,0 +1,97 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct BoneAnimation;
+
+// 오름차순 키 시간 times(count개)에서 t를 감싸는 구간 [k, k + 1]의 k. 키가 하나뿐이면 0
+// cursor는 지난번 구간이고 앞으로 재생할 때는 몇 칸만 옮겨 보고, 멀리 건너뛰었거나 뒤로 갔거나
+// cursor가 음수면 이진 탐색한다. 시간은 float이 아니어도(양자화한 정수) 된다.
+template<typename Time>
+int FindKeySegment(const Time* times, int count, float t, int cursor)
+{
+	const int last = count - 1;
+	if (last <= 0)
+		return 0;
+
+	// 앞으로 재생하면 대개 같은 구간이거나 바로 다음 구간이다.
+	const int maxSteps = 4;
+	if (cursor >= 0 && cursor < last && times[cursor] <= t)
+	{
+		for (int step = 0; step < maxSteps; ++step, ++cursor)
+		{
+			if (cursor == last - 1 || t < times[cursor + 1])
+				return cursor;
+		}
+	}
+	else
+		cursor = 0;
+
+	// [cursor, last] 안에서 t보다 큰 첫 키를 찾는다. 그 앞 키가 구간의 시작이다.
+	const Time* upper = std::upper_bound(times + cursor, times + count, t,
+		[](float time, Time key) { return time < key; });
+	int segment = static_cast<int>(upper - times) - 1;
+	return std::min<int>(std::max<int>(segment, 0), last - 1);
+}
+
+// 아핀 행렬(마지막 열이 0, 0, 0, 1)을 전치해서 앞 세 행만 둔 것. 각 행의 w가 이동이다.
+// 행렬 곱을 행 세 개의 splat-곱하기-더하기로 할 수 있고 셰이더로 보낼 때 다시 전치하지 않아도 된다.
+struct Matrix3x4
+{
+	DirectX::XMFLOAT4A Rows[3];
+};
+
+// 뼈 네 개(한 묶음)의 이동, 회전, 크기. 성분마다 네 뼈의 값을 XMFLOAT4A 하나에 모은다.
+// 키 하나로도, 샘플한 포즈로도 쓴다.
+struct SoaTransform
+{
+	// 뼈 하나(lane번째)의 값을 쓴다.
+	void SetLane(unsigned lane, DirectX::FXMVECTOR T, DirectX::FXMVECTOR Q, DirectX::FXMVECTOR S);
+
+	DirectX::XMFLOAT4A Tx, Ty, Tz;
+	DirectX::XMFLOAT4A Qx, Qy, Qz, Qw;
+	DirectX::XMFLOAT4A Sx, Sy, Sz;
+};
+
+// AnimationClip을 뼈 네 개씩 묶어 SoA로 다시 담은 것. 한 묶음의 뼈는 키 시간을 합친 하나의 시간 축을
+// 쓰도록 다시 샘플해 두므로, 구간 찾기와 보간 비율 계산은 묶음마다 한 번이고 보간은 네 뼈를 한 번에 한다.
+// 회전은 정규화 선형 보간(nlerp)을 쓰고, 두 키가 많이 벌어져 오차가 커지는 구간만 slerp로 한다.
+// 행렬은 마지막(BuildMatrices)에만 만든다.
+class SoaAnimationClip
+{
+public:
+	static constexpr unsigned Lanes = 4;
+
+	void Build(const BoneAnimation* bones, unsigned boneCount);
+
+	bool Empty() const { return mGroups.empty(); }
+	unsigned BoneCount() const { return mBoneCount; }
+	unsigned GroupCount() const { return static_cast<unsigned>(mGroups.size()); }
+
+	// poses에 묶음마다 시간 t의 포즈를 쓴다. cursors는 묶음마다 하나(GroupCount()개, 처음엔 -1)이고
+	// nullptr이면 매번 이진 탐색한다.
+	void Sample(float t, int* cursors, SoaTransform* poses) const;
+
+	// 포즈에서 뼈 boneCount개의 행렬을 만든다. XMMatrixAffineTransformation(S, 0, Q, T)을 전치한 것과 같다.
+	static void BuildMatrices(const SoaTransform* poses, unsigned boneCount, Matrix3x4* out);
+
+	// poses를 layer 쪽으로 섞는다. 뼈마다 비율은 weight * boneWeights(묶음마다 네 뼈, nullptr이면 1)이다.
+	// 이동과 크기는 선형 보간, 회전은 같은 반구로 맞춘 nlerp이고 비율이 모두 0인 묶음은 건너뛴다.
+	static void BlendPoses(const SoaTransform* layer, const DirectX::XMFLOAT4A* boneWeights, float weight,
+		unsigned groupCount, SoaTransform* poses);
+
+private:
+	struct Group
+	{
+		std::vector<float> Times;
+		std::vector<SoaTransform> Keys;
+		// 구간 [k, k + 1]에서 slerp로 보간할 뼈(비트 = 레인)
+		std::vector<std::uint8_t> SlerpMask;
+	};
+
+	std::vector<Group> mGroups;
+	unsigned mBoneCount = 0;
+};
@@ -4,7 +4,8 @@
 #include "../Common/UploadBuffer.h"
 #include "FrameResource.h"
 #include "../Common/GeometryGenerator.h"
-#include "Waves.h"
+#include "../Common/Waves.h"
+#include "../Common/WaveVertexWriter.h"
 #include "SobelFilter.h"
 
 using Microsoft::WRL::ComPtr;
@@ -600,21 +601,16 @@ void SobelApp::UpdateWaves(const GameTimer& gt)
 	mWaves->Update(gt.DeltaTime());
 
 	// Update the wave vertex buffer with the new solution.
-	auto currWavesVB = mCurFrameRes->WavesVB.get();
-	for (int i = 0; i < mWaves->VertexCount(); ++i)
-	{
-		Vertex v;
-
-		v.Pos = mWaves->Position(i);
-		v.Normal = mWaves->Normal(i);
+	// 바뀐 행만 이 프레임 자원의 정점 버퍼에 바로 쓴다. 텍스처 좌표는 위치에서 [-w/2,w/2] --> [0,1]로 구한다.
+	WaveVertexFormat format;
+	format.Stride = sizeof(Vertex);
+	format.PositionOffset = offsetof(Vertex, Pos);
+	format.NormalOffset = offsetof(Vertex, Normal);
+	format.TexCOffset = offsetof(Vertex, TexC);
 
-		// Derive tex-coords from position by 
-		// mapping [-w/2,w/2] --> [0,1]
-		v.TexC.x = 0.5f + v.Pos.x / mWaves->Width();
-		v.TexC.y = 0.5f - v.Pos.z / mWaves->Depth();
-
-		currWavesVB->CopyData(i, v);
-	}
+	auto currWavesVB = mCurFrameRes->WavesVB.get();
+	mCurFrameRes->WavesRevision = mWaves->ExportVertices(
+		currWavesVB->MappedData(), format, mCurFrameRes->WavesRevision);
 
 	// Set the dynamic VB of the wave renderitem to the current frame VB.
 	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
@@ -9,7 +9,7 @@ struct ObjectConstants
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
     UINT     MaterialIndex = 0;
-    UINT     ObjPad0 = 0;
+    UINT     UseBakedAo = 0;
     UINT     ObjPad1 = 0;
     UINT     ObjPad2 = 0;
 };
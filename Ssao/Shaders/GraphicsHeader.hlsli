@@ -32,7 +32,7 @@ cbuffer ObjectCB : register(b0)
     float4x4 gWorld;
     float4x4 gTexTransform;
     uint gMaterialIndex;
-    uint gObjPad0;
+    uint gUseBakedAo;
     uint gObjPad1;
     uint gOpjPad2;
 };
@@ -80,8 +80,12 @@ float4 main(VertexOut pin) : SV_Target
     
     float3 toEyeW = normalize(gEyePosW - pin.PosW);
     
-    pin.SsaoPosH /= pin.SsaoPosH.w;
-    float ambientAccess = gSsaoMap.Sample(gsamLinearClamp, pin.SsaoPosH.xy, 0.0f).r;
+    float ambientAccess = pin.AmbientAccess;
+    if (gUseBakedAo == 0)
+    {
+        pin.SsaoPosH /= pin.SsaoPosH.w;
+        ambientAccess = gSsaoMap.Sample(gsamLinearClamp, pin.SsaoPosH.xy, 0.0f).r;
+    }
     
     float4 ambient = ambientAccess * gAmbientLight * diffuseAlbedo;
     float3 shadowFactor = float3(1.0f, 1.0f, 1.0f);
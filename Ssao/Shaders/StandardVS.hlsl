@@ -19,6 +19,7 @@ VertexOut main( VertexIn vin )
     vout.TexC = mul(texC, matData.MatTransform).xy;
     
     vout.ShadowPosH = mul(posW, gShadowTransform);
+    vout.AmbientAccess = vin.AmbientAccess;
 	
     return vout;
 }
@@ -4,6 +4,7 @@ struct VertexIn
     float3 NormalL : NORMAL;
     float2 TexC : TEXCOORD;
     float3 TangentU : TANGENT;
+    float AmbientAccess : AMBIENT;
 };
 
 struct VertexOut
@@ -15,4 +16,5 @@ struct VertexOut
     float3 NormalW : NORMAL;
     float3 TangentW : TANGENT;
     float2 TexC : TEXCOORD;
+    float AmbientAccess : AMBIENT;
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "../Common/GeometryGenerator.h"
 #include "ShadowMap.h"
 #include "Ssao.h"
+#include "../Common/AoBaker.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -50,6 +51,7 @@ bool SsaoApp::Initialize()
 	BuildSkullGeometry();
 	BuildMaterials();
 	BuildRenderItems();
+	BakeAmbientOcclusion();
 	BuildFrameResources();
 	BuildPSOs();
 
@@ -369,6 +371,11 @@ void SsaoApp::BuildShadersAndInputLayout()
 		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"TANGENT", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 	};
+
+	//구운 AO는 불투명 물체에만 있으므로 그 PSO만 1번 슬롯을 읽는다.
+	mBakedAoInputLayout = mInputLayout;
+	mBakedAoInputLayout.push_back(
+		{"AMBIENT", 0, DXGI_FORMAT_R32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
 }
 
 void SsaoApp::BuildShapeGeometry()
@@ -697,6 +704,54 @@ void SsaoApp::BuildRenderItems()
 	}
 }
 
+void SsaoApp::BakeAmbientOcclusion()
+{
+#if defined(DEBUG) || defined(_DEBUG)
+	float planeAo = 0.0f, enclosedAo = 0.0f;
+	bool aoCheck = AoBaker::SelfCheck(&planeAo, &enclosedAo);
+	std::wstring text = L"AO self check: open plane " + std::to_wstring(planeAo) +
+		L", enclosed " + std::to_wstring(enclosedAo) + (aoCheck ? L" (ok)\n" : L" (FAILED)\n");
+	::OutputDebugStringW(text.c_str());
+	assert(aoCheck);
+#endif
+
+	auto& opaqueRitems = mRitemLayer[RenderLayer::Opaque];
+
+	//장면의 불투명 물체는 모두 움직이지 않으므로 서로를 가리는 물체로 한 번에 넣는다.
+	AoBaker baker;
+	std::vector<XMFLOAT3> positions, normals;
+	std::vector<std::uint32_t> indices;
+	auto ExtractRitemMesh = [&](const RenderItem* ri, std::vector<XMFLOAT3>* outNormals) {
+		SubmeshGeometry submesh{ ri->IndexCount, ri->StartIndexLocation, ri->BaseVertexLocation };
+		return ri->Geo->ExtractSubmesh(submesh, positions, indices, outNormals, offsetof(Vertex, Normal)); };
+	for (auto ri : opaqueRitems)
+	{
+		ExtractRitemMesh(ri, nullptr);
+		baker.AddOccluder(positions, indices, XMLoadFloat4x4(&ri->World));
+	}
+	baker.Build();
+
+	AoBaker::Desc desc;
+	desc.SampleCount = 64;
+	desc.MaxDistance = 1.0f;
+	for (auto ri : opaqueRitems)
+	{
+		UINT firstVertex = ExtractRitemMesh(ri, &normals);
+		auto access = baker.Bake(positions, normals, XMLoadFloat4x4(&ri->World), desc);
+
+		//정점 버퍼와 같은 번호로 읽히도록 앞쪽을 채워서 BaseVertexLocation이 그대로 맞게 한다.
+		std::vector<float> stream(firstVertex, 1.0f);
+		stream.insert(stream.end(), access.begin(), access.end());
+
+		const UINT byteSize = static_cast<UINT>(stream.size() * sizeof(float));
+		ri->BakedAoGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
+			mCommandList.Get(), stream.data(), byteSize, ri->BakedAoUploader);
+		ri->BakedAoView.BufferLocation = ri->BakedAoGPU->GetGPUVirtualAddress();
+		ri->BakedAoView.SizeInBytes = byteSize;
+		ri->BakedAoView.StrideInBytes = sizeof(float);
+	}
+}
+
 void SsaoApp::BuildFrameResources()
 {
 	for (auto i : Range(0, gNumFrameResources))
@@ -733,10 +788,18 @@ void SsaoApp::MakeBaseDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
 
 void SsaoApp::MakeOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
 {
+	MakeOpaqueBakedAoDesc(inoutDesc);
 	inoutDesc->DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
 	inoutDesc->DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
 }
 
+//불투명 물체는 구운 AO(1번 슬롯)까지 읽는다. 구운 AO로 그릴 때는 노멀/깊이 패스가 없으므로
+//기본 깊이 테스트와 쓰기를 그대로 쓴다.
+void SsaoApp::MakeOpaqueBakedAoDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
+{
+	inoutDesc->InputLayout = { mBakedAoInputLayout.data(), (UINT)mBakedAoInputLayout.size() };
+}
+
 void SsaoApp::MakeShadowOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc)
 {
 	inoutDesc->RasterizerState.DepthBias = 100000;
@@ -804,6 +867,7 @@ void SsaoApp::MakePSOPipelineState(GraphicsPSO psoType)
 	switch (psoType)
 	{
 	case GraphicsPSO::Opaque:					MakeOpaqueDesc(&psoDesc);					break;
+	case GraphicsPSO::OpaqueBakedAo:		MakeOpaqueBakedAoDesc(&psoDesc);	break;
 	case GraphicsPSO::ShadowOpaque:		MakeShadowOpaqueDesc(&psoDesc);	break;
 	case GraphicsPSO::Debug:						MakeDebugDesc(&psoDesc);					break;
 	case GraphicsPSO::DrawNormals:			MakeDrawNormals(&psoDesc);				break;
@@ -835,6 +899,16 @@ void SsaoApp::OnResize()
 	}
 }
 
+void SsaoApp::SetUseBakedAo(bool useBakedAo)
+{
+	if (mUseBakedAo == useBakedAo)
+		return;
+
+	mUseBakedAo = useBakedAo;
+	for (auto ri : mRitemLayer[RenderLayer::Opaque])
+		ri->NumFramesDirty = gNumFrameResources;
+}
+
 void SsaoApp::OnKeyboardInput(const GameTimer& gt)
 {
 	const float dt = gt.DeltaTime();
@@ -843,7 +917,7 @@ void SsaoApp::OnKeyboardInput(const GameTimer& gt)
 	float walkSpeed = 0.0f;
 	float strafeSpeed = 0.0f;
 
-	std::vector<int> keyList{ 'W', 'S', 'D', 'A' };
+	std::vector<int> keyList{ 'W', 'S', 'D', 'A', '1', '2' };
 	for_each(keyList.begin(), keyList.end(), [&](int vKey) {
 		bool bPressed = GetAsyncKeyState(vKey) & 0x8000;
 		if (bPressed)
@@ -854,6 +928,8 @@ void SsaoApp::OnKeyboardInput(const GameTimer& gt)
 			case 'S':		walkSpeed += -speed;		break;
 			case 'D':		strafeSpeed += speed;		break;
 			case 'A':		strafeSpeed += -speed;		break;
+			case '1':		SetUseBakedAo(true);		break;
+			case '2':		SetUseBakedAo(false);		break;
 			}
 		}});
 	
@@ -885,6 +961,7 @@ void SsaoApp::UpdateObjectCBs(const GameTimer& gt)
 		StoreMatrix4x4(objConstants.World, e->World);
 		StoreMatrix4x4(objConstants.TexTransform, e->TexTransform);
 		objConstants.MaterialIndex = e->Mat->MatCBIndex;
+		objConstants.UseBakedAo = (mUseBakedAo && e->BakedAoGPU != nullptr) ? 1 : 0;
 
 		currObjectCB->CopyData(e->ObjCBIndex, objConstants);
 
@@ -1096,6 +1173,8 @@ void SsaoApp::DrawRenderItems(
 	for (auto& ri : ritems)
 	{
 		cmdList->IASetVertexBuffers(0, 1, &RvToLv(ri->Geo->VertexBufferView()));
+		if (ri->BakedAoGPU != nullptr)
+			cmdList->IASetVertexBuffers(1, 1, &ri->BakedAoView);
 		cmdList->IASetIndexBuffer(&RvToLv(ri->Geo->IndexBufferView()));
 		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
@@ -1180,10 +1259,14 @@ void SsaoApp::Draw(const GameTimer& gt)
 	mCommandList->SetGraphicsRootDescriptorTable(4, mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 
 	DrawSceneToShadowMap();
-	DrawNormalsAndDepth();
 
-	mCommandList->SetGraphicsRootSignature(mSsaoRootSignature.Get());
-	mSsao->ComputeSsao(mCommandList.Get(), mCurFrameRes, 3);
+	//구운 AO를 쓰면 정적인 물체뿐인 이 장면에서는 SSAO 계산과 그 입력인 노멀/깊이 패스를 건너뛴다.
+	if (mUseBakedAo == false)
+	{
+		DrawNormalsAndDepth();
+		mCommandList->SetGraphicsRootSignature(mSsaoRootSignature.Get());
+		mSsao->ComputeSsao(mCommandList.Get(), mCurFrameRes, 3);
+	}
 
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
 
@@ -1197,6 +1280,10 @@ void SsaoApp::Draw(const GameTimer& gt)
 		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET)));
 
 	mCommandList->ClearRenderTargetView(CurrentBackBufferView(), Colors::LightSteelBlue, 0, nullptr);
+	//노멀/깊이 패스를 건너뛰었으면 깊이는 여기서 지우고 불투명 물체가 직접 쓴다.
+	if (mUseBakedAo)
+		mCommandList->ClearDepthStencilView(DepthStencilView(),
+			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
 	mCommandList->OMSetRenderTargets(1, &RvToLv(CurrentBackBufferView()), true, &RvToLv(DepthStencilView()));
 
@@ -1213,11 +1300,15 @@ void SsaoApp::Draw(const GameTimer& gt)
 	//shadowTexDescriptor.Offset(mShadowMapHeapIndex, mCbvSrvUavDescriptorSize);
 	//mCommandList->SetGraphicsRootDescriptorTable(4, shadowTexDescriptor);
 
-	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Opaque].Get());
+	mCommandList->SetPipelineState(mPSOs[mUseBakedAo ? GraphicsPSO::OpaqueBakedAo : GraphicsPSO::Opaque].Get());
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Opaque]);
 
-	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Debug].Get());
-	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Debug]);
+	//구운 AO를 쓰면 SSAO 맵을 만들지 않으므로 그 맵을 보여 주는 디버그 사각형도 그리지 않는다.
+	if (mUseBakedAo == false)
+	{
+		mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Debug].Get());
+		DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Debug]);
+	}
 
 	mCommandList->SetPipelineState(mPSOs[GraphicsPSO::Sky].Get());
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[RenderLayer::Sky]);
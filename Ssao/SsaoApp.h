@@ -37,6 +37,11 @@ struct RenderItem
 	DirectX::BoundingSphere BSphere{};
 
 	bool Visible = true;
+
+	// 미리 구운 정점 AO 스트림(슬롯 1). 없으면 SSAO 맵을 쓴다.
+	Microsoft::WRL::ComPtr<ID3D12Resource> BakedAoGPU = nullptr;
+	Microsoft::WRL::ComPtr<ID3D12Resource> BakedAoUploader = nullptr;
+	D3D12_VERTEX_BUFFER_VIEW BakedAoView{};
 };
 
 enum class RenderLayer : int
@@ -50,6 +55,7 @@ enum class RenderLayer : int
 enum class GraphicsPSO : int
 {
 	Opaque = 0,
+	OpaqueBakedAo,
 	ShadowOpaque,
 	Debug,
 	DrawNormals,
@@ -62,6 +68,7 @@ enum class GraphicsPSO : int
 constexpr std::array<GraphicsPSO, static_cast<size_t>(GraphicsPSO::Count)> GraphicsPSO_ALL
 {
 	GraphicsPSO::Opaque,
+	GraphicsPSO::OpaqueBakedAo,
 	GraphicsPSO::ShadowOpaque,
 	GraphicsPSO::Debug,
 	GraphicsPSO::DrawNormals,
@@ -91,6 +98,7 @@ private:
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) override;
 
 	void OnKeyboardInput(const GameTimer& gt);
+	void SetUseBakedAo(bool useBakedAo);
 	void AnimateMaterials(const GameTimer& gt);
 	void UpdateObjectCBs(const GameTimer& gt);
 	void UpdateMaterialBuffer(const GameTimer& gt);
@@ -110,6 +118,7 @@ private:
 	void BuildMaterials();
 	void MakeBaseDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
+	void MakeOpaqueBakedAoDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeShadowOpaqueDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeDebugDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
 	void MakeDrawNormals(D3D12_GRAPHICS_PIPELINE_STATE_DESC* inoutDesc);
@@ -119,6 +128,7 @@ private:
 	void MakePSOPipelineState(GraphicsPSO psoType);
 	void BuildPSOs();
 	void BuildRenderItems();
+	void BakeAmbientOcclusion();
 	void DrawRenderItems(
 		ID3D12GraphicsCommandList* cmdList,
 		const std::vector<RenderItem*> ritems);
@@ -148,6 +158,7 @@ private:
 
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3DBlob>> mShaders;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mBakedAoInputLayout;
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
@@ -180,4 +191,6 @@ private:
 	POINT mLastMousePos;
 
 	Camera mCamera;
+
+	bool mUseBakedAo = false;
 };
@@ -9,7 +9,7 @@ FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCo
     PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
     ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
     MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
-    WavesVB = std::make_unique<UploadBuffer<Vertex>>(device, waveVertCount, false);
+    WavesVB = std::make_unique<UploadBuffer<WavesVertex>>(device, waveVertCount, false);
 }
 
 FrameResource::~FrameResource()
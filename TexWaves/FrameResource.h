@@ -38,6 +38,20 @@ struct Vertex
     DirectX::XMFLOAT2 TexC;
 };
 
+// 물결에서 매 프레임 바뀌는 것만 담은 정점. 높이는 half float, 법선은 윗반구 8면체 snorm8 두 개
+struct WavesVertex
+{
+    std::uint16_t Height;
+    std::int8_t Normal[2];
+};
+
+// 물결 격자에서 바뀌지 않는 x, z와 텍스처 좌표. 기본 힙에 한 번만 올린다.
+struct WavesGridVertex
+{
+    DirectX::XMFLOAT2 PosXZ;
+    DirectX::XMFLOAT2 TexC;
+};
+
 // Stores the resources needed for the CPU to build the command lists
 // for a frame.  
 struct FrameResource
@@ -58,7 +72,9 @@ public:
     std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
     std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
     std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
-    std::unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
+    std::unique_ptr<UploadBuffer<WavesVertex>> WavesVB = nullptr;
+    // WavesVB에 마지막으로 쓴 Waves::Revision. 0이면 아직 쓰지 않았다.
+    std::uint64_t WavesRevision = 0;
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
     UINT64 Fence = 0;
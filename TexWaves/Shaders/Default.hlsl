@@ -76,6 +76,15 @@ struct VertexIn
 	float2 TexC    : TEXCOORD;
 };
 
+// 물결 정점은 두 흐름으로 나눠 받는다. 0번은 바뀌지 않는 격자, 1번은 매 프레임 올리는 높이와 법선이다.
+struct WavesVertexIn
+{
+	float2 PosXZ   : POSITION;
+	float2 TexC    : TEXCOORD;
+	float  Height  : HEIGHT;
+	float2 OctN    : NORMAL;
+};
+
 struct VertexOut
 {
 	float4 PosH    : SV_POSITION;
@@ -105,6 +114,18 @@ VertexOut VS(VertexIn vin)
     return vout;
 }
 
+VertexOut WavesVS(WavesVertexIn vin)
+{
+	VertexIn v;
+	v.PosL = float3(vin.PosXZ.x, vin.Height, vin.PosXZ.y);
+
+	// 윗반구 8면체로 접은 법선을 편다.
+	v.NormalL = normalize(float3(vin.OctN.x, 1.0f - abs(vin.OctN.x) - abs(vin.OctN.y), vin.OctN.y));
+	v.TexC = vin.TexC;
+
+	return VS(v);
+}
+
 float4 PS(VertexOut pin) : SV_Target
 {
     float4 diffuseAlbedo = gDiffuseMap.Sample(gsamAnisotropicWrap, pin.TexC) * gDiffuseAlbedo;
@@ -5,7 +5,8 @@
 #include "../Common/GeometryGenerator.h"
 #include "FrameResource.h"
 #include "../Common/Util.h"
-#include "Waves.h"
+#include "../Common/Waves.h"
+#include "../Common/WaveVertexWriter.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -36,6 +37,7 @@ struct RenderItem
 enum class RenderLayer : int
 {
 	Opaque = 0,
+	Waves,
 	Count
 };
 
@@ -93,6 +95,7 @@ private:
 	ComPtr<ID3D12DescriptorHeap> mDescriptorHeap = nullptr;
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputElements;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mWavesInputElements;
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count]{};
@@ -101,6 +104,7 @@ private:
 	std::vector<std::unique_ptr<FrameResource>> mFrameResources;
 	ComPtr<ID3D12RootSignature> mRootSignature = nullptr;
 	ComPtr<ID3D12PipelineState> mOpaquePSOs = nullptr;
+	ComPtr<ID3D12PipelineState> mWavesPSO = nullptr;
 	FrameResource* mCurrFrameResource = nullptr;
 	int mCurrFrameResIndex = 0;
 
@@ -257,6 +261,7 @@ void TexWavesApp::BuildShadersAndInputLayout()
 {
 	mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "VS", "vs_5_0");
 	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "PS", "ps_5_0");
+	mShaders["wavesVS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "WavesVS", "vs_5_0");
 
 	mInputElements =
 	{
@@ -264,6 +269,15 @@ void TexWavesApp::BuildShadersAndInputLayout()
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 1, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 	};
+
+	//0번: 바뀌지 않는 격자(WavesGridVertex), 1번: 매 프레임 올리는 높이와 법선(WavesVertex)
+	mWavesInputElements =
+	{
+		{"POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+		{"HEIGHT", 0, DXGI_FORMAT_R16_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+		{"NORMAL", 0, DXGI_FORMAT_R8G8_SNORM, 1, 2, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+	};
 }
 
 float GetHillsHeight(float x, float z)
@@ -361,7 +375,7 @@ void TexWavesApp::BuildWavesGeometry()
 	}
 
 	UINT VertexCount = (UINT)mWaves->VertexCount();
-	UINT VertexByteSize = VertexCount * sizeof(Vertex);
+	UINT VertexByteSize = VertexCount * sizeof(WavesVertex);
 	UINT indexCount = (UINT)indices.size();
 	UINT indexByteSize = indexCount * sizeof(std::uint16_t);
 
@@ -379,10 +393,30 @@ void TexWavesApp::BuildWavesGeometry()
 	geoWater->DrawArgs["grid"] = smWater;
 	geoWater->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geoWater->IndexBufferByteSize = indexByteSize;
-	geoWater->VertexByteStride = sizeof(Vertex);
+	geoWater->VertexByteStride = sizeof(WavesVertex);
 	geoWater->VertexBufferByteSize = VertexByteSize;
 
 	mGeometries[geoWater->Name] = std::move(geoWater);
+
+	//x, z와 텍스처 좌표는 바뀌지 않으므로 기본 힙에 한 번만 올린다.
+	WaveVertexFormat gridFormat;
+	gridFormat.Stride = sizeof(WavesGridVertex);
+	gridFormat.PositionOffset = -1;
+	gridFormat.PositionXZOffset = offsetof(WavesGridVertex, PosXZ);
+	gridFormat.TexCOffset = offsetof(WavesGridVertex, TexC);
+
+	std::vector<WavesGridVertex> gridVertices(VertexCount);
+	mWaves->ExportVertices(gridVertices.data(), gridFormat);
+
+	UINT gridByteSize = VertexCount * sizeof(WavesGridVertex);
+	auto geoGrid = std::make_unique<MeshGeometry>();
+	geoGrid->Name = "waterGridGeo";
+	geoGrid->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
+		gridVertices.data(), gridByteSize, geoGrid->VertexBufferUploader);
+	geoGrid->VertexByteStride = sizeof(WavesGridVertex);
+	geoGrid->VertexBufferByteSize = gridByteSize;
+
+	mGeometries[geoGrid->Name] = std::move(geoGrid);
 }
 
 void TexWavesApp::BuildBoxGeometry()
@@ -450,7 +484,7 @@ void TexWavesApp::BuildRenderItems()
 
 	mWavesRitem = riWaves.get();
 
-	mRitemLayer[(int)RenderLayer::Opaque].emplace_back(riWaves.get());
+	mRitemLayer[(int)RenderLayer::Waves].emplace_back(riWaves.get());
 
 	auto& smLand = mGeometries["landGeo"]->DrawArgs["grid"];
 	auto riLand = std::make_unique<RenderItem>();
@@ -522,6 +556,15 @@ void TexWavesApp::BuildPSOs()
 	psoDesc.DSVFormat = mDepthStencilFormat;
 
 	md3dDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mOpaquePSOs));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC wavesPsoDesc = psoDesc;
+	wavesPsoDesc.InputLayout = { mWavesInputElements.data(), (UINT)mWavesInputElements.size() };
+	wavesPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(mShaders["wavesVS"]->GetBufferPointer()),
+		mShaders["wavesVS"]->GetBufferSize()
+	};
+	md3dDevice->CreateGraphicsPipelineState(&wavesPsoDesc, IID_PPV_ARGS(&mWavesPSO));
 }
 
 void TexWavesApp::OnResize()
@@ -669,21 +712,17 @@ void TexWavesApp::UpdateWaves(const GameTimer& gt)
 	mWaves->Update(gt.DeltaTime());
 
 	// Update the wave vertex buffer with the new solution.
-	auto currWavesVB = mCurrFrameResource->WavesVB.get();
-	for (int i = 0; i < mWaves->VertexCount(); ++i)
-	{
-		Vertex v;
-
-		v.Pos = mWaves->Position(i);
-		v.Normal = mWaves->Normal(i);
+	// 바뀐 행의 높이와 법선만 이 프레임 자원의 정점 버퍼에 바로 쓴다. 정점당 32바이트 대신 4바이트를 올린다.
+	// x, z와 텍스처 좌표는 BuildWavesGeometry에서 고정 격자로 한 번 올렸다.
+	WaveVertexFormat format;
+	format.Stride = sizeof(WavesVertex);
+	format.PositionOffset = -1;
+	format.HalfHeightOffset = offsetof(WavesVertex, Height);
+	format.OctNormalOffset = offsetof(WavesVertex, Normal);
 
-		// Derive tex-coords from position by 
-		// mapping [-w/2,w/2] --> [0,1]
-		v.TexC.x = 0.5f + v.Pos.x / mWaves->Width();
-		v.TexC.y = 0.5f - v.Pos.z / mWaves->Depth();
-
-		currWavesVB->CopyData(i, v);
-	}
+	auto currWavesVB = mCurrFrameResource->WavesVB.get();
+	mCurrFrameResource->WavesRevision = mWaves->ExportVertices(
+		currWavesVB->MappedData(), format, mCurrFrameResource->WavesRevision);
 
 	// Set the dynamic VB of the wave renderitem to the current frame VB.
 	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
@@ -771,6 +810,11 @@ void TexWavesApp::Draw(const GameTimer& gt)
 	
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
 
+	//물결은 고정 격자를 0번에, 이번 프레임의 높이와 법선을 1번에 물린다.
+	mCommandList->SetPipelineState(mWavesPSO.Get());
+	mCommandList->IASetVertexBuffers(0, 1, &RvToLv(mGeometries["waterGridGeo"]->VertexBufferView()));
+	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Waves]);
+
 	mCommandList->ResourceBarrier(1, &RvToLv(CD3DX12_RESOURCE_BARRIER::Transition(
 		CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET,
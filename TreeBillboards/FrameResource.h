@@ -68,6 +68,8 @@ public:
     // We cannot update a dynamic vertex buffer until the GPU is done processing
     // the commands that reference it.  So each frame needs their own.
     std::unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
+    // 물 조각마다 WavesVB에 마지막으로 쓴 WaveChunks::Chunk::Revision. 0이면 아직 쓰지 않았다.
+    std::vector<std::uint64_t> WaveChunkRevisions;
 
     // Fence value to mark commands up to this fence point.  This lets us
     // check if these frame resources are still in use by the GPU.
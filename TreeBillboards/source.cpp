@@ -4,7 +4,10 @@
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
 #include "FrameResource.h"
-#include "Waves.h"
+#include "../Common/Waves.h"
+#include "../Common/WaveChunks.h"
+#include "../Common/WaveVertexWriter.h"
+#include "../Common/TaskScheduler.h"
 #include "../Common/Util.h"
 
 using Microsoft::WRL::ComPtr;
@@ -121,6 +124,11 @@ private:
 private:
 	UINT mCbvSrvDescriptorSize = 0;
 	std::unique_ptr<Waves> mWaves;
+	//물은 조각으로 나눠 16비트 인덱스로 그리고, 보이는 조각만 정점을 채운다.
+	std::unique_ptr<WaveChunks> mWaveChunks;
+	std::vector<std::unique_ptr<RenderItem>> mWaveChunkRitems;
+	std::vector<UINT> mVisibleWaveChunks;
+	std::vector<UINT> mWaveChunksToWrite;
 
 private:
 	std::vector<std::unique_ptr<Texture>> mTextures;
@@ -175,7 +183,8 @@ bool TreeBillboardsApp::Initialize()
 
 	mCbvSrvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(
 		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	mWaves = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	mWaves = std::make_unique<Waves>(257, 257, 0.5f, 0.03f, 4.0f, 0.2f);
+	mWaveChunks = std::make_unique<WaveChunks>(mWaves->RowCount(), mWaves->ColumnCount(), mWaves->SpatialStep());
 
 	LoadTextures();
 	BuildRootSignature();
@@ -441,31 +450,9 @@ void TreeBillboardsApp::BuildLandGeometry()
 
 void TreeBillboardsApp::BuildWavesGeometry()
 {
-	std::vector<std::uint16_t> indices(3 * mWaves->TriangleCount()); // 3 indices per face
-	assert(mWaves->VertexCount() < 0x0000ffff);
-
-	// Iterate over each quad.
-	int m = mWaves->RowCount();
-	int n = mWaves->ColumnCount();
-	int k = 0;
-	for (int i = 0; i < m - 1; ++i)
-	{
-		for (int j = 0; j < n - 1; ++j)
-		{
-			indices[k] = i * n + j;
-			indices[k + 1] = i * n + j + 1;
-			indices[k + 2] = (i + 1) * n + j;
-
-			indices[k + 3] = (i + 1) * n + j;
-			indices[k + 4] = i * n + j + 1;
-			indices[k + 5] = (i + 1) * n + j + 1;
-
-			k += 6; // next quad
-		}
-	}
-
+	//조각 모양별 인덱스만 올리고, 조각은 BaseVertexLocation으로 같은 인덱스를 나눠 쓴다.
 	std::vector<Vertex> zero;
-	MakeGeometry("waterGeo", "grid", zero, indices);
+	MakeGeometry("waterGeo", "grid", zero, mWaveChunks->Indices());
 }
 
 void TreeBillboardsApp::BuildBoxGeometry()
@@ -672,6 +659,20 @@ void TreeBillboardsApp::BuildRenderItems()
 	auto iter = find_if(mAllRitems.begin(), mAllRitems.end(), [](auto& ri) { return ri->Geo->Name == "waterGeo"; });
 	if (iter != mAllRitems.end())
 		mWavesRitem = iter->get();
+
+	//물 렌더 아이템은 상수 버퍼만 쓰고, 실제로는 조각 아이템을 매 프레임 보이는 것만 층에 넣는다.
+	auto& transparent = mRitemLayer[RenderLayer::Transparent];
+	transparent.erase(std::remove(transparent.begin(), transparent.end(), mWavesRitem), transparent.end());
+	for (auto i : Range(0, (int)mWaveChunks->ChunkCount()))
+	{
+		auto ri = std::make_unique<RenderItem>(*mWavesRitem);
+		const auto& indexRange = mWaveChunks->GetIndexRange(i);
+		ri->IndexCount = indexRange.IndexCount;
+		ri->StartIndexLocation = indexRange.StartIndex;
+		ri->BaseVertexLocation = mWaveChunks->GetChunk(i).BaseVertex;
+		ri->NumFramesDirty = 0;
+		mWaveChunkRitems.emplace_back(std::move(ri));
+	}
 }
 
 void TreeBillboardsApp::BuildFrameResources()
@@ -679,7 +680,8 @@ void TreeBillboardsApp::BuildFrameResources()
 	for (auto i : Range(0, gNumFrameResources))
 	{
 		auto frameRes = std::make_unique<FrameResource>(md3dDevice.Get(), 1, (UINT)mAllRitems.size(),
-			(UINT)mMaterials.size(), (UINT)mWaves->VertexCount());
+			(UINT)mMaterials.size(), mWaveChunks->VertexCount());
+		frameRes->WaveChunkRevisions.assign(mWaveChunks->ChunkCount(), 0);
 		mFrameResources.emplace_back(std::move(frameRes));
 	}
 }
@@ -859,26 +861,53 @@ void TreeBillboardsApp::UpdateWaves(const GameTimer& gt)
 	// Update the wave simulation.
 	mWaves->Update(gt.DeltaTime());
 
+	//물의 월드 행렬이 단위 행렬이므로 월드 공간 절두체로 바로 조각을 고른다.
+	mWaveChunks->UpdateBounds(mWaves->Heights(), mWaves->RowRevisions());
+
+	XMMATRIX view = XMLoadFloat4x4(&mView);
+	XMMATRIX invView = XMMatrixInverse(&RvToLv(XMMatrixDeterminant(view)), view);
+	BoundingFrustum viewFrustum, worldFrustum;
+	BoundingFrustum::CreateFromMatrix(viewFrustum, XMLoadFloat4x4(&mProj));
+	viewFrustum.Transform(worldFrustum, invView);
+	mWaveChunks->Cull(worldFrustum, mVisibleWaveChunks);
+
 	// Update the wave vertex buffer with the new solution.
+	//보이는 조각 중 이 프레임 자원에 마지막으로 쓴 뒤로 바뀐 것만 업로드 버퍼의 자기 자리에 바로 쓴다.
+	//잠시 안 보였던 조각도 그동안 바뀌지 않았으면 예전에 쓴 정점이 그대로 남아 있다.
+	WaveVertexFormat format;
+	format.Stride = sizeof(Vertex);
+	format.PositionOffset = offsetof(Vertex, Pos);
+	format.NormalOffset = offsetof(Vertex, Normal);
+	format.TexCOffset = offsetof(Vertex, TexC);
+
 	auto currWavesVB = mCurFrameRes->WavesVB.get();
-	for (int i = 0; i < mWaves->VertexCount(); ++i)
+	auto vertices = reinterpret_cast<Vertex*>(currWavesVB->MappedData());
+	auto& chunkRevisions = mCurFrameRes->WaveChunkRevisions;
+	mWaveChunksToWrite.clear();
+	for (auto chunk : mVisibleWaveChunks)
 	{
-		Vertex v;
-
-		v.Pos = mWaves->Position(i);
-		v.Normal = mWaves->Normal(i);
-
-		// Derive tex-coords from position by 
-		// mapping [-w/2,w/2] --> [0,1]
-		v.TexC.x = 0.5f + v.Pos.x / mWaves->Width();
-		v.TexC.y = 0.5f - v.Pos.z / mWaves->Depth();
+		std::uint64_t revision = mWaveChunks->GetChunk(chunk).Revision;
+		if (revision <= chunkRevisions[chunk])
+			continue;
 
-		currWavesVB->CopyData(i, v);
+		chunkRevisions[chunk] = revision;
+		mWaveChunksToWrite.emplace_back(chunk);
 	}
+	ParallelFor(0, static_cast<int>(mWaveChunksToWrite.size()), [&](int k) {
+		const WaveChunks::Chunk& chunk = mWaveChunks->GetChunk(mWaveChunksToWrite[k]);
+		mWaves->ExportVertexRect(vertices + chunk.BaseVertex, format,
+			chunk.Row0, chunk.Row0 + chunk.Rows, chunk.Col0, chunk.Col0 + chunk.Cols);
+	}, 1);
+
+	auto& transparent = mRitemLayer[RenderLayer::Transparent];
+	transparent.erase(std::remove_if(transparent.begin(), transparent.end(),
+		[&](RenderItem* ri) { return ri->Geo == mWavesRitem->Geo; }), transparent.end());
+	for (auto chunk : mVisibleWaveChunks)
+		transparent.emplace_back(mWaveChunkRitems[chunk].get());
 
 	// Set the dynamic VB of the wave renderitem to the current frame VB.
 	mWavesRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
-	mWavesRitem->Geo->VertexBufferByteSize = (UINT)mWaves->VertexCount() * sizeof(Vertex);
+	mWavesRitem->Geo->VertexBufferByteSize = mWaveChunks->VertexCount() * sizeof(Vertex);
 	mWavesRitem->Geo->VertexByteStride = sizeof(Vertex);
 }
 
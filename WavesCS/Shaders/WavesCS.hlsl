@@ -19,6 +19,13 @@ void main( uint3 DTid : SV_DispatchThreadID )
     int x = DTid.x;
     int y = DTid.y;
 
+    // Only update interior points; we use zero boundary conditions.
+    // 테두리까지 갱신하면 범위 밖 읽기(0) 때문에 테두리가 움직여서 CPU Waves::Update와 달라진다.
+    uint width, height;
+    gOutput.GetDimensions(width, height);
+    if (x < 1 || y < 1 || x >= (int)width - 1 || y >= (int)height - 1)
+        return;
+
     gOutput[int2(x, y)] =
 	    mK1 * gPrevSolInput[int2(x, y)] +
 	    mK2 * gCurrSolInput[int2(x, y)] +
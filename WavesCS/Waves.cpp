@@ -3,7 +3,6 @@
 //***************************************************************************************
 
 #include "Waves.h"
-#include <ppl.h>
 #include <algorithm>
 #include <vector>
 #include <cassert>
@@ -12,6 +11,7 @@
 #include "../Common/d3dUtil.h"
 #include "../Common/Util.h"
 #include "../Common/GameTimer.h"
+#include "../Common/TaskScheduler.h"
 #include "DirectXMath.h"
 
 using namespace DirectX;
@@ -80,7 +80,7 @@ void Waves::Update(float dt)
 	if( t >= mTimeStep )
 	{
 		// Only update interior points; we use zero boundary conditions.
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
+		ParallelFor(1, mNumRows - 1, [this](int i)
 		//for(int i = 1; i < mNumRows-1; ++i)
 		{
 			for(int j = 1; j < mNumCols-1; ++j)
@@ -114,7 +114,7 @@ void Waves::Update(float dt)
 		//
 		// Compute normals using finite difference scheme.
 		//
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
+		ParallelFor(1, mNumRows - 1, [this](int i)
 		//for(int i = 1; i < mNumRows - 1; ++i)
 		{
 			for(int j = 1; j < mNumCols-1; ++j)
@@ -5,6 +5,9 @@
 #include "FrameResource.h"
 #include "../Common/GeometryGenerator.h"
 #include "Waves.h"
+#include "WavesCSReference.h"
+#include "../Common/Benchmark.h"
+#include <string>
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -471,6 +474,58 @@ void WavesCSApp::OnResize()
 
 void WavesCSApp::OnKeyboardInput(const GameTimer& gt)
 {
+	//B를 누를 때 한 번만 돌린다.
+	bool benchmarkKey = (GetAsyncKeyState('B') & 0x8000) != 0;
+	if (benchmarkKey && !mBenchmarkKeyDown)
+		RunReferenceBenchmark();
+	mBenchmarkKeyDown = benchmarkKey;
+}
+
+//격자 크기별로 WavesCS 커널을 CPU에서 그대로 돌린 결과를 CPU Waves::Update와 맞춰 보고
+//한 단계에 걸리는 시간을 출력 창에 찍는다. 두 쪽에 같은 곳을 같은 순서로 흔든다.
+void WavesCSApp::RunReferenceBenchmark()
+{
+	const float dt = 0.03f;
+	for (int size : { 128, 512, 1024 })
+	{
+		Waves cpu(nullptr, nullptr, size, size, 1.0f, dt, 4.0f, 0.2f);
+		WavesCSReference reference(size, size, 1.0f, dt, 4.0f, 0.2f);
+
+		const int steps = 64;
+		double cpuMs = 0.0;
+		double referenceMs = 0.0;
+		for (int step = 0; step < steps; ++step)
+		{
+			if (step % 8 == 0)
+			{
+				int i = MathHelper::Rand(4, size - 5);
+				int j = MathHelper::Rand(4, size - 5);
+				float r = MathHelper::RandF(0.2f, 0.5f);
+				cpu.Disturb(i, j, r);
+				reference.Disturb(i, j, r);
+			}
+
+			cpuMs += Benchmark::MeasureMs([&]() { cpu.Update(dt); });
+			referenceMs += Benchmark::MeasureMs([&]() { reference.Update(); });
+		}
+
+		float maxError = 0.0f;
+		float maxHeight = 0.0f;
+		for (auto i : Range(0, size))
+		{
+			for (auto j : Range(0, size))
+			{
+				float height = cpu.Position(i * size + j).y;
+				maxError = std::max<float>(maxError, fabsf(height - reference.Height(i, j)));
+				maxHeight = std::max<float>(maxHeight, fabsf(height));
+			}
+		}
+
+		Benchmark::Report report(L"WavesCS reference ");
+		report << size << L"x" << size << L": " << referenceMs / steps << L" ms/step, CPU Waves " <<
+			cpuMs / steps << L" ms/step, max |diff| " << maxError << L" (max |h| " << maxHeight << L")";
+		report.Print();
+	}
 }
 
 void WavesCSApp::UpdateCamera(const GameTimer& gt)
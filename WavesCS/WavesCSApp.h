@@ -112,6 +112,7 @@ private:
 
 private:
 	void MakeWavesCS(const GameTimer& gt);
+	void RunReferenceBenchmark();
 
 private:
 	std::unique_ptr<Waves> mWaves = nullptr;
@@ -145,5 +146,7 @@ private:
 	float mSunTheta = 1.25f * DirectX::XM_PI;
 	float mSunPhi = DirectX::XM_PIDIV4;
 
+	bool mBenchmarkKeyDown = false;
+
 	POINT mLastMousePos;
 };
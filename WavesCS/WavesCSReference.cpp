@@ -0,0 +1,89 @@
+#include "WavesCSReference.h"
+#include "../Common/TaskScheduler.h"
+#include <cassert>
+#include <utility>
+
+WavesCSReference::WavesCSReference(int m, int n, float dx, float dt, float speed, float damping)
+{
+	mNumRows = m;
+	mNumCols = n;
+
+	float d = damping*dt + 2.0f;
+	float e = (speed*speed)*(dt*dt) / (dx*dx);
+	mSetting.K1 = (damping*dt - 2.0f) / d;
+	mSetting.K2 = (4.0f - 8.0f*e) / d;
+	mSetting.K3 = (2.0f*e) / d;
+
+	// Waves::BuildWavesCSResource처럼 너비에 행 수, 높이에 열 수를 넣고 0으로 채운다.
+	for (Texture* texture : { &mPrevSolInput, &mCurrSolInput, &mOutput })
+	{
+		texture->Width = m;
+		texture->Height = n;
+		texture->Texels.assign(m*n, 0.0f);
+	}
+}
+
+template<typename Kernel>
+void WavesCSReference::Dispatch(int groupsX, int groupsY, int groupWidth, int groupHeight, Kernel&& kernel)
+{
+	TaskScheduler& scheduler = mScheduler ? *mScheduler : TaskScheduler::Default();
+	ParallelFor(scheduler, 0, groupsX*groupsY, [&](int group) {
+		int gx = group % groupsX;
+		int gy = group / groupsX;
+		for (int ty = 0; ty < groupHeight; ++ty)
+			for (int tx = 0; tx < groupWidth; ++tx)
+				kernel(gx*groupWidth + tx, gy*groupHeight + ty);
+	});
+}
+
+// main
+void WavesCSReference::WavesMain(int x, int y)
+{
+	if (x < 1 || y < 1 || x >= mOutput.Width - 1 || y >= mOutput.Height - 1)
+		return;
+
+	mOutput.Store(x, y,
+		mSetting.K1 * mPrevSolInput.Load(x, y) +
+		mSetting.K2 * mCurrSolInput.Load(x, y) +
+		mSetting.K3 * (mCurrSolInput.Load(x + 1, y) +
+			mCurrSolInput.Load(x - 1, y) +
+			mCurrSolInput.Load(x, y + 1) +
+			mCurrSolInput.Load(x, y - 1)));
+}
+
+// disturbCS
+void WavesCSReference::DisturbMain()
+{
+	const int row = mSetting.Row;
+	const int col = mSetting.Col;
+	float halfMag = 0.5f * mSetting.Magnitude;
+
+	mCurrSolInput.Store(row, col, mCurrSolInput.Load(row, col) + mSetting.Magnitude);
+	mCurrSolInput.Store(row, col + 1, mCurrSolInput.Load(row, col + 1) + halfMag);
+	mCurrSolInput.Store(row, col - 1, mCurrSolInput.Load(row, col - 1) + halfMag);
+	mCurrSolInput.Store(row + 1, col, mCurrSolInput.Load(row + 1, col) + halfMag);
+	mCurrSolInput.Store(row - 1, col, mCurrSolInput.Load(row - 1, col) + halfMag);
+}
+
+void WavesCSReference::Disturb(int row, int col, float magnitude)
+{
+	// Don't disturb boundaries.
+	assert(row > 1 && row < mNumRows - 2);
+	assert(col > 1 && col < mNumCols - 2);
+
+	mSetting.Row = row;
+	mSetting.Col = col;
+	mSetting.Magnitude = magnitude;
+	Dispatch(1, 1, 1, 1, [this](int, int) { DisturbMain(); });
+}
+
+void WavesCSReference::Update()
+{
+	int dispatchX = (mNumRows + GroupSize - 1) / GroupSize;
+	int dispatchY = (mNumCols + GroupSize - 1) / GroupSize;
+	Dispatch(dispatchX, dispatchY, GroupSize, GroupSize, [this](int x, int y) { WavesMain(x, y); });
+
+	// prev <- curr <- output <- prev
+	std::swap(mPrevSolInput, mCurrSolInput);
+	std::swap(mCurrSolInput, mOutput);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+
+class TaskScheduler;
+
+// Shaders/WavesCS.hlsl의 두 커널(main, disturbCS)을 CPU에서 같은 방식으로 돌리는 기준 구현.
+// GPU 없이 결과를 확인하고 CPU Waves::Update와 값과 속도를 비교하는 데 쓴다.
+// 스레드 그룹 타일(16x16, 1x1), 텍스처 모양(너비 = 행 수, 높이 = 열 수, 좌표 (행, 열)),
+// 범위 밖 읽기는 0이고 쓰기는 버려지는 UAV 규칙, 갱신 뒤 세 텍스처를 돌리는 순서까지 Waves와 같다.
+class WavesCSReference
+{
+public:
+	static constexpr int GroupSize = 16;	// main의 [numthreads(16, 16, 1)]
+
+	WavesCSReference(int m, int n, float dx, float dt, float speed, float damping);
+	WavesCSReference(const WavesCSReference& rhs) = delete;
+	WavesCSReference& operator=(const WavesCSReference& rhs) = delete;
+
+	int RowCount()const { return mNumRows; }
+	int ColumnCount()const { return mNumCols; }
+
+	// Waves::DisturbCS(row, col, magnitude)와 같다. Dispatch(1, 1, 1)
+	void Disturb(int row, int col, float magnitude);
+	// Waves::WavesUpdateCS와 같다. Dispatch(ceil(m / 16), ceil(n / 16), 1) 뒤 텍스처를 돌린다.
+	void Update();
+
+	// 현재 해(mCurrSolInput)의 높이
+	float Height(int row, int col)const { return mCurrSolInput.Load(row, col); }
+
+	// 스레드 그룹을 나눠 돌릴 스레드 풀. nullptr이면 TaskScheduler::Default()를 쓴다.
+	void SetScheduler(TaskScheduler* scheduler) { mScheduler = scheduler; }
+
+private:
+	// RWTexture2D<float>
+	struct Texture
+	{
+		int Width = 0;
+		int Height = 0;
+		std::vector<float> Texels;
+
+		float Load(int x, int y)const
+		{
+			if (x < 0 || y < 0 || x >= Width || y >= Height)
+				return 0.0f;
+			return Texels[y*Width + x];
+		}
+
+		void Store(int x, int y, float value)
+		{
+			if (x < 0 || y < 0 || x >= Width || y >= Height)
+				return;
+			Texels[y*Width + x] = value;
+		}
+	};
+
+	// cbuffer wavesSetting. Waves::SetComputeRoot가 넣는 루트 상수 6개
+	struct WavesSetting
+	{
+		float K1 = 0.0f;
+		float K2 = 0.0f;
+		float K3 = 0.0f;
+		int Row = 0;
+		int Col = 0;
+		float Magnitude = 0.0f;
+	};
+
+	// 그룹 (gx, gy)마다 스레드 (tx, ty)를 돌며 kernel(SV_DispatchThreadID)을 부른다. 그룹은 나란히 돈다.
+	template<typename Kernel>
+	void Dispatch(int groupsX, int groupsY, int groupWidth, int groupHeight, Kernel&& kernel);
+
+	void WavesMain(int x, int y);
+	void DisturbMain();
+
+private:
+	int mNumRows = 0;
+	int mNumCols = 0;
+
+	WavesSetting mSetting;
+	Texture mPrevSolInput;
+	Texture mCurrSolInput;
+	Texture mOutput;
+
+	TaskScheduler* mScheduler = nullptr;
+};